@@ -124,4 +124,29 @@ constexpr inline T in_range(T a, T upper)
 	return in_range(a, 0, upper);
 }
 
+inline int bitcount64(unsigned long long Mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(Mask);
+#else
+	int Count = 0;
+	for(; Mask; Mask &= Mask - 1)
+		Count++;
+	return Count;
+#endif
+}
+
+// index of the lowest set bit, the mask must not be 0
+inline int lowest_bit64(unsigned long long Mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(Mask);
+#else
+	int Index = 0;
+	for(; !(Mask & 1); Mask >>= 1)
+		Index++;
+	return Index;
+#endif
+}
+
 #endif // BASE_MATH_H
@@ -31,6 +31,7 @@
 #include <netinet/in.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 
 #include <dirent.h>
@@ -57,8 +58,10 @@
 #include <direct.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <io.h>
 #include <process.h>
 #include <shellapi.h>
+#include <signal.h>
 #include <wincrypt.h>
 #else
 #error NOT IMPLEMENTED
@@ -95,6 +98,400 @@ static NETSOCKET invalid_socket = {NETTYPE_INVALID, -1, -1};
 
 #define AF_WEBSOCKET_INET (0xee)
 
+/* the few atomic operations the log queue needs */
+#if defined(_MSC_VER)
+static unsigned atomic_load_u(volatile unsigned *p)
+{
+	return (unsigned)InterlockedCompareExchange((volatile LONG *)p, 0, 0);
+}
+static void atomic_store_u(volatile unsigned *p, unsigned v)
+{
+	InterlockedExchange((volatile LONG *)p, (LONG)v);
+}
+static unsigned atomic_exchange_u(volatile unsigned *p, unsigned v)
+{
+	return (unsigned)InterlockedExchange((volatile LONG *)p, (LONG)v);
+}
+static unsigned atomic_fetch_add_u(volatile unsigned *p, unsigned v)
+{
+	return (unsigned)InterlockedExchangeAdd((volatile LONG *)p, (LONG)v);
+}
+static int atomic_cas_u(volatile unsigned *p, unsigned expected, unsigned desired)
+{
+	return (unsigned)InterlockedCompareExchange((volatile LONG *)p, (LONG)desired, (LONG)expected) == expected;
+}
+static void *atomic_load_ptr(void *volatile *p)
+{
+	return InterlockedCompareExchangePointer(p, 0, 0);
+}
+static void atomic_store_ptr(void *volatile *p, void *v)
+{
+	InterlockedExchangePointer(p, v);
+}
+#else
+static unsigned atomic_load_u(volatile unsigned *p)
+{
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static void atomic_store_u(volatile unsigned *p, unsigned v)
+{
+	__atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+static unsigned atomic_exchange_u(volatile unsigned *p, unsigned v)
+{
+	return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+static unsigned atomic_fetch_add_u(volatile unsigned *p, unsigned v)
+{
+	return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+static int atomic_cas_u(volatile unsigned *p, unsigned expected, unsigned desired)
+{
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+static void *atomic_load_ptr(void *volatile *p)
+{
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static void atomic_store_ptr(void *volatile *p, void *v)
+{
+	__atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+#endif
+
+/*
+	dbg_msg() only formats the message into a queue of the calling thread,
+	a logger thread hands the lines to the loggers. Every thread owns one
+	ring buffer it writes to without taking a lock. When it is full, the
+	writer drops the oldest messages, so logging never blocks the caller.
+	The logger thread pops from the rings with a compare and swap of the
+	read position, which fails if the writer dropped the message meanwhile.
+*/
+enum
+{
+	LOG_RING_SIZE = 64 * 1024,
+	LOG_MAX_MESSAGE = 4 * 1024,
+
+	LOG_RING_ACTIVE = 0,
+	LOG_RING_ORPHANED, /* the thread exited, free once drained */
+	LOG_RING_FREE,
+};
+
+typedef struct
+{
+	unsigned size; /* of the whole record, padded */
+	unsigned seq;
+	time_t time;
+	unsigned sys_len;
+	unsigned msg_len;
+} LOG_RECORD;
+
+typedef struct LOG_RING
+{
+	volatile unsigned read;
+	volatile unsigned write;
+	volatile unsigned dropped;
+	volatile unsigned state;
+	struct LOG_RING *next;
+
+	/* only touched by the logger thread */
+	int staged;
+	union
+	{
+		LOG_RECORD record;
+		unsigned char data[sizeof(LOG_RECORD) + 64 + LOG_MAX_MESSAGE + 8];
+	} staged_record;
+
+	unsigned char buffer[LOG_RING_SIZE];
+} LOG_RING;
+
+static struct
+{
+	void *thread;
+	SEMAPHORE sphore;
+	LOCK drain_lock; /* held while handing lines to the loggers */
+	LOCK rings_lock; /* held while adding or reusing rings */
+	void *volatile rings;
+	volatile unsigned seq;
+	volatile unsigned sleeping;
+	volatile unsigned stop;
+	time_t last_time;
+	char last_timestr[80];
+#if defined(CONF_FAMILY_WINDOWS)
+	DWORD ring_key;
+#else
+	pthread_key_t ring_key;
+#endif
+} log_queue = {0};
+
+static void log_ring_read(const LOG_RING *ring, unsigned pos, void *dest, unsigned size)
+{
+	unsigned offset = pos % LOG_RING_SIZE;
+	unsigned first = size < LOG_RING_SIZE - offset ? size : LOG_RING_SIZE - offset;
+	mem_copy(dest, ring->buffer + offset, first);
+	mem_copy((unsigned char *)dest + first, ring->buffer, size - first);
+}
+
+static void log_ring_write(LOG_RING *ring, unsigned pos, const void *src, unsigned size)
+{
+	unsigned offset = pos % LOG_RING_SIZE;
+	unsigned first = size < LOG_RING_SIZE - offset ? size : LOG_RING_SIZE - offset;
+	mem_copy(ring->buffer + offset, src, first);
+	mem_copy(ring->buffer, (const unsigned char *)src + first, size - first);
+}
+
+#if defined(CONF_FAMILY_WINDOWS)
+static void WINAPI log_ring_orphan(void *user)
+#else
+static void log_ring_orphan(void *user)
+#endif
+{
+	LOG_RING *ring = user;
+	if(ring)
+		atomic_store_u(&ring->state, LOG_RING_ORPHANED);
+}
+
+static LOG_RING *log_thread_ring(void)
+{
+	LOG_RING *ring;
+#if defined(CONF_FAMILY_WINDOWS)
+	ring = FlsGetValue(log_queue.ring_key);
+#else
+	ring = pthread_getspecific(log_queue.ring_key);
+#endif
+	if(ring)
+		return ring;
+
+	/* reuse the ring of a thread that exited */
+	lock_wait(log_queue.rings_lock);
+	for(ring = atomic_load_ptr(&log_queue.rings); ring; ring = ring->next)
+	{
+		if(atomic_cas_u(&ring->state, LOG_RING_FREE, LOG_RING_ACTIVE))
+			break;
+	}
+	if(!ring)
+	{
+		ring = calloc(1, sizeof(*ring));
+		if(ring)
+		{
+			ring->next = atomic_load_ptr(&log_queue.rings);
+			atomic_store_ptr(&log_queue.rings, ring);
+		}
+	}
+	lock_unlock(log_queue.rings_lock);
+
+	if(ring)
+	{
+#if defined(CONF_FAMILY_WINDOWS)
+		FlsSetValue(log_queue.ring_key, ring);
+#else
+		pthread_setspecific(log_queue.ring_key, ring);
+#endif
+	}
+	return ring;
+}
+
+static int log_ring_push(LOG_RING *ring, const char *sys, unsigned sys_len, const char *msg, unsigned msg_len)
+{
+	LOG_RECORD record;
+	unsigned write = ring->write;
+
+	record.size = (sizeof(record) + sys_len + 1 + msg_len + 1 + 7) & ~7u;
+	record.seq = atomic_fetch_add_u(&log_queue.seq, 1);
+	record.time = time(0);
+	record.sys_len = sys_len;
+	record.msg_len = msg_len;
+
+	/* drop the oldest messages until this one fits */
+	while(1)
+	{
+		unsigned read = atomic_load_u(&ring->read);
+		LOG_RECORD oldest;
+		if(write + record.size - read <= LOG_RING_SIZE)
+			break;
+		log_ring_read(ring, read, &oldest, sizeof(oldest));
+		if(atomic_cas_u(&ring->read, read, read + oldest.size))
+			atomic_fetch_add_u(&ring->dropped, 1);
+	}
+
+	log_ring_write(ring, write, &record, sizeof(record));
+	log_ring_write(ring, write + sizeof(record), sys, sys_len + 1);
+	log_ring_write(ring, write + sizeof(record) + sys_len + 1, msg, msg_len + 1);
+	atomic_store_u(&ring->write, write + record.size);
+	return atomic_exchange_u(&log_queue.sleeping, 0);
+}
+
+static int log_ring_pop(LOG_RING *ring)
+{
+	while(1)
+	{
+		unsigned read = atomic_load_u(&ring->read);
+		unsigned write = atomic_load_u(&ring->write);
+		LOG_RECORD record;
+		if(read == write)
+			return 0;
+
+		/* the writer may be overwriting this, only the compare and swap
+		   tells whether the copy is intact */
+		log_ring_read(ring, read, &record, sizeof(record));
+		if(record.size < sizeof(record) || record.size > sizeof(ring->staged_record.data) || record.size > write - read)
+			continue;
+		log_ring_read(ring, read, ring->staged_record.data, record.size);
+		if(atomic_cas_u(&ring->read, read, read + record.size))
+			return 1;
+	}
+}
+
+static void log_emit(time_t time_data, const char *sys, const char *msg)
+{
+	char str[sizeof(log_queue.last_timestr) + LOG_MAX_MESSAGE + 64];
+	int i;
+	if(time_data != log_queue.last_time || !log_queue.last_timestr[0])
+	{
+		log_queue.last_time = time_data;
+		str_timestamp_ex(time_data, log_queue.last_timestr, sizeof(log_queue.last_timestr), FORMAT_SPACE);
+	}
+	str_format(str, sizeof(str), "[%s][%s]: %s", log_queue.last_timestr, sys, msg);
+	for(i = 0; i < num_loggers; i++)
+		loggers[i].logger(str, loggers[i].user);
+}
+
+/* hands everything queued to the loggers, oldest first */
+static int log_drain(void) REQUIRES(log_queue.drain_lock)
+{
+	int count = 0;
+	while(1)
+	{
+		LOG_RING *ring;
+		LOG_RING *oldest = 0;
+		const LOG_RECORD *record;
+		const LOG_RECORD *oldest_record = 0;
+		unsigned dropped;
+
+		for(ring = atomic_load_ptr(&log_queue.rings); ring; ring = ring->next)
+		{
+			if(!ring->staged)
+				ring->staged = log_ring_pop(ring);
+			if(!ring->staged)
+			{
+				if(atomic_load_u(&ring->state) == LOG_RING_ORPHANED && atomic_load_u(&ring->read) == atomic_load_u(&ring->write))
+					atomic_cas_u(&ring->state, LOG_RING_ORPHANED, LOG_RING_FREE);
+				continue;
+			}
+			record = &ring->staged_record.record;
+			if(!oldest_record || (int)(record->seq - oldest_record->seq) < 0)
+			{
+				oldest = ring;
+				oldest_record = record;
+			}
+		}
+		if(!oldest)
+			return count;
+
+		dropped = atomic_exchange_u(&oldest->dropped, 0);
+		if(dropped)
+		{
+			char aBuf[64];
+			str_format(aBuf, sizeof(aBuf), "dropped %u messages", dropped);
+			log_emit(oldest_record->time, "dbg/logger", aBuf);
+		}
+		log_emit(oldest_record->time, (const char *)(oldest_record + 1), (const char *)(oldest_record + 1) + oldest_record->sys_len + 1);
+		oldest->staged = 0;
+		count++;
+	}
+}
+
+static void log_thread(void *user)
+{
+	(void)user;
+	while(1)
+	{
+		int count;
+		lock_wait(log_queue.drain_lock);
+		count = log_drain();
+		lock_unlock(log_queue.drain_lock);
+		if(atomic_load_u(&log_queue.stop))
+			break;
+		if(count)
+			continue;
+
+		/* check once more after announcing the sleep, a message pushed in
+		   between would otherwise wait for the next one */
+		atomic_store_u(&log_queue.sleeping, 1);
+		lock_wait(log_queue.drain_lock);
+		count = log_drain();
+		lock_unlock(log_queue.drain_lock);
+		if(count && atomic_exchange_u(&log_queue.sleeping, 0))
+			continue;
+		sphore_wait(&log_queue.sphore);
+	}
+}
+
+static const int log_crash_signals[] = {
+	SIGSEGV,
+	SIGABRT,
+	SIGILL,
+	SIGFPE,
+#if defined(SIGBUS)
+	SIGBUS,
+#endif
+};
+
+/* writes out what is still queued when the process crashes, then crashes
+   with the default handler */
+static void log_crash_handler(int sig)
+{
+	int i;
+#if defined(CONF_FAMILY_UNIX)
+	/* the loggers wait for their writer threads, don't hang if one of
+	   them crashed */
+	alarm(5);
+#endif
+	/* don't wait for the lock, this may be the logger thread itself. it
+	   stays locked so nothing uses the finished loggers anymore */
+	if(lock_trylock(log_queue.drain_lock) == 0)
+	{
+		log_drain();
+		for(i = 0; i < num_loggers; i++)
+		{
+			if(loggers[i].finish)
+				loggers[i].finish(loggers[i].user);
+		}
+		num_loggers = 0;
+	}
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+static void log_queue_init(void)
+{
+	unsigned i;
+
+	log_queue.drain_lock = lock_create();
+	log_queue.rings_lock = lock_create();
+	sphore_init(&log_queue.sphore);
+#if defined(CONF_FAMILY_WINDOWS)
+	log_queue.ring_key = FlsAlloc(log_ring_orphan);
+	if(log_queue.ring_key == FLS_OUT_OF_INDEXES)
+		return;
+#else
+	if(pthread_key_create(&log_queue.ring_key, log_ring_orphan) != 0)
+		return;
+#endif
+	log_queue.thread = thread_init(log_thread, 0, "logger");
+	for(i = 0; i < sizeof(log_crash_signals) / sizeof(log_crash_signals[0]); i++)
+		signal(log_crash_signals[i], log_crash_handler);
+}
+
+void dbg_logger_flush(void)
+{
+	if(!log_queue.drain_lock)
+		return;
+	lock_wait(log_queue.drain_lock);
+	log_drain();
+	lock_unlock(log_queue.drain_lock);
+}
+
 void dbg_assert_imp(const char *filename, int line, int test, const char *msg)
 {
 	if(!test)
@@ -106,6 +503,12 @@ void dbg_assert_imp(const char *filename, int line, int test, const char *msg)
 
 void dbg_break_imp(void)
 {
+	/* don't wait for the lock, this may be the logger thread itself */
+	if(log_queue.drain_lock && lock_trylock(log_queue.drain_lock) == 0)
+	{
+		log_drain();
+		lock_unlock(log_queue.drain_lock);
+	}
 #ifdef __GNUC__
 	__builtin_trap();
 #else
@@ -116,30 +519,40 @@ void dbg_break_imp(void)
 void dbg_msg(const char *sys, const char *fmt, ...)
 {
 	va_list args;
-	char *msg;
+	char msg[LOG_MAX_MESSAGE];
 	int len;
+	LOG_RING *ring;
 
-	char str[1024 * 4];
-	int i;
-
-	char timestr[80];
-	str_timestamp_format(timestr, sizeof(timestr), FORMAT_SPACE);
-
-	str_format(str, sizeof(str), "[%s][%s]: ", timestr, sys);
-
-	len = strlen(str);
-	msg = (char *)str + len;
+	if(num_loggers == 0)
+		return;
 
 	va_start(args, fmt);
 #if defined(CONF_FAMILY_WINDOWS)
-	_vsnprintf(msg, sizeof(str) - len, fmt, args);
+	len = _vsnprintf(msg, sizeof(msg), fmt, args);
 #else
-	vsnprintf(msg, sizeof(str) - len, fmt, args);
+	len = vsnprintf(msg, sizeof(msg), fmt, args);
 #endif
 	va_end(args);
+	msg[sizeof(msg) - 1] = 0;
+	if(len < 0 || len >= (int)sizeof(msg))
+		len = strlen(msg);
 
-	for(i = 0; i < num_loggers; i++)
-		loggers[i].logger(str, loggers[i].user);
+	ring = log_queue.thread && !atomic_load_u(&log_queue.stop) ? log_thread_ring() : 0;
+	if(ring)
+	{
+		unsigned sys_len = str_length(sys) < 63 ? str_length(sys) : 63;
+		char sys_buf[64];
+		str_copy(sys_buf, sys, sys_len + 1);
+		if(log_ring_push(ring, sys_buf, sys_len, msg, len))
+			sphore_signal(&log_queue.sphore);
+	}
+	else if(log_queue.drain_lock)
+	{
+		/* without the logger thread, e.g. while shutting down */
+		lock_wait(log_queue.drain_lock);
+		log_emit(time(0), sys, msg);
+		lock_unlock(log_queue.drain_lock);
+	}
 }
 
 #if defined(CONF_FAMILY_WINDOWS)
@@ -215,6 +628,16 @@ static void logger_file_finish(void *user)
 static void dbg_logger_finish(void)
 {
 	int i;
+	if(log_queue.thread)
+	{
+		atomic_store_u(&log_queue.stop, 1);
+		sphore_signal(&log_queue.sphore);
+		thread_wait(log_queue.thread);
+		log_queue.thread = 0;
+	}
+
+	lock_wait(log_queue.drain_lock);
+	log_drain();
 	for(i = 0; i < num_loggers; i++)
 	{
 		if(loggers[i].finish)
@@ -222,20 +645,25 @@ static void dbg_logger_finish(void)
 			loggers[i].finish(loggers[i].user);
 		}
 	}
+	num_loggers = 0;
+	lock_unlock(log_queue.drain_lock);
 }
 
 void dbg_logger(DBG_LOGGER logger, DBG_LOGGER_FINISH finish, void *user)
 {
 	DBG_LOGGER_DATA data;
-	if(num_loggers == 0)
+	if(!log_queue.drain_lock)
 	{
+		log_queue_init();
 		atexit(dbg_logger_finish);
 	}
 	data.logger = logger;
 	data.finish = finish;
 	data.user = user;
+	lock_wait(log_queue.drain_lock);
 	loggers[num_loggers] = data;
 	num_loggers++;
+	lock_unlock(log_queue.drain_lock);
 }
 
 void dbg_logger_stdout(void)
@@ -366,6 +794,55 @@ int io_flush(IOHANDLE io)
 	return fflush((FILE *)io);
 }
 
+void *io_map(IOHANDLE io, unsigned *size)
+{
+	*size = 0;
+#if defined(CONF_FAMILY_WINDOWS)
+	{
+		HANDLE file = (HANDLE)_get_osfhandle(_fileno((FILE *)io));
+		LARGE_INTEGER length;
+		HANDLE mapping;
+		void *data;
+		if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &length) || length.QuadPart <= 0 || length.QuadPart > 0x7fffffff)
+			return 0;
+		mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if(!mapping)
+			return 0;
+		data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		/* the view keeps the mapping alive */
+		CloseHandle(mapping);
+		if(!data)
+			return 0;
+		*size = (unsigned)length.QuadPart;
+		return data;
+	}
+#else
+	{
+		struct stat st;
+		void *data;
+		int fd = fileno((FILE *)io);
+		if(fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > 0x7fffffff)
+			return 0;
+		data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED)
+			return 0;
+		*size = (unsigned)st.st_size;
+		return data;
+	}
+#endif
+}
+
+void io_unmap(void *data, unsigned size)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
 #define ASYNC_BUFSIZE 8 * 1024
 #define ASYNC_LOCAL_BUFSIZE 64 * 1024
 
@@ -309,6 +309,36 @@ int io_close(IOHANDLE io);
 */
 int io_flush(IOHANDLE io);
 
+/*
+	Function: io_map
+		Maps the whole file into memory. Processes mapping the same file
+		share its pages. Writes to the mapping are private to the process
+		and never reach the file.
+
+	Parameters:
+		io - Handle to the file.
+		size - Receives the size of the mapping.
+
+	Returns:
+		Returns the start of the mapping, NULL on error or if the file is
+		empty.
+
+	Remarks:
+		The mapping stays valid after the file is closed, it has to be
+		released with <io_unmap>.
+*/
+void *io_map(IOHANDLE io, unsigned *size);
+
+/*
+	Function: io_unmap
+		Releases a mapping created by <io_map>.
+
+	Parameters:
+		data - Start of the mapping.
+		size - Size of the mapping.
+*/
+void io_unmap(void *data, unsigned size);
+
 /*
 	Function: io_error
 		Checks whether an error occurred during I/O with the file.
@@ -1825,6 +1855,18 @@ void dbg_logger_stdout(void);
 void dbg_logger_debugger(void);
 void dbg_logger_file(const char *filename);
 
+/*
+	Function: dbg_logger_flush
+		Hands all queued messages to the loggers before returning.
+
+	Remarks:
+		<dbg_msg> only queues the message, the loggers get it on a
+		separate thread. The queue is flushed on exit, in <dbg_break> and
+		when the process crashes with SIGSEGV, SIGABRT, SIGILL, SIGFPE or
+		SIGBUS.
+*/
+void dbg_logger_flush(void);
+
 typedef struct
 {
 	int sent_packets;
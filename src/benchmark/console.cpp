@@ -0,0 +1,150 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/console.h>
+
+#include <string>
+#include <vector>
+
+static const int NUM_RUNS = 5;
+static const int NUM_LINES = 20000;
+static const int NUM_ROOMS = 2000;
+
+// what IGameController registers on every room console
+static const char *const s_apRoomCommands[] = {
+	"warmup", "countdown", "teamdamage", "match_swap", "powerups", "scorelimit", "timelimit", "roundlimit",
+	"teambalance_time", "kill_delay", "player_slots", "player_ready_mode", "reset_on_match_end",
+	"pause_per_match", "minimum_players", "say", "broadcast", "shuffle_teams", "swap_teams", "map",
+	"gametype", "pause", "restart", "set_team_all", "tune", "tune_reset", "tune_dump", "help", "info",
+	"add_vote", "remove_vote", "vote_kick", "server_command", "weapon", "max_ammo", "ammo_regen_time",
+	"ammo_regen_boost", "ammo_regen_delay", "empty_penalty", "laser_jump", "kill_damage"};
+
+static int s_Executed;
+
+static void Count(IConsole::IResult *pResult, void *pUserData)
+{
+	s_Executed++;
+}
+
+static void Chain(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+}
+
+// registers the config variables like CConsole::Init() does
+static void RegisterConfig(CConsole *pConsole, std::vector<const char *> *pvNames)
+{
+#define MACRO_CONFIG_INT(Name, ScriptName, Def, Min, Max, Flags, Desc) \
+	pConsole->Register(#ScriptName, "?i", Flags, Count, nullptr, Desc); \
+	if((Flags)&CFGFLAG_SERVER) \
+		pvNames->push_back(#ScriptName);
+#define MACRO_CONFIG_COL(Name, ScriptName, Def, Flags, Desc) MACRO_CONFIG_INT(Name, ScriptName, Def, 0, 0, Flags, Desc)
+#define MACRO_CONFIG_STR(Name, ScriptName, Len, Def, Flags, Desc) MACRO_CONFIG_INT(Name, ScriptName, Def, 0, 0, Flags, Desc)
+
+#include <engine/shared/config_variables.h>
+
+#undef MACRO_CONFIG_INT
+#undef MACRO_CONFIG_COL
+#undef MACRO_CONFIG_STR
+}
+
+static void RegisterRoom(CConsole *pConsole)
+{
+	for(const char *pName : s_apRoomCommands)
+		pConsole->Register(pName, "?i", CFGFLAG_CHAT | CFGFLAG_INSTANCE, Count, nullptr, "");
+	pConsole->Chain("scorelimit", Chain, nullptr);
+	pConsole->Chain("timelimit", Chain, nullptr);
+	pConsole->Chain("player_slots", Chain, nullptr);
+}
+
+// how CConsole::FindCommand() looked up every line before
+static const IConsole::CCommandInfo *FindLinear(CConsole *pConsole, const char *pName, int FlagMask)
+{
+	for(const IConsole::CCommandInfo *pInfo = pConsole->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask); pInfo; pInfo = pInfo->NextCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask))
+	{
+		if(str_comp_nocase(pInfo->m_pName, pName) == 0)
+			return pInfo;
+	}
+	return nullptr;
+}
+
+static double Best(double Current, double Seconds)
+{
+	return Current < 0.0 ? Seconds : minimum(Current, Seconds);
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	CConsole Console(CFGFLAG_SERVER);
+	std::vector<const char *> vNames;
+	RegisterConfig(&Console, &vNames);
+
+	// a config that sets every server variable over and over
+	std::vector<std::string> vLines;
+	for(int i = 0; i < NUM_LINES; i++)
+		vLines.push_back(std::string(vNames[i % vNames.size()]) + " " + std::to_string(i % 2));
+
+	double Execute = -1.0, Linear = -1.0, Hashed = -1.0, Fresh = -1.0, Shared = -1.0;
+	int Found = 0;
+	for(int Run = 0; Run < NUM_RUNS; Run++)
+	{
+		s_Executed = 0;
+		int64 Start = time_get_impl();
+		for(const std::string &Line : vLines)
+			Console.ExecuteLine(Line.c_str());
+		Execute = Best(Execute, (double)(time_get_impl() - Start) / time_freq());
+		if(s_Executed != NUM_LINES)
+		{
+			dbg_msg("benchmark", "executed %d of %d lines", s_Executed, NUM_LINES);
+			return 1;
+		}
+
+		// every line is looked up once when pressed and once when released
+		Start = time_get_impl();
+		for(int i = 0; i < NUM_LINES * 2; i++)
+			Found += FindLinear(&Console, vNames[i / 2 % vNames.size()], CFGFLAG_SERVER) != nullptr;
+		Linear = Best(Linear, (double)(time_get_impl() - Start) / time_freq());
+
+		Start = time_get_impl();
+		for(int i = 0; i < NUM_LINES * 2; i++)
+			Found += Console.GetCommandInfo(vNames[i / 2 % vNames.size()], CFGFLAG_SERVER, false) != nullptr;
+		Hashed = Best(Hashed, (double)(time_get_impl() - Start) / time_freq());
+
+		// rooms built from scratch and from the table of the first one
+		Start = time_get_impl();
+		for(int i = 0; i < NUM_ROOMS; i++)
+		{
+			CConsole *pRoom = new CConsole(CFGFLAG_INSTANCE);
+			RegisterRoom(pRoom);
+			delete pRoom;
+		}
+		Fresh = Best(Fresh, (double)(time_get_impl() - Start) / time_freq());
+
+		std::shared_ptr<const CConsole::CCommandTable> pTable;
+		Start = time_get_impl();
+		for(int i = 0; i < NUM_ROOMS; i++)
+		{
+			CConsole *pRoom = new CConsole(CFGFLAG_INSTANCE, pTable);
+			RegisterRoom(pRoom);
+			pTable = pRoom->CommandTable();
+			delete pRoom;
+		}
+		Shared = Best(Shared, (double)(time_get_impl() - Start) / time_freq());
+	}
+	if(Found != NUM_RUNS * NUM_LINES * 4)
+	{
+		dbg_msg("benchmark", "the lookups disagree");
+		return 1;
+	}
+
+	// the rest of executing a line didn't change
+	dbg_msg("benchmark", "config: commands=%d lines=%d execute=%.0fns/line, with linear lookups %.0fns/line",
+		(int)vNames.size(), NUM_LINES, Execute * 1e9 / NUM_LINES, (Execute - Hashed + Linear) * 1e9 / NUM_LINES);
+	dbg_msg("benchmark", "lookups per line: linear=%.0fns hashed=%.0fns speedup=%.2fx",
+		Linear * 1e9 / NUM_LINES, Hashed * 1e9 / NUM_LINES, Linear / Hashed);
+	dbg_msg("benchmark", "room console: fresh=%.2fus shared=%.2fus speedup=%.2fx",
+		Fresh * 1e6 / NUM_ROOMS, Shared * 1e6 / NUM_ROOMS, Fresh / Shared);
+	return 0;
+}
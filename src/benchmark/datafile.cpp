@@ -0,0 +1,205 @@
+#include <base/hash_ctxt.h>
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int NUM_RUNS = 5;
+
+// the header of a datafile, see datafile.cpp
+struct CHeader
+{
+	char m_aID[4];
+	int m_Version;
+	int m_Size;
+	int m_Swaplen;
+	int m_NumItemTypes;
+	int m_NumItems;
+	int m_NumRawData;
+	int m_ItemSize;
+	int m_DataSize;
+};
+
+// what the reader did before: one pass over the file for the hashes, a
+// second one for the header and items, then a seek, a read and an
+// allocation for every data index
+static bool LoadBaseline(const char *pFilename, unsigned *pDataBytes)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+		return false;
+
+	SHA256_CTX Sha256Ctxt;
+	sha256_init(&Sha256Ctxt);
+	unsigned Crc = 0;
+	unsigned char aBuffer[64 * 1024];
+	while(1)
+	{
+		unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
+		if(Bytes <= 0)
+			break;
+		Crc = crc32(Crc, aBuffer, Bytes);
+		sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+	}
+	sha256_finish(&Sha256Ctxt);
+	io_seek(File, 0, IOSEEK_START);
+
+	CHeader Header;
+	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header) || (Header.m_Version != 3 && Header.m_Version != 4))
+	{
+		io_close(File);
+		return false;
+	}
+	unsigned Size = Header.m_NumItemTypes * 3 * sizeof(int) + (Header.m_NumItems + Header.m_NumRawData) * sizeof(int);
+	if(Header.m_Version == 4)
+		Size += Header.m_NumRawData * sizeof(int);
+	Size += Header.m_ItemSize;
+	std::vector<char> vInfo(Size);
+	io_read(File, vInfo.data(), Size);
+	const int *pDataOffsets = (const int *)(vInfo.data() + Header.m_NumItemTypes * 3 * sizeof(int)) + Header.m_NumItems;
+	const int *pDataSizes = pDataOffsets + Header.m_NumRawData;
+	int DataStart = sizeof(Header) + Size;
+
+	std::vector<void *> vpData(Header.m_NumRawData);
+	for(int i = 0; i < Header.m_NumRawData; i++)
+	{
+		int FileSize = (i == Header.m_NumRawData - 1 ? Header.m_DataSize : pDataOffsets[i + 1]) - pDataOffsets[i];
+		void *pTemp = malloc(FileSize);
+		io_seek(File, DataStart + pDataOffsets[i], IOSEEK_START);
+		io_read(File, pTemp, FileSize);
+		if(Header.m_Version == 4)
+		{
+			unsigned long UncompressedSize = pDataSizes[i];
+			vpData[i] = malloc(UncompressedSize);
+			uncompress((Bytef *)vpData[i], &UncompressedSize, (Bytef *)pTemp, FileSize);
+			free(pTemp);
+			*pDataBytes += UncompressedSize;
+		}
+		else
+		{
+			vpData[i] = pTemp;
+			*pDataBytes += FileSize;
+		}
+	}
+	for(void *pData : vpData)
+		free(pData);
+	io_close(File);
+	return true;
+}
+
+static bool LoadReader(IStorage *pStorage, const char *pFilename, unsigned *pDataBytes)
+{
+	CDataFileReader Reader;
+	if(!Reader.Open(pStorage, pFilename, IStorage::TYPE_ABSOLUTE))
+		return false;
+	for(int i = 0; i < Reader.NumData(); i++)
+	{
+		Reader.GetData(i);
+		*pDataBytes += Reader.GetDataSize(i);
+	}
+	return true;
+}
+
+static int AddMap(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	std::vector<std::string> *pvMaps = (std::vector<std::string> *)pUser;
+	if(!IsDir && str_endswith(pName, ".map"))
+		pvMaps->push_back(pName);
+	return 0;
+}
+
+static void AddPath(const char *pPath, std::vector<std::string> *pvMaps)
+{
+	if(!fs_is_dir(pPath))
+	{
+		pvMaps->push_back(pPath);
+		return;
+	}
+	std::vector<std::string> vNames;
+	fs_listdir(pPath, AddMap, 0, &vNames);
+	for(const std::string &Name : vNames)
+		pvMaps->push_back(std::string(pPath) + "/" + Name);
+}
+
+// loads every map NUM_RUNS times with both and keeps the fastest runs
+static bool Run(const std::vector<std::string> &vMaps, double *pBaseline, double *pReader, unsigned *pDataBytes, const char **ppFailed)
+{
+	std::unique_ptr<IStorage> pStorage(CreateLocalStorage());
+	*pBaseline = -1.0;
+	*pReader = -1.0;
+	for(int Run = 0; Run < NUM_RUNS; Run++)
+	{
+		unsigned BaselineBytes = 0;
+		int64 Start = time_get_impl();
+		for(const std::string &Map : vMaps)
+		{
+			*ppFailed = Map.c_str();
+			if(!LoadBaseline(Map.c_str(), &BaselineBytes))
+				return false;
+		}
+		double Seconds = (double)(time_get_impl() - Start) / time_freq();
+		*pBaseline = *pBaseline < 0.0 ? Seconds : minimum(*pBaseline, Seconds);
+
+		unsigned ReaderBytes = 0;
+		Start = time_get_impl();
+		for(const std::string &Map : vMaps)
+		{
+			*ppFailed = Map.c_str();
+			if(!LoadReader(pStorage.get(), Map.c_str(), &ReaderBytes))
+				return false;
+		}
+		Seconds = (double)(time_get_impl() - Start) / time_freq();
+		*pReader = *pReader < 0.0 ? Seconds : minimum(*pReader, Seconds);
+
+		*ppFailed = nullptr;
+		if(BaselineBytes != ReaderBytes)
+			return false;
+		*pDataBytes = ReaderBytes;
+	}
+	return true;
+}
+
+int main(int argc, const char **argv)
+{
+	std::vector<std::string> vMaps;
+	if(argc > 1)
+	{
+		for(int i = 1; i < argc; i++)
+			AddPath(argv[i], &vMaps);
+	}
+	else
+	{
+		AddPath("data/maps", &vMaps);
+		AddPath("data/maps7", &vMaps);
+	}
+
+	// the reader logs every data index it loads, only log the results
+	double Baseline, Reader;
+	unsigned DataBytes = 0;
+	const char *pFailed = nullptr;
+	bool Success = !vMaps.empty() && Run(vMaps, &Baseline, &Reader, &DataBytes, &pFailed);
+	dbg_logger_stdout();
+	if(vMaps.empty())
+	{
+		dbg_msg("usage", "%s [map files or directories]", argv[0]);
+		return -1;
+	}
+	if(!Success)
+	{
+		if(pFailed)
+			dbg_msg("benchmark", "failed to load '%s'", pFailed);
+		else
+			dbg_msg("benchmark", "the reader and the baseline disagree about the data");
+		return 1;
+	}
+
+	dbg_msg("benchmark", "datafile load: maps=%d data=%.1fMiB baseline=%.2fms reader=%.2fms speedup=%.2fx",
+		(int)vMaps.size(), DataBytes / 1024.0 / 1024.0, Baseline * 1000.0, Reader * 1000.0, Baseline / Reader);
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include <base/system.h>
+#include <test/gamecore_replay.h>
+
+static const int NUM_RUNS = 5;
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	const char *pMapName = argc > 1 ? argv[1] : "data/maps/mega_std_collection.map";
+	int NumCharacters = argc > 2 ? clamp(str_toint(argv[2]), 1, (int)MAX_CLIENTS) : MAX_CLIENTS;
+	int NumTicks = argc > 3 ? maximum(str_toint(argv[3]), 1) : 5000;
+	if(argc > 4)
+	{
+		dbg_msg("usage", "%s [map] [characters] [ticks]", argv[0]);
+		return -1;
+	}
+
+	CGamecoreReplay Replay;
+	if(!Replay.Load(pMapName))
+	{
+		dbg_msg("benchmark", "failed to load map '%s' or it has no spawns", pMapName);
+		return 1;
+	}
+
+	CInputStream Stream;
+	Replay.Run(NumCharacters, 2, NumTicks, &Stream);
+
+	// replay the recorded input a few times and report the fastest run
+	int64 Best = -1;
+	SHA256_DIGEST Hash;
+	for(int i = 0; i < NUM_RUNS; i++)
+	{
+		int64 Start = time_get();
+		Hash = Replay.Replay(Stream, 2);
+		int64 Duration = time_get() - Start;
+		if(Best < 0 || Duration < Best)
+			Best = Duration;
+	}
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Hash, aSha256, sizeof(aSha256));
+	double Seconds = (double)Best / time_freq();
+	dbg_msg("benchmark", "gamecore: characters=%d ticks=%d time=%.3fs ticks/s=%.0f us/tick=%.2f sha256=%s",
+		NumCharacters, NumTicks, Seconds, NumTicks / Seconds, Seconds * 1000000.0 / NumTicks, aSha256);
+
+	const int NumRays = 100000;
+	int64 Start = time_get();
+	sha256_str(Replay.CollisionRays(NumRays), aSha256, sizeof(aSha256));
+	Seconds = (double)(time_get() - Start) / time_freq();
+	dbg_msg("benchmark", "collision: rays=%d time=%.3fs rays/s=%.0f sha256=%s",
+		NumRays, Seconds, NumRays / Seconds, aSha256);
+	return 0;
+}
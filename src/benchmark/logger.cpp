@@ -0,0 +1,122 @@
+#include <base/math.h>
+#include <base/system.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+static const int NUM_RUNS = 5;
+static const int NUM_TICKS = 200;
+static const int NUM_PLAYERS = 64;
+
+static const char *LOG_FILE = "benchmark_logger.txt";
+static const char *BASELINE_FILE = "benchmark_logger_baseline.txt";
+
+static ASYNCIO *s_pBaselineLog;
+
+// what dbg_msg() did before: format the timestamp and the message, then
+// write it to every logger on the calling thread
+static void BaselineMsg(const char *pSys, const char *pFmt, ...) GNUC_ATTRIBUTE((format(printf, 2, 3)));
+static void BaselineMsg(const char *pSys, const char *pFmt, ...)
+{
+	char aStr[1024 * 4];
+	char aTimeStr[80];
+	str_timestamp_format(aTimeStr, sizeof(aTimeStr), FORMAT_SPACE);
+	str_format(aStr, sizeof(aStr), "[%s][%s]: ", aTimeStr, pSys);
+	int Len = str_length(aStr);
+
+	va_list Args;
+	va_start(Args, pFmt);
+	vsnprintf(aStr + Len, sizeof(aStr) - Len, pFmt, Args);
+	va_end(Args);
+
+	aio_lock(s_pBaselineLog);
+	aio_write_unlocked(s_pBaselineLog, aStr, str_length(aStr));
+	aio_write_newline_unlocked(s_pBaselineLog);
+	aio_unlock(s_pBaselineLog);
+}
+
+// every player says something on every tick, only the time spent logging
+// counts, the rest of the tick is left to the logger threads
+static void Run(bool Baseline, double *pPerMessage, double *pWorstTick)
+{
+	int64 Total = 0;
+	int64 WorstTick = 0;
+	for(int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		int64 Start = time_get_impl();
+		for(int i = 0; i < NUM_PLAYERS; i++)
+		{
+			if(Baseline)
+				BaselineMsg("chat", "%d:%d:player %d: gg wp, that was tick %d of the round", i, 0, i, Tick);
+			else
+				dbg_msg("chat", "%d:%d:player %d: gg wp, that was tick %d of the round", i, 0, i, Tick);
+		}
+		int64 Time = time_get_impl() - Start;
+		Total += Time;
+		WorstTick = maximum(WorstTick, Time);
+		thread_sleep(1000);
+	}
+	*pPerMessage = (double)Total / time_freq() / (NUM_TICKS * NUM_PLAYERS);
+	*pWorstTick = (double)WorstTick / time_freq();
+}
+
+static int CountLines(const char *pFilename)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+		return -1;
+	int Lines = 0;
+	char aBuf[16 * 1024];
+	unsigned Bytes;
+	while((Bytes = io_read(File, aBuf, sizeof(aBuf))) > 0)
+	{
+		for(unsigned i = 0; i < Bytes; i++)
+			Lines += aBuf[i] == '\n';
+	}
+	io_close(File);
+	return Lines;
+}
+
+int main(int argc, const char **argv)
+{
+	// both write to a file, the results go to stdout afterwards
+	IOHANDLE BaselineFile = io_open(BASELINE_FILE, IOFLAG_WRITE);
+	if(!BaselineFile)
+	{
+		dbg_logger_stdout();
+		dbg_msg("benchmark", "failed to open '%s'", BASELINE_FILE);
+		return 1;
+	}
+	s_pBaselineLog = aio_new(BaselineFile);
+	dbg_logger_file(LOG_FILE);
+
+	double aBaseline[2] = {-1.0, -1.0};
+	double aQueued[2] = {-1.0, -1.0};
+	for(int i = 0; i < NUM_RUNS; i++)
+	{
+		double PerMessage, WorstTick;
+		Run(true, &PerMessage, &WorstTick);
+		aBaseline[0] = aBaseline[0] < 0.0 ? PerMessage : minimum(aBaseline[0], PerMessage);
+		aBaseline[1] = aBaseline[1] < 0.0 ? WorstTick : minimum(aBaseline[1], WorstTick);
+		Run(false, &PerMessage, &WorstTick);
+		aQueued[0] = aQueued[0] < 0.0 ? PerMessage : minimum(aQueued[0], PerMessage);
+		aQueued[1] = aQueued[1] < 0.0 ? WorstTick : minimum(aQueued[1], WorstTick);
+	}
+
+	aio_close(s_pBaselineLog);
+	aio_wait(s_pBaselineLog);
+	aio_free(s_pBaselineLog);
+	dbg_logger_flush();
+	int Messages = NUM_RUNS * NUM_TICKS * NUM_PLAYERS;
+	int Written = CountLines(LOG_FILE);
+
+	dbg_logger_stdout();
+	dbg_msg("benchmark", "chat load: players=%d ticks=%d runs=%d", NUM_PLAYERS, NUM_TICKS, NUM_RUNS);
+	dbg_msg("benchmark", "per message: baseline=%.0fns queued=%.0fns speedup=%.2fx",
+		aBaseline[0] * 1e9, aQueued[0] * 1e9, aBaseline[0] / aQueued[0]);
+	dbg_msg("benchmark", "worst tick: baseline=%.1fus queued=%.1fus", aBaseline[1] * 1e6, aQueued[1] * 1e6);
+	dbg_msg("benchmark", "written: %d of %d messages", Written, Messages);
+	fs_remove(BASELINE_FILE);
+	fs_remove(LOG_FILE);
+	return 0;
+}
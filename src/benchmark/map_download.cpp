@@ -0,0 +1,119 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/server/map_download.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+
+#include <vector>
+
+static const int NUM_RUNS = 5;
+
+// how CServer::SendMapData() worked before: every client requests the next
+// chunk in turn and it's packed again for every request
+static int64 Repacked(const std::vector<unsigned char> &vMap, int NumClients, unsigned *pChecksum)
+{
+	unsigned char aPacket[1400];
+	int NumChunks = (vMap.size() + CMapChunks::CHUNK_SIZE - 1) / CMapChunks::CHUNK_SIZE;
+	int64 Bytes = 0;
+	for(int Chunk = 0; Chunk < NumChunks; Chunk++)
+	{
+		for(int i = 0; i < NumClients; i++)
+		{
+			CPacker Pack;
+			CMapChunks::Pack(&Pack, vMap.data(), vMap.size(), 0xabcdef, Chunk, false);
+			mem_copy(aPacket, Pack.Data(), Pack.Size());
+			*pChecksum += aPacket[Pack.Size() - 1];
+			Bytes += Pack.Size();
+		}
+	}
+	return Bytes;
+}
+
+static int64 Prepacked(const std::vector<unsigned char> &vMap, int NumClients, unsigned *pChecksum)
+{
+	unsigned char aPacket[1400];
+	CMapChunks Chunks;
+	Chunks.Init(vMap.data(), vMap.size(), 0xabcdef, false);
+	int NumChunks = Chunks.NumChunks();
+	std::vector<CMapDownload> vDownloads(NumClients);
+	for(auto &Download : vDownloads)
+		Download.Reset(15);
+	int64 Bytes = 0;
+	// the window is refilled on every request like with fast download
+	for(bool Done = false; !Done;)
+	{
+		Done = true;
+		int64 Now = time_get_impl();
+		for(auto &Download : vDownloads)
+		{
+			if(Download.Received() >= NumChunks)
+				continue;
+			Done = false;
+			int End = Download.OnRequest(Download.Sent() ? Download.Received() + 1 : 0, NumChunks, Now);
+			for(int Chunk = Download.Sent(); Chunk < End; Chunk++)
+			{
+				mem_copy(aPacket, Chunks.Data(Chunk), Chunks.Size(Chunk));
+				*pChecksum += aPacket[Chunks.Size(Chunk) - 1];
+				Bytes += Chunks.Size(Chunk);
+				Download.OnSent(Chunk, Now);
+			}
+			if(Download.Sent() == NumChunks && Download.Received() == NumChunks - 1)
+				Download.OnRequest(NumChunks, NumChunks, Now);
+		}
+	}
+	return Bytes;
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	const char *pMapName = argc > 1 ? argv[1] : "data/maps/mega_std_collection.map";
+	int NumClients = argc > 2 ? maximum(str_toint(argv[2]), 1) : 64;
+	if(argc > 3)
+	{
+		dbg_msg("usage", "%s [map] [clients]", argv[0]);
+		return -1;
+	}
+
+	IOHANDLE File = io_open(pMapName, IOFLAG_READ);
+	if(!File)
+	{
+		dbg_msg("benchmark", "failed to open map '%s'", pMapName);
+		return 1;
+	}
+	std::vector<unsigned char> vMap(io_length(File));
+	io_read(File, vMap.data(), vMap.size());
+	io_close(File);
+
+	// serve the map to all clients a few times and keep the fastest runs
+	int64 BestRepacked = -1;
+	int64 BestPrepacked = -1;
+	int64 RepackedBytes = 0;
+	int64 PrepackedBytes = 0;
+	unsigned Checksum = 0;
+	for(int i = 0; i < NUM_RUNS; i++)
+	{
+		int64 Start = time_get_impl();
+		RepackedBytes = Repacked(vMap, NumClients, &Checksum);
+		int64 Duration = time_get_impl() - Start;
+		BestRepacked = BestRepacked < 0 ? Duration : minimum(BestRepacked, Duration);
+
+		Start = time_get_impl();
+		PrepackedBytes = Prepacked(vMap, NumClients, &Checksum);
+		Duration = time_get_impl() - Start;
+		BestPrepacked = BestPrepacked < 0 ? Duration : minimum(BestPrepacked, Duration);
+	}
+	if(RepackedBytes != PrepackedBytes)
+	{
+		dbg_msg("benchmark", "the prepacked chunks differ from the repacked ones");
+		return 1;
+	}
+
+	double MiB = RepackedBytes / 1024.0 / 1024.0;
+	double RepackedPerMiB = BestRepacked * 1000000.0 / time_freq() / MiB;
+	double PrepackedPerMiB = BestPrepacked * 1000000.0 / time_freq() / MiB;
+	dbg_msg("benchmark", "map download: clients=%d data=%.1fMiB repacked=%.0fus/MiB prepacked=%.0fus/MiB speedup=%.2fx checksum=%u",
+		NumClients, MiB, RepackedPerMiB, PrepackedPerMiB, RepackedPerMiB / PrepackedPerMiB, Checksum);
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/engine.h>
+#include <engine/map.h>
+#include <engine/server/map_loader.h>
+#include <engine/storage.h>
+#include <game/layers.h>
+
+#include <memory>
+
+static const int NUM_RUNS = 5;
+
+int main(int argc, const char **argv)
+{
+	const char *pMapName = argc > 1 ? argv[1] : "mega_std_collection";
+	if(argc > 2)
+	{
+		dbg_logger_stdout();
+		dbg_msg("usage", "%s [map name in data/maps]", argv[0]);
+		return -1;
+	}
+
+	std::unique_ptr<IStorage> pStorage(CreateTempStorage("data"));
+	std::unique_ptr<IEngineMap> pCurrent(CreateEngineMap());
+	char aFilename[256];
+	str_format(aFilename, sizeof(aFilename), "maps/%s.map", pMapName);
+	bool Success = pCurrent->Load(pStorage.get(), aFilename);
+
+	// what the main thread used to do on every map change is the whole load,
+	// what is left for it is the swap once the job is done
+	int64 Load = -1;
+	int64 Swap = -1;
+	for(int i = 0; Success && i < NUM_RUNS; i++)
+	{
+		int64 Start = time_get_impl();
+		CMapLoadJob Job(pStorage.get(), pMapName, false);
+		IEngine::RunJobBlocking(&Job);
+		int64 Duration = time_get_impl() - Start;
+		Load = Load < 0 ? Duration : minimum(Load, Duration);
+		Success = Job.Success();
+		if(!Success)
+			break;
+
+		Start = time_get_impl();
+		pCurrent->Swap(Job.Map());
+		CLayers Layers;
+		Layers.Init(pCurrent.get());
+		Success = Layers.GameLayer() && pCurrent->GetData(Layers.GameLayer()->m_Data);
+		Duration = time_get_impl() - Start;
+		Swap = Swap < 0 ? Duration : minimum(Swap, Duration);
+	}
+
+	// the map loader logs every data index it loads, only log the results
+	dbg_logger_stdout();
+	if(!Success)
+	{
+		dbg_msg("benchmark", "failed to load map '%s'", pMapName);
+		return 1;
+	}
+	dbg_msg("benchmark", "map loader: map=%s load=%.3fms swap=%.3fms",
+		pMapName, Load * 1000.0 / time_freq(), Swap * 1000.0 / time_freq());
+	return 0;
+}
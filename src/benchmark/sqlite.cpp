@@ -0,0 +1,206 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+
+#include <sqlite3.h>
+
+#include <memory>
+
+// the rank, top5 and points queries of the race tables
+static const char s_aRankQuery[] =
+	"SELECT COUNT(*) + 1 FROM record_race "
+	"WHERE Map = ? AND Time < (SELECT MIN(Time) FROM record_race WHERE Map = ? AND Name = ?)";
+static const char s_aTop5Query[] =
+	"SELECT Name, MIN(Time) AS BestTime FROM record_race "
+	"WHERE Map = ? GROUP BY Name ORDER BY BestTime ASC LIMIT 5";
+static const char s_aPointsQuery[] =
+	"INSERT INTO record_points(Name, Points) VALUES (?, ?) "
+	"ON CONFLICT(Name) DO UPDATE SET Points=Points+?";
+
+static const int NUM_MAPS = 50;
+static const int NUM_PLAYERS = 200;
+static const int NUM_RECORDS = 20000;
+static const int NUM_RUNS = 5;
+
+static void QueryArgs(int i, char *pMap, int MapSize, char *pName, int NameSize)
+{
+	str_format(pMap, MapSize, "map %d", i % NUM_MAPS);
+	str_format(pName, NameSize, "player %d", (i * 7) % NUM_PLAYERS);
+}
+
+static bool Populate(const char *pFilename)
+{
+	// creates the tables like the server does
+	std::unique_ptr<IDbConnection> pConnection(CreateSqliteConnection(pFilename, true));
+	char aError[256];
+	if(pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("benchmark", "failed to set up '%s': %s", pFilename, aError);
+		return false;
+	}
+	pConnection->Disconnect();
+	pConnection.reset();
+
+	sqlite3 *pDb;
+	sqlite3_open(pFilename, &pDb);
+	sqlite3_exec(pDb, "BEGIN", nullptr, nullptr, nullptr);
+	sqlite3_stmt *pStmt;
+	sqlite3_prepare_v2(pDb, "INSERT INTO record_race(Map, Name, Time, Server) VALUES (?, ?, ?, 'GER')", -1, &pStmt, nullptr);
+	for(int i = 0; i < NUM_RECORDS; i++)
+	{
+		char aMap[32];
+		char aName[32];
+		str_format(aMap, sizeof(aMap), "map %d", i % NUM_MAPS);
+		str_format(aName, sizeof(aName), "player %d", (i / NUM_MAPS) % NUM_PLAYERS);
+		sqlite3_bind_text(pStmt, 1, aMap, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(pStmt, 2, aName, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_double(pStmt, 3, 10.0 + (i * 7919 % 100000) / 100.0);
+		sqlite3_step(pStmt);
+		sqlite3_reset(pStmt);
+	}
+	sqlite3_finalize(pStmt);
+	sqlite3_exec(pDb, "COMMIT", nullptr, nullptr, nullptr);
+	sqlite3_close(pDb);
+	return true;
+}
+
+// what the connection did before: rollback journal with full syncs and a
+// fresh statement for every query
+static double RunBaseline(const char *pFilename, int NumReads, int NumWrites)
+{
+	sqlite3 *pDb;
+	sqlite3_open(pFilename, &pDb);
+	sqlite3_busy_timeout(pDb, -1);
+	sqlite3_exec(pDb, "PRAGMA journal_mode=DELETE", nullptr, nullptr, nullptr);
+	sqlite3_exec(pDb, "PRAGMA synchronous=FULL", nullptr, nullptr, nullptr);
+
+	int64 Start = time_get();
+	for(int i = 0; i < NumReads + NumWrites; i++)
+	{
+		char aMap[32];
+		char aName[32];
+		QueryArgs(i, aMap, sizeof(aMap), aName, sizeof(aName));
+		sqlite3_stmt *pStmt;
+		if(i >= NumReads)
+		{
+			sqlite3_prepare_v2(pDb, s_aPointsQuery, -1, &pStmt, nullptr);
+			sqlite3_bind_text(pStmt, 1, aName, -1, nullptr);
+			sqlite3_bind_int(pStmt, 2, 5);
+			sqlite3_bind_int(pStmt, 3, 5);
+		}
+		else if(i % 2 == 0)
+		{
+			sqlite3_prepare_v2(pDb, s_aRankQuery, -1, &pStmt, nullptr);
+			sqlite3_bind_text(pStmt, 1, aMap, -1, nullptr);
+			sqlite3_bind_text(pStmt, 2, aMap, -1, nullptr);
+			sqlite3_bind_text(pStmt, 3, aName, -1, nullptr);
+		}
+		else
+		{
+			sqlite3_prepare_v2(pDb, s_aTop5Query, -1, &pStmt, nullptr);
+			sqlite3_bind_text(pStmt, 1, aMap, -1, nullptr);
+		}
+		while(sqlite3_step(pStmt) == SQLITE_ROW)
+		{
+		}
+		sqlite3_finalize(pStmt);
+	}
+	double Seconds = (double)(time_get() - Start) / time_freq();
+	sqlite3_close(pDb);
+	return Seconds;
+}
+
+// the same queries through the connection, one task per query
+static double RunConnection(const char *pFilename, int NumReads, int NumWrites)
+{
+	std::unique_ptr<IDbConnection> pConnection(CreateSqliteConnection(pFilename, false));
+	char aError[256];
+
+	int64 Start = time_get();
+	for(int i = 0; i < NumReads + NumWrites; i++)
+	{
+		char aMap[32];
+		char aName[32];
+		QueryArgs(i, aMap, sizeof(aMap), aName, sizeof(aName));
+		bool Failed = pConnection->Connect(aError, sizeof(aError));
+		if(!Failed && i >= NumReads)
+		{
+			Failed = pConnection->AddPoints(aName, 5, aError, sizeof(aError));
+		}
+		else if(!Failed)
+		{
+			Failed = pConnection->PrepareStatement(i % 2 == 0 ? s_aRankQuery : s_aTop5Query, aError, sizeof(aError));
+			if(!Failed)
+			{
+				pConnection->BindString(1, aMap);
+				if(i % 2 == 0)
+				{
+					pConnection->BindString(2, aMap);
+					pConnection->BindString(3, aName);
+				}
+				bool End = false;
+				while(!Failed && !End)
+					Failed = pConnection->Step(&End, aError, sizeof(aError));
+			}
+		}
+		pConnection->Disconnect();
+		if(Failed)
+		{
+			dbg_msg("benchmark", "query failed: %s", aError);
+			return -1.0;
+		}
+	}
+	return (double)(time_get() - Start) / time_freq();
+}
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+
+	const char *pFilename = argc > 1 ? argv[1] : "benchmark_sqlite.sqlite";
+	int NumReads = argc > 2 ? maximum(str_toint(argv[2]), 1) : 20000;
+	int NumWrites = argc > 3 ? maximum(str_toint(argv[3]), 0) : 500;
+	if(argc > 4)
+	{
+		dbg_msg("usage", "%s [database file] [reads] [writes]", argv[0]);
+		return -1;
+	}
+
+	fs_remove(pFilename);
+	if(!Populate(pFilename))
+		return 1;
+
+	// alternate between both a few times and report the fastest runs
+	double BaselineReads = -1.0, BaselineWrites = -1.0, Reads = -1.0, Writes = -1.0;
+	for(int i = 0; i < NUM_RUNS; i++)
+	{
+		double Seconds = RunBaseline(pFilename, NumReads, 0);
+		BaselineReads = BaselineReads < 0.0 ? Seconds : minimum(BaselineReads, Seconds);
+		Seconds = RunBaseline(pFilename, 0, NumWrites);
+		BaselineWrites = BaselineWrites < 0.0 ? Seconds : minimum(BaselineWrites, Seconds);
+		Seconds = RunConnection(pFilename, NumReads, 0);
+		if(Seconds < 0.0)
+			return 1;
+		Reads = Reads < 0.0 ? Seconds : minimum(Reads, Seconds);
+		Seconds = RunConnection(pFilename, 0, NumWrites);
+		if(Seconds < 0.0)
+			return 1;
+		Writes = Writes < 0.0 ? Seconds : minimum(Writes, Seconds);
+	}
+
+	dbg_msg("benchmark", "sqlite reads: queries=%d baseline=%.0f/s connection=%.0f/s speedup=%.2fx",
+		NumReads, NumReads / BaselineReads, NumReads / Reads, BaselineReads / Reads);
+	if(NumWrites > 0)
+	{
+		dbg_msg("benchmark", "sqlite writes: queries=%d baseline=%.0f/s connection=%.0f/s speedup=%.2fx",
+			NumWrites, NumWrites / BaselineWrites, NumWrites / Writes, BaselineWrites / Writes);
+	}
+
+	fs_remove(pFilename);
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf), "%s-wal", pFilename);
+	fs_remove(aBuf);
+	str_format(aBuf, sizeof(aBuf), "%s-shm", pFilename);
+	fs_remove(aBuf);
+	return 0;
+}
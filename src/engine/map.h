@@ -31,12 +31,19 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap", 0)
 public:
 	virtual bool Load(const char *pMapName) = 0;
+	// doesn't need the kernel, e.g. for maps loaded in the background
+	virtual bool Load(class IStorage *pStorage, const char *pMapName) = 0;
 	virtual bool IsLoaded() = 0;
 	virtual void Unload() = 0;
 	virtual SHA256_DIGEST Sha256() = 0;
 	virtual unsigned Crc() = 0;
 	virtual int MapSize() = 0;
 	virtual IOHANDLE File() = 0;
+	virtual const unsigned char *FileData() = 0;
+	virtual unsigned FileSize() = 0;
+
+	// exchanges the loaded map with the one of pOther
+	virtual void Swap(IEngineMap *pOther) = 0;
 };
 
 extern IEngineMap *CreateEngineMap();
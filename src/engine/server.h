@@ -10,12 +10,14 @@
 
 #include "kernel.h"
 #include "message.h"
+#include <engine/server/id_map.h>
 #include <engine/shared/protocol.h>
 #include <game/generated/protocol.h>
 #include <game/generated/protocol7.h>
 #include <game/generated/protocolglue.h>
 
 struct CAntibotRoundData;
+class CSnapshotItemCache;
 
 class IServer : public IInterface
 {
@@ -24,6 +26,9 @@ protected:
 	int m_CurrentGameTick;
 	int m_TickSpeed;
 
+	// the client ids each viewer sees
+	CIdMap m_aIdMaps[MAX_CLIENTS];
+
 public:
 	/*
 		Structure: CClientInfo
@@ -152,40 +157,12 @@ public:
 
 	bool Translate(int &Target, int Client)
 	{
-		if(IsSixup(Client))
-			return true;
-		CClientInfo Info;
-		GetClientInfo(Client, &Info);
-		if(Info.m_DDNetVersion >= VERSION_DDNET_OLD)
-			return true;
-		int *pMap = GetIdMap(Client);
-		bool Found = false;
-		for(int i = 0; i < VANILLA_MAX_CLIENTS; i++)
-		{
-			if(Target == pMap[i])
-			{
-				Target = i;
-				Found = true;
-				break;
-			}
-		}
-		return Found;
+		return m_aIdMaps[Client].Translate(Target);
 	}
 
 	bool ReverseTranslate(int &Target, int Client)
 	{
-		if(IsSixup(Client))
-			return true;
-		CClientInfo Info;
-		GetClientInfo(Client, &Info);
-		if(Info.m_DDNetVersion >= VERSION_DDNET_OLD)
-			return true;
-		Target = clamp(Target, 0, VANILLA_MAX_CLIENTS - 1);
-		int *pMap = GetIdMap(Client);
-		if(pMap[Target] == -1)
-			return false;
-		Target = pMap[Target];
-		return true;
+		return m_aIdMaps[Client].ReverseTranslate(Target);
 	}
 
 	virtual void GetMapInfo(char *pMapName, int MapNameSize, int *pMapSize, SHA256_DIGEST *pSha256, int *pMapCrc) = 0;
@@ -200,6 +177,15 @@ public:
 	virtual int SnapNewID() = 0;
 	virtual void SnapFreeID(int ID) = 0;
 	virtual void *SnapNewItem(int Type, int ID, int Size) = 0;
+	// for snapping the same items into the snapshots of several clients
+	virtual int SnapNumItems() const = 0;
+	// items left out of the current snapshot so far
+	virtual int SnapNumDropped() const = 0;
+	virtual void SnapCopyItems(int FromItem, CSnapshotItemCache *pCache) const = 0;
+	virtual void SnapAddItems(const CSnapshotItemCache &Cache) = 0;
+	// importance of the items added next, the least important ones are
+	// dropped once the snapshot exceeds its budget, returns the previous one
+	virtual int SnapSetPriority(int Priority) = 0;
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
@@ -224,9 +210,26 @@ public:
 	virtual void StopRecord(int ClientID) = 0;
 	virtual bool IsRecording(int ClientID) = 0;
 
+	// demos of a single room, snapped once per tick from a spectator's view
+	virtual void StartRoomRecord(int Room) = 0;
+	virtual void StopRoomRecord(int Room) = 0;
+	virtual bool IsRoomRecording(int Room) const = 0;
+	virtual void RecordRoomMsg(CMsgPacker *pMsg, int Room) = 0;
+
+	template<class T>
+	void RecordRoomPackMsg(T *pMsg, int Room)
+	{
+		CMsgPacker Packer(pMsg->MsgID(), false);
+		if(!pMsg->Pack(&Packer))
+			RecordRoomMsg(&Packer, Room);
+	}
+
 	virtual void GetClientAddr(int ClientID, NETADDR *pAddr) const = 0;
 
-	virtual int *GetIdMap(int ClientID) = 0;
+	bool NeedsIdTranslation(int ClientID) const { return m_aIdMaps[ClientID].NeedsTranslation(); }
+	int *GetIdMap(int ClientID) { return m_aIdMaps[ClientID].Map(); }
+	// call after changing the id map of a viewer
+	void UpdateReverseIdMap(int ClientID) { m_aIdMaps[ClientID].UpdateReverse(); }
 
 	virtual bool DnsblWhite(int ClientID) = 0;
 	virtual bool DnsblPending(int ClientID) = 0;
@@ -265,6 +268,7 @@ public:
 	virtual void OnTick() = 0;
 	virtual void OnPreSnap() = 0;
 	virtual void OnSnap(int ClientID) = 0;
+	virtual void OnSnapRoom(int Room) = 0;
 	virtual void OnPostSnap() = 0;
 
 	virtual void OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID) = 0;
@@ -314,6 +318,8 @@ public:
 
 	// PvP
 	virtual bool CheckDisruptiveLeave(int ClientID) = 0;
+	virtual int GetClientRoom(int ClientID) const = 0;
+	virtual const char *NetObjName(int Type, bool Sixup) const = 0;
 };
 
 extern IGameServer *CreateGameServer();
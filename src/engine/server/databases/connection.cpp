@@ -84,3 +84,55 @@ void IDbConnection::FormatCreatePoints(char *aBuf, unsigned int BufferSize)
 		");",
 		GetPrefix(), MAX_NAME_LENGTH, BinaryCollate());
 }
+
+static const char *s_apPvpStatColumns[NUM_PVPSTATS] = {"Kills", "Deaths", "Captures", "Wins", "Matches"};
+
+void IDbConnection::FormatCreatePvpStats(char *aBuf, unsigned int BufferSize)
+{
+	str_format(aBuf, BufferSize,
+		"CREATE TABLE IF NOT EXISTS %s_pvp_stats ("
+		"  Name VARCHAR(%d) COLLATE %s NOT NULL, "
+		"  Mode VARCHAR(32) COLLATE %s NOT NULL, "
+		"  Kills INT DEFAULT 0, "
+		"  Deaths INT DEFAULT 0, "
+		"  Captures INT DEFAULT 0, "
+		"  Wins INT DEFAULT 0, "
+		"  Matches INT DEFAULT 0, "
+		"  PRIMARY KEY (Name, Mode)"
+		");",
+		GetPrefix(), MAX_NAME_LENGTH, BinaryCollate(), BinaryCollate());
+}
+
+void IDbConnection::FormatAddPvpStats(char *aBuf, unsigned int BufferSize, int NumRows, const char *pUpsert, const char *pNewPrefix, const char *pNewSuffix)
+{
+	str_format(aBuf, BufferSize, "INSERT INTO %s_pvp_stats(Name, Mode", GetPrefix());
+	for(const char *pColumn : s_apPvpStatColumns)
+	{
+		str_append(aBuf, ", ", BufferSize);
+		str_append(aBuf, pColumn, BufferSize);
+	}
+	str_append(aBuf, ") VALUES ", BufferSize);
+	for(int i = 0; i < NumRows; i++)
+		str_append(aBuf, i == 0 ? "(?, ?, ?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?, ?, ?)", BufferSize);
+	str_append(aBuf, " ", BufferSize);
+	str_append(aBuf, pUpsert, BufferSize);
+	for(int i = 0; i < NUM_PVPSTATS; i++)
+	{
+		char aUpdate[128];
+		str_format(aUpdate, sizeof(aUpdate), "%s=%s+%s%s%s", s_apPvpStatColumns[i], s_apPvpStatColumns[i], pNewPrefix, s_apPvpStatColumns[i], pNewSuffix);
+		str_append(aBuf, i == 0 ? " " : ", ", BufferSize);
+		str_append(aBuf, aUpdate, BufferSize);
+	}
+}
+
+void IDbConnection::BindPvpStats(const CPvpStatsRow *pRows, int NumRows)
+{
+	int Idx = 1;
+	for(int i = 0; i < NumRows; i++)
+	{
+		BindString(Idx++, pRows[i].m_aName);
+		BindString(Idx++, pRows[i].m_aMode);
+		for(int Value : pRows[i].m_aValues)
+			BindInt(Idx++, Value);
+	}
+}
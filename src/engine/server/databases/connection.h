@@ -2,9 +2,31 @@
 #define ENGINE_SERVER_DATABASES_CONNECTION_H
 
 #include <base/system.h>
+#include <engine/shared/protocol.h>
 
 class IConsole;
 
+enum
+{
+	PVPSTAT_KILLS,
+	PVPSTAT_DEATHS,
+	PVPSTAT_CAPTURES,
+	PVPSTAT_WINS,
+	PVPSTAT_MATCHES,
+	NUM_PVPSTATS,
+
+	// rows per INSERT, stays below the bound parameter limit of sqlite
+	PVPSTATS_ROWS_PER_STATEMENT = 64,
+};
+
+// what to add to the pvp statistics of a player in a gamemode
+struct CPvpStatsRow
+{
+	char m_aName[MAX_NAME_LENGTH];
+	char m_aMode[32];
+	int m_aValues[NUM_PVPSTATS];
+};
+
 // can hold one PreparedStatement with Results
 class IDbConnection
 {
@@ -79,6 +101,12 @@ public:
 
 	// SQL statements, that can't be abstracted, has side effects to the result
 	virtual bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize) = 0;
+	// adds all rows in one transaction
+	virtual bool AddPvpStats(const CPvpStatsRow *pRows, int NumRows, char *pError, int ErrorSize) = 0;
+
+	// whether the last error was a lock held by another connection that
+	// didn't become free in time, running the task again can succeed
+	virtual bool IsRetryable() const { return false; }
 
 private:
 	char m_aPrefix[64];
@@ -89,6 +117,11 @@ protected:
 	void FormatCreateMaps(char *aBuf, unsigned int BufferSize);
 	void FormatCreateSaves(char *aBuf, unsigned int BufferSize);
 	void FormatCreatePoints(char *aBuf, unsigned int BufferSize);
+	void FormatCreatePvpStats(char *aBuf, unsigned int BufferSize);
+	// multi-row insert that adds to existing rows with the backend specific
+	// pUpsert clause, the inserted value of a column is pNewPrefix<column>pNewSuffix
+	void FormatAddPvpStats(char *aBuf, unsigned int BufferSize, int NumRows, const char *pUpsert, const char *pNewPrefix, const char *pNewSuffix);
+	void BindPvpStats(const CPvpStatsRow *pRows, int NumRows);
 };
 
 int MysqlInit();
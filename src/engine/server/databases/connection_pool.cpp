@@ -1,7 +1,9 @@
 #include "connection_pool.h"
 #include "connection.h"
 
+#include <base/math.h>
 #include <engine/console.h>
+#include <engine/shared/metrics.h>
 
 // helper struct to hold thread data
 struct CSqlExecData
@@ -53,12 +55,22 @@ CSqlExecData::CSqlExecData(
 	m_Ptr.m_pWriteFunc = pFunc;
 }
 
+// a worker thread with its own copies of the connections it needs
+struct CSqlWorker
+{
+	CDbConnectionPool *m_pPool;
+	int m_Queue;
+	std::vector<std::unique_ptr<IDbConnection>> m_aapConnections[CDbConnectionPool::NUM_MODES];
+	// remember last working server and try to connect to it first
+	int m_ReadServer = 0;
+	int m_WriteServer = 0;
+};
+
 CDbConnectionPool::CDbConnectionPool() :
-	m_NumElem(),
-	FirstElem(0),
-	LastElem(0)
+	m_Shutdown(false),
+	m_NumRunning(0),
+	m_QueueSize(DEFAULT_QUEUE_SIZE)
 {
-	thread_init_and_detach(CDbConnectionPool::Worker, this, "database worker thread");
 }
 
 CDbConnectionPool::~CDbConnectionPool()
@@ -68,6 +80,7 @@ CDbConnectionPool::~CDbConnectionPool()
 void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
 {
 	const char *ModeDesc[] = {"Read", "Write", "WriteBackup"};
+	CScopeLock Lock(&m_ConnectionsLock);
 	for(unsigned int i = 0; i < m_aapDbConnections[DatabaseMode].size(); i++)
 	{
 		m_aapDbConnections[DatabaseMode][i]->Print(pConsole, ModeDesc[DatabaseMode]);
@@ -78,35 +91,91 @@ void CDbConnectionPool::RegisterDatabase(std::unique_ptr<IDbConnection> pDatabas
 {
 	if(DatabaseMode < 0 || NUM_MODES <= DatabaseMode)
 		return;
+	CScopeLock Lock(&m_ConnectionsLock);
 	m_aapDbConnections[DatabaseMode].push_back(std::move(pDatabase));
 }
 
-void CDbConnectionPool::Execute(
+void CDbConnectionPool::Start(int NumReadWorkers, int NumWriteWorkers, int QueueSize)
+{
+	dbg_assert(m_vpWorkers.empty(), "database workers already started");
+	m_QueueSize = maximum(QueueSize, 1);
+	m_aQueues[QUEUE_READ].m_NumWorkers = clamp(NumReadWorkers, 1, (int)MAX_WORKERS);
+	m_aQueues[QUEUE_WRITE].m_NumWorkers = clamp(NumWriteWorkers, 1, (int)MAX_WORKERS);
+	for(int Queue = 0; Queue < NUM_QUEUES; Queue++)
+	{
+		for(int i = 0; i < m_aQueues[Queue].m_NumWorkers; i++)
+		{
+			m_vpWorkers.emplace_back(new CSqlWorker());
+			m_vpWorkers.back()->m_pPool = this;
+			m_vpWorkers.back()->m_Queue = Queue;
+			m_NumRunning++;
+			thread_init_and_detach(CDbConnectionPool::Worker, m_vpWorkers.back().get(), Queue == QUEUE_READ ? "database read worker" : "database write worker");
+		}
+	}
+}
+
+bool CDbConnectionPool::Enqueue(int Queue, std::unique_ptr<CSqlExecData> pData)
+{
+	CTaskQueue *pQueue = &m_aQueues[Queue];
+	{
+		CScopeLock Lock(&pQueue->m_Lock);
+		if(m_Shutdown.load() || (int)pQueue->m_Tasks.size() >= m_QueueSize)
+		{
+			dbg_msg("sql", "%s dropped, the %s queue is full", pData->m_pName, Queue == QUEUE_READ ? "read" : "write");
+			g_MetricDbTasksDropped.Add();
+			// complete it as failed, callers poll for the result
+			if(pData->m_pThreadData->m_pResult != nullptr)
+			{
+				pData->m_pThreadData->m_pResult->m_Success = false;
+				pData->m_pThreadData->m_pResult->m_Completed.store(true);
+			}
+			return false;
+		}
+		pQueue->m_Tasks.push_back(std::move(pData));
+	}
+	g_MetricDbQueueDepth.Add(1);
+	pQueue->m_NumElem.Signal();
+	return true;
+}
+
+bool CDbConnectionPool::Execute(
 	FRead pFunc,
 	std::unique_ptr<const ISqlData> pThreadData,
 	const char *pName)
 {
-	m_aTasks[FirstElem++].reset(new CSqlExecData(pFunc, std::move(pThreadData), pName));
-	FirstElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
-	m_NumElem.Signal();
+	return Enqueue(QUEUE_READ, std::unique_ptr<CSqlExecData>(new CSqlExecData(pFunc, std::move(pThreadData), pName)));
 }
 
-void CDbConnectionPool::ExecuteWrite(
+bool CDbConnectionPool::ExecuteWrite(
 	FWrite pFunc,
 	std::unique_ptr<const ISqlData> pThreadData,
 	const char *pName)
 {
-	m_aTasks[FirstElem++].reset(new CSqlExecData(pFunc, std::move(pThreadData), pName));
-	FirstElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
-	m_NumElem.Signal();
+	return Enqueue(QUEUE_WRITE, std::unique_ptr<CSqlExecData>(new CSqlExecData(pFunc, std::move(pThreadData), pName)));
+}
+
+int CDbConnectionPool::QueueLength(Mode DatabaseMode)
+{
+	CTaskQueue *pQueue = &m_aQueues[QueueIndex(DatabaseMode)];
+	CScopeLock Lock(&pQueue->m_Lock);
+	return pQueue->m_Tasks.size();
+}
+
+bool CDbConnectionPool::IsSaturated(Mode DatabaseMode)
+{
+	return QueueLength(DatabaseMode) * 4 > m_QueueSize * 3;
 }
 
 void CDbConnectionPool::OnShutdown()
 {
 	m_Shutdown.store(true);
-	m_NumElem.Signal();
+	// one wakeup per worker on top of the remaining tasks, so every worker
+	// finds its queue empty once all jobs are done
+	for(auto &Queue : m_aQueues)
+		for(int i = 0; i < Queue.m_NumWorkers; i++)
+			Queue.m_NumElem.Signal();
 	int i = 0;
-	while(m_Shutdown.load())
+	while(m_NumRunning.load() > 0)
 	{
 		if(i > 600)
 		{
@@ -124,37 +193,60 @@ void CDbConnectionPool::OnShutdown()
 
 void CDbConnectionPool::Worker(void *pUser)
 {
-	CDbConnectionPool *pThis = (CDbConnectionPool *)pUser;
-	pThis->Worker();
+	CSqlWorker *pWorker = (CSqlWorker *)pUser;
+	pWorker->m_pPool->Worker(pWorker);
 }
 
-void CDbConnectionPool::Worker()
+void CDbConnectionPool::SyncConnections(CSqlWorker *pWorker)
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	int WriteServer = 0;
+	// databases can be added while the workers are running
+	CScopeLock Lock(&m_ConnectionsLock);
+	for(int Mode = 0; Mode < NUM_MODES; Mode++)
+	{
+		if((Mode == READ) != (pWorker->m_Queue == QUEUE_READ))
+			continue;
+		auto &vpConnections = pWorker->m_aapConnections[Mode];
+		while(vpConnections.size() < m_aapDbConnections[Mode].size())
+			vpConnections.emplace_back(m_aapDbConnections[Mode][vpConnections.size()]->Copy());
+	}
+}
+
+void CDbConnectionPool::Worker(CSqlWorker *pWorker)
+{
+	CTaskQueue *pQueue = &m_aQueues[pWorker->m_Queue];
+	auto &aapConnections = pWorker->m_aapConnections;
 	while(1)
 	{
-		m_NumElem.Wait();
-		auto pThreadData = std::move(m_aTasks[LastElem++]);
+		pQueue->m_NumElem.Wait();
+		std::unique_ptr<CSqlExecData> pThreadData;
+		{
+			CScopeLock Lock(&pQueue->m_Lock);
+			if(!pQueue->m_Tasks.empty())
+			{
+				pThreadData = std::move(pQueue->m_Tasks.front());
+				pQueue->m_Tasks.pop_front();
+			}
+		}
 		// work through all database jobs after OnShutdown is called before exiting the thread
 		if(pThreadData == nullptr)
 		{
-			m_Shutdown.store(false);
-			return;
+			if(m_Shutdown.load())
+				break;
+			continue;
 		}
-		LastElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
+		g_MetricDbQueueDepth.Add(-1);
+		SyncConnections(pWorker);
 		bool Success = false;
 		switch(pThreadData->m_Mode)
 		{
 		case CSqlExecData::READ_ACCESS:
 		{
-			for(int i = 0; i < (int)m_aapDbConnections[Mode::READ].size(); i++)
+			for(int i = 0; i < (int)aapConnections[Mode::READ].size(); i++)
 			{
-				int CurServer = (ReadServer + i) % (int)m_aapDbConnections[Mode::READ].size();
-				if(ExecSqlFunc(m_aapDbConnections[Mode::READ][CurServer].get(), pThreadData.get(), false))
+				int CurServer = (pWorker->m_ReadServer + i) % (int)aapConnections[Mode::READ].size();
+				if(ExecSqlFunc(aapConnections[Mode::READ][CurServer].get(), pThreadData.get(), false))
 				{
-					ReadServer = CurServer;
+					pWorker->m_ReadServer = CurServer;
 					dbg_msg("sql", "%s done on read database %d", pThreadData->m_pName, CurServer);
 					Success = true;
 					break;
@@ -164,12 +256,12 @@ void CDbConnectionPool::Worker()
 		break;
 		case CSqlExecData::WRITE_ACCESS:
 		{
-			for(int i = 0; i < (int)m_aapDbConnections[Mode::WRITE].size(); i++)
+			for(int i = 0; i < (int)aapConnections[Mode::WRITE].size(); i++)
 			{
-				int CurServer = (WriteServer + i) % (int)m_aapDbConnections[Mode::WRITE].size();
-				if(ExecSqlFunc(m_aapDbConnections[Mode::WRITE][i].get(), pThreadData.get(), false))
+				int CurServer = (pWorker->m_WriteServer + i) % (int)aapConnections[Mode::WRITE].size();
+				if(ExecSqlFunc(aapConnections[Mode::WRITE][CurServer].get(), pThreadData.get(), false))
 				{
-					WriteServer = CurServer;
+					pWorker->m_WriteServer = CurServer;
 					dbg_msg("sql", "%s done on write database %d", pThreadData->m_pName, CurServer);
 					Success = true;
 					break;
@@ -177,9 +269,9 @@ void CDbConnectionPool::Worker()
 			}
 			if(!Success)
 			{
-				for(int i = 0; i < (int)m_aapDbConnections[Mode::WRITE_BACKUP].size(); i++)
+				for(int i = 0; i < (int)aapConnections[Mode::WRITE_BACKUP].size(); i++)
 				{
-					if(ExecSqlFunc(m_aapDbConnections[Mode::WRITE_BACKUP][i].get(), pThreadData.get(), true))
+					if(ExecSqlFunc(aapConnections[Mode::WRITE_BACKUP][i].get(), pThreadData.get(), true))
 					{
 						dbg_msg("sql", "%s done on write backup database %d", pThreadData->m_pName, i);
 						Success = true;
@@ -198,6 +290,7 @@ void CDbConnectionPool::Worker()
 			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
 		}
 	}
+	m_NumRunning--;
 }
 
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, bool Failure)
@@ -209,14 +302,20 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 		return false;
 	}
 	bool Success = false;
-	switch(pData->m_Mode)
+	for(int Try = 0; Try <= MAX_RETRIES; Try++)
 	{
-	case CSqlExecData::READ_ACCESS:
-		Success = !pData->m_Ptr.m_pReadFunc(pConnection, pData->m_pThreadData.get(), aError, sizeof(aError));
-		break;
-	case CSqlExecData::WRITE_ACCESS:
-		Success = !pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Failure, aError, sizeof(aError));
-		break;
+		switch(pData->m_Mode)
+		{
+		case CSqlExecData::READ_ACCESS:
+			Success = !pData->m_Ptr.m_pReadFunc(pConnection, pData->m_pThreadData.get(), aError, sizeof(aError));
+			break;
+		case CSqlExecData::WRITE_ACCESS:
+			Success = !pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Failure, aError, sizeof(aError));
+			break;
+		}
+		if(Success || !pConnection->IsRetryable())
+			break;
+		dbg_msg("sql", "%s retrying: %s", pData->m_pName, aError);
 	}
 	pConnection->Disconnect();
 	if(!Success)
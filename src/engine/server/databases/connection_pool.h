@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <base/tl/threading.h>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -52,34 +53,74 @@ public:
 		NUM_MODES,
 	};
 
+	enum
+	{
+		DEFAULT_QUEUE_SIZE = 512,
+		MAX_WORKERS = 16,
+		// runs of a task on the same database after a lock timeout
+		MAX_RETRIES = 2,
+	};
+
 	void Print(IConsole *pConsole, Mode DatabaseMode);
 
 	void RegisterDatabase(std::unique_ptr<IDbConnection> pDatabase, Mode DatabaseMode);
 
-	void Execute(
+	// Starts the workers, every one of them with its own connections.
+	// Reads and writes are queued separately, writes fall back to the
+	// WRITE_BACKUP databases. Tasks queued before are kept.
+	void Start(int NumReadWorkers, int NumWriteWorkers, int QueueSize = DEFAULT_QUEUE_SIZE);
+
+	// Returns false if the queue is full and the task got dropped.
+	bool Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
-	// writes to WRITE_BACKUP server in case of failure
-	void ExecuteWrite(
+	// writes to WRITE_BACKUP server in case of failure. Tasks can run again
+	// after a lock timeout, so they have to write in a single transaction.
+	bool ExecuteWrite(
 		FWrite pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 
+	// tasks waiting for a worker, WRITE_BACKUP shares the WRITE queue
+	int QueueLength(Mode DatabaseMode);
+	// more than three quarters of the queue are used, callers should shed
+	// or coalesce work before it starts to drop tasks
+	bool IsSaturated(Mode DatabaseMode);
+
 	void OnShutdown();
 
 private:
+	enum
+	{
+		QUEUE_READ,
+		QUEUE_WRITE,
+		NUM_QUEUES,
+	};
+
+	struct CTaskQueue
+	{
+		CLock m_Lock;
+		CSemaphore m_NumElem;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_Tasks;
+		int m_NumWorkers = 0;
+	};
+
+	CLock m_ConnectionsLock;
 	std::vector<std::unique_ptr<IDbConnection>> m_aapDbConnections[NUM_MODES];
 
 	static void Worker(void *pUser);
-	void Worker();
+	void Worker(struct CSqlWorker *pWorker);
+	void SyncConnections(struct CSqlWorker *pWorker);
 	bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, bool Failure);
+	bool Enqueue(int Queue, std::unique_ptr<struct CSqlExecData> pData);
+	static int QueueIndex(Mode DatabaseMode) { return DatabaseMode == READ ? QUEUE_READ : QUEUE_WRITE; }
 
 	std::atomic_bool m_Shutdown;
-	CSemaphore m_NumElem;
-	int FirstElem;
-	int LastElem;
-	std::unique_ptr<struct CSqlExecData> m_aTasks[512];
+	std::atomic_int m_NumRunning;
+	int m_QueueSize;
+	CTaskQueue m_aQueues[NUM_QUEUES];
+	std::vector<std::unique_ptr<struct CSqlWorker>> m_vpWorkers;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
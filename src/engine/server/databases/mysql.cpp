@@ -3,6 +3,7 @@
 #if defined(CONF_SQL)
 #include <mysql.h>
 
+#include <base/math.h>
 #include <base/tl/threading.h>
 #include <engine/console.h>
 
@@ -95,6 +96,7 @@ public:
 	virtual int GetBlob(int Col, unsigned char *pBuffer, int BufferSize);
 
 	virtual bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize);
+	virtual bool AddPvpStats(const CPvpStatsRow *pRows, int NumRows, char *pError, int ErrorSize);
 
 private:
 	class CStmtDeleter
@@ -305,17 +307,20 @@ bool CMysqlConnection::ConnectImpl()
 		char aCreateMaps[1024];
 		char aCreateSaves[1024];
 		char aCreatePoints[1024];
+		char aCreatePvpStats[1024];
 		FormatCreateRace(aCreateRace, sizeof(aCreateRace));
 		FormatCreateTeamrace(aCreateTeamrace, sizeof(aCreateTeamrace), "VARBINARY(16)");
 		FormatCreateMaps(aCreateMaps, sizeof(aCreateMaps));
 		FormatCreateSaves(aCreateSaves, sizeof(aCreateSaves));
 		FormatCreatePoints(aCreatePoints, sizeof(aCreatePoints));
+		FormatCreatePvpStats(aCreatePvpStats, sizeof(aCreatePvpStats));
 
 		if(PrepareAndExecuteStatement(aCreateRace) ||
 			PrepareAndExecuteStatement(aCreateTeamrace) ||
 			PrepareAndExecuteStatement(aCreateMaps) ||
 			PrepareAndExecuteStatement(aCreateSaves) ||
-			PrepareAndExecuteStatement(aCreatePoints))
+			PrepareAndExecuteStatement(aCreatePoints) ||
+			PrepareAndExecuteStatement(aCreatePvpStats))
 		{
 			return true;
 		}
@@ -655,6 +660,41 @@ bool CMysqlConnection::AddPoints(const char *pPlayer, int Points, char *pError,
 	return false;
 }
 
+bool CMysqlConnection::AddPvpStats(const CPvpStatsRow *pRows, int NumRows, char *pError, int ErrorSize)
+{
+	if(mysql_query(&m_Mysql, "START TRANSACTION"))
+	{
+		StoreErrorMysql("start_transaction");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return true;
+	}
+	for(int i = 0; i < NumRows; i += PVPSTATS_ROWS_PER_STATEMENT)
+	{
+		int Num = minimum(NumRows - i, (int)PVPSTATS_ROWS_PER_STATEMENT);
+		char aBuf[8192];
+		FormatAddPvpStats(aBuf, sizeof(aBuf), Num, "ON DUPLICATE KEY UPDATE", "VALUES(", ")");
+		int NumUpdated;
+		if(PrepareStatement(aBuf, pError, ErrorSize))
+		{
+			mysql_query(&m_Mysql, "ROLLBACK");
+			return true;
+		}
+		BindPvpStats(pRows + i, Num);
+		if(ExecuteUpdate(&NumUpdated, pError, ErrorSize))
+		{
+			mysql_query(&m_Mysql, "ROLLBACK");
+			return true;
+		}
+	}
+	if(mysql_query(&m_Mysql, "COMMIT"))
+	{
+		StoreErrorMysql("commit");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return true;
+	}
+	return false;
+}
+
 IDbConnection *CreateMysqlConnection(
 	const char *pDatabase,
 	const char *pPrefix,
@@ -0,0 +1,91 @@
+#include "pvp_stats.h"
+
+struct CSqlPvpStatsData : ISqlData
+{
+	CSqlPvpStatsData(std::vector<CPvpStatsRow> vRows) :
+		ISqlData(nullptr),
+		m_vRows(std::move(vRows))
+	{
+	}
+
+	std::vector<CPvpStatsRow> m_vRows;
+};
+
+CPvpStatsWriter::CPvpStatsWriter(CDbConnectionPool *pPool) :
+	m_pPool(pPool)
+{
+}
+
+void CPvpStatsWriter::Merge(std::vector<CPvpStatsRow> *pvRows, const CPvpStatsRow &Row)
+{
+	for(auto &Existing : *pvRows)
+	{
+		if(str_comp(Existing.m_aName, Row.m_aName) == 0 && str_comp(Existing.m_aMode, Row.m_aMode) == 0)
+		{
+			for(int i = 0; i < NUM_PVPSTATS; i++)
+				Existing.m_aValues[i] += Row.m_aValues[i];
+			return;
+		}
+	}
+	pvRows->push_back(Row);
+}
+
+void CPvpStatsWriter::Add(int Room, const char *pName, const char *pMode, int Stat, int Amount)
+{
+	if(Room < 0 || Room >= MAX_CLIENTS || Stat < 0 || Stat >= NUM_PVPSTATS)
+		return;
+
+	CPvpStatsRow Row;
+	str_copy(Row.m_aName, pName, sizeof(Row.m_aName));
+	str_copy(Row.m_aMode, pMode, sizeof(Row.m_aMode));
+	mem_zero(Row.m_aValues, sizeof(Row.m_aValues));
+	Row.m_aValues[Stat] = Amount;
+	Merge(&m_avRooms[Room], Row);
+}
+
+void CPvpStatsWriter::FlushRoom(int Room)
+{
+	if(Room < 0 || Room >= MAX_CLIENTS)
+		return;
+
+	for(const auto &Row : m_avRooms[Room])
+		Merge(&m_vPending, Row);
+	m_avRooms[Room].clear();
+	Write(false);
+}
+
+void CPvpStatsWriter::Flush(bool Force)
+{
+	for(auto &vRows : m_avRooms)
+	{
+		for(const auto &Row : vRows)
+			Merge(&m_vPending, Row);
+		vRows.clear();
+	}
+	Write(Force);
+}
+
+void CPvpStatsWriter::Write(bool Force)
+{
+	if(m_vPending.empty())
+		return;
+	// keep coalescing while the database is behind, the rows only grow in
+	// number with new players, not with new events
+	if(!Force && m_pPool->IsSaturated(CDbConnectionPool::WRITE))
+		return;
+
+	if(m_pPool->ExecuteWrite(WriteStats, std::unique_ptr<const ISqlData>(new CSqlPvpStatsData(m_vPending)), "write pvp stats"))
+		m_vPending.clear();
+	else if(Force)
+	{
+		// nothing gets another chance at shutdown
+		dbg_msg("sql", "dropped %d pvp stats rows", (int)m_vPending.size());
+		m_vPending.clear();
+	}
+}
+
+bool CPvpStatsWriter::WriteStats(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	const CSqlPvpStatsData *pData = dynamic_cast<const CSqlPvpStatsData *>(pGameData);
+	return pSqlServer->AddPvpStats(pData->m_vRows.data(), pData->m_vRows.size(), pError, ErrorSize);
+}
@@ -0,0 +1,34 @@
+#ifndef ENGINE_SERVER_DATABASES_PVP_STATS_H
+#define ENGINE_SERVER_DATABASES_PVP_STATS_H
+
+#include "connection.h"
+#include "connection_pool.h"
+
+#include <vector>
+
+// Collects the pvp statistics of every room in memory and hands them to
+// the database in batches, one write task per flush instead of one per kill.
+class CPvpStatsWriter
+{
+	CDbConnectionPool *m_pPool;
+	std::vector<CPvpStatsRow> m_avRooms[MAX_CLIENTS];
+	// flushed while the write queue was saturated, coalesced until it drains
+	std::vector<CPvpStatsRow> m_vPending;
+
+	static void Merge(std::vector<CPvpStatsRow> *pvRows, const CPvpStatsRow &Row);
+	static bool WriteStats(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize);
+	void Write(bool Force);
+
+public:
+	CPvpStatsWriter(CDbConnectionPool *pPool);
+
+	void Add(int Room, const char *pName, const char *pMode, int Stat, int Amount = 1);
+	// hands the deltas of the room to the database, e.g. at the end of a match
+	void FlushRoom(int Room);
+	// hands everything to the database, called periodically and on shutdown
+	void Flush(bool Force = false);
+
+	int NumPendingRows() const { return m_vPending.size(); }
+};
+
+#endif // ENGINE_SERVER_DATABASES_PVP_STATS_H
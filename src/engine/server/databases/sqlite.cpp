@@ -6,6 +6,9 @@
 #include <engine/console.h>
 
 #include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
 
 class CSqliteConnection : public IDbConnection
 {
@@ -46,8 +49,19 @@ public:
 	virtual int GetBlob(int Col, unsigned char *pBuffer, int BufferSize);
 
 	virtual bool AddPoints(const char *pPlayer, int Points, char *pError, int ErrorSize);
+	virtual bool AddPvpStats(const CPvpStatsRow *pRows, int NumRows, char *pError, int ErrorSize);
+
+	virtual bool IsRetryable() const { return m_Busy; }
 
 private:
+	enum
+	{
+		// the queries only differ in a handful of tables and row counts
+		MAX_CACHED_STATEMENTS = 64,
+		// ms to wait for a lock of another connection before failing
+		BUSY_TIMEOUT = 5000,
+	};
+
 	// copy of config vars
 	char m_aFilename[512];
 	bool m_Setup;
@@ -55,6 +69,19 @@ private:
 	sqlite3 *m_pDb;
 	sqlite3_stmt *m_pStmt;
 	bool m_Done; // no more rows available for Step
+	bool m_Busy; // last error was a lock timeout
+
+	// prepared statements by query, most recently used first
+	struct CCachedStatement
+	{
+		std::string m_Query;
+		sqlite3_stmt *m_pStmt;
+	};
+	std::list<CCachedStatement> m_lStatements;
+	std::unordered_map<std::string, std::list<CCachedStatement>::iterator> m_StatementIndex;
+	void ResetStatement();
+	void ClearStatements();
+
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
 
@@ -71,6 +98,7 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 	m_pDb(nullptr),
 	m_pStmt(nullptr),
 	m_Done(true),
+	m_Busy(false),
 	m_InUse(false)
 {
 	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
@@ -78,8 +106,7 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	ClearStatements();
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -109,6 +136,7 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 	{
 		dbg_assert(0, "Tried connecting while the connection is in use");
 	}
+	m_Busy = false;
 
 	if(m_pDb != nullptr)
 	{
@@ -122,8 +150,16 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 		return true;
 	}
 
-	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors
-	sqlite3_busy_timeout(m_pDb, -1);
+	// a lock held longer than this fails the task with a retryable error
+	// instead of blocking the worker forever
+	sqlite3_busy_timeout(m_pDb, BUSY_TIMEOUT);
+	// readers don't block the writer in wal mode and commits only fsync on
+	// checkpoints, which still keeps the database consistent on power loss
+	if(Execute("PRAGMA journal_mode=WAL", pError, ErrorSize) ||
+		Execute("PRAGMA synchronous=NORMAL", pError, ErrorSize))
+	{
+		return true;
+	}
 
 	if(m_Setup)
 	{
@@ -141,6 +177,9 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 		FormatCreatePoints(aBuf, sizeof(aBuf));
+		if(Execute(aBuf, pError, ErrorSize))
+			return true;
+		FormatCreatePvpStats(aBuf, sizeof(aBuf));
 		if(Execute(aBuf, pError, ErrorSize))
 			return true;
 		m_Setup = false;
@@ -150,27 +189,67 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
-	m_pStmt = nullptr;
+	// keeps the prepared statements for the next task
+	ResetStatement();
 	m_InUse.store(false);
 }
 
-bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+void CSqliteConnection::ResetStatement()
+{
+	if(m_pStmt == nullptr)
+		return;
+	// ends the read transaction of a partially stepped statement and
+	// drops the bound strings, which aren't owned by sqlite
+	sqlite3_reset(m_pStmt);
+	sqlite3_clear_bindings(m_pStmt);
+	m_pStmt = nullptr;
+}
+
+void CSqliteConnection::ClearStatements()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
 	m_pStmt = nullptr;
+	for(auto &Statement : m_lStatements)
+		sqlite3_finalize(Statement.m_pStmt);
+	m_lStatements.clear();
+	m_StatementIndex.clear();
+}
+
+bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+{
+	ResetStatement();
+	m_Busy = false;
+
+	auto Cached = m_StatementIndex.find(pStmt);
+	if(Cached != m_StatementIndex.end())
+	{
+		m_lStatements.splice(m_lStatements.begin(), m_lStatements, Cached->second);
+		m_pStmt = Cached->second->m_pStmt;
+		m_Done = false;
+		return false;
+	}
+
+	sqlite3_stmt *pPrepared = nullptr;
 	int Result = sqlite3_prepare_v2(
 		m_pDb,
 		pStmt,
 		-1, // pStmt can be any length
-		&m_pStmt,
+		&pPrepared,
 		NULL);
 	if(FormatError(Result, pError, ErrorSize))
 	{
+		sqlite3_finalize(pPrepared);
 		return true;
 	}
+
+	if((int)m_lStatements.size() >= MAX_CACHED_STATEMENTS)
+	{
+		sqlite3_finalize(m_lStatements.back().m_pStmt);
+		m_StatementIndex.erase(m_lStatements.back().m_Query);
+		m_lStatements.pop_back();
+	}
+	m_lStatements.push_front(CCachedStatement{pStmt, pPrepared});
+	m_StatementIndex[pStmt] = m_lStatements.begin();
+	m_pStmt = pPrepared;
 	m_Done = false;
 	return false;
 }
@@ -310,6 +389,7 @@ bool CSqliteConnection::Execute(const char *pQuery, char *pError, int ErrorSize)
 	int Result = sqlite3_exec(m_pDb, pQuery, NULL, NULL, &pErrorMsg);
 	if(Result != SQLITE_OK)
 	{
+		m_Busy = Result == SQLITE_BUSY || Result == SQLITE_LOCKED;
 		str_format(pError, ErrorSize, "error executing query: '%s'", pErrorMsg);
 		sqlite3_free(pErrorMsg);
 		return true;
@@ -321,7 +401,11 @@ bool CSqliteConnection::FormatError(int Result, char *pError, int ErrorSize)
 {
 	if(Result != SQLITE_OK)
 	{
-		str_copy(pError, sqlite3_errmsg(m_pDb), ErrorSize);
+		m_Busy = (Result & 0xff) == SQLITE_BUSY || (Result & 0xff) == SQLITE_LOCKED;
+		if(m_Busy)
+			str_format(pError, ErrorSize, "database locked for %dms: %s", (int)BUSY_TIMEOUT, sqlite3_errmsg(m_pDb));
+		else
+			str_copy(pError, sqlite3_errmsg(m_pDb), ErrorSize);
 		return true;
 	}
 	return false;
@@ -360,6 +444,36 @@ bool CSqliteConnection::AddPoints(const char *pPlayer, int Points, char *pError,
 	return false;
 }
 
+bool CSqliteConnection::AddPvpStats(const CPvpStatsRow *pRows, int NumRows, char *pError, int ErrorSize)
+{
+	// take the write lock right away, upgrading a read lock can fail
+	// without waiting for the busy timeout
+	if(Execute("BEGIN IMMEDIATE", pError, ErrorSize))
+	{
+		return true;
+	}
+	for(int i = 0; i < NumRows; i += PVPSTATS_ROWS_PER_STATEMENT)
+	{
+		int Num = minimum(NumRows - i, (int)PVPSTATS_ROWS_PER_STATEMENT);
+		char aBuf[8192];
+		FormatAddPvpStats(aBuf, sizeof(aBuf), Num, "ON CONFLICT(Name, Mode) DO UPDATE SET", "excluded.", "");
+		int NumUpdated;
+		char aError[256];
+		if(PrepareStatement(aBuf, pError, ErrorSize))
+		{
+			Execute("ROLLBACK", aError, sizeof(aError));
+			return true;
+		}
+		BindPvpStats(pRows + i, Num);
+		if(ExecuteUpdate(&NumUpdated, pError, ErrorSize))
+		{
+			Execute("ROLLBACK", aError, sizeof(aError));
+			return true;
+		}
+	}
+	return Execute("COMMIT", pError, ErrorSize);
+}
+
 IDbConnection *CreateSqliteConnection(const char *pFilename, bool Setup)
 {
 	return new CSqliteConnection(pFilename, Setup);
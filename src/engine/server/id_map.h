@@ -0,0 +1,69 @@
+#ifndef ENGINE_SERVER_ID_MAP_H
+#define ENGINE_SERVER_ID_MAP_H
+
+#include <base/math.h>
+#include <engine/shared/protocol.h>
+
+// the client ids a viewer limited to VANILLA_MAX_CLIENTS slots sees, with the
+// slot of each client id next to it so both directions are array reads
+class CIdMap
+{
+	int m_aMap[VANILLA_MAX_CLIENTS];
+	int m_aReverse[MAX_CLIENTS];
+	// sixup and DDNet clients see the real client ids
+	bool m_NoTranslation;
+
+public:
+	CIdMap()
+	{
+		Clear();
+		m_NoTranslation = false;
+	}
+
+	void Clear()
+	{
+		for(int &ID : m_aMap)
+			ID = -1;
+		UpdateReverse();
+	}
+
+	// the client id shown in each slot, -1 if the slot is empty
+	int *Map() { return m_aMap; }
+	// call after changing the map
+	void UpdateReverse()
+	{
+		for(int &Slot : m_aReverse)
+			Slot = -1;
+		for(int i = 0; i < VANILLA_MAX_CLIENTS; i++)
+			if(m_aMap[i] != -1)
+				m_aReverse[m_aMap[i]] = i;
+	}
+
+	void SetNoTranslation(bool NoTranslation) { m_NoTranslation = NoTranslation; }
+	bool NeedsTranslation() const { return !m_NoTranslation; }
+
+	// client id to slot, false if the client isn't shown
+	bool Translate(int &Target) const
+	{
+		if(m_NoTranslation)
+			return true;
+		if(Target < 0 || Target >= MAX_CLIENTS || m_aReverse[Target] == -1)
+			return false;
+		Target = m_aReverse[Target];
+		return true;
+	}
+
+	// slot to client id, false if the slot is empty
+	bool ReverseTranslate(int &Target) const
+	{
+		if(m_NoTranslation)
+			return true;
+		Target = clamp(Target, 0, VANILLA_MAX_CLIENTS - 1);
+		if(m_aMap[Target] == -1)
+			return false;
+		Target = m_aMap[Target];
+		return true;
+	}
+};
+
+#endif
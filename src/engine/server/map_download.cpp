@@ -0,0 +1,105 @@
+#include "map_download.h"
+
+#include <base/math.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+
+void CMapChunks::Init(const unsigned char *pMap, unsigned MapSize, unsigned Crc, bool Sixup)
+{
+	Clear();
+	int NumChunks = (MapSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	if(NumChunks == 0)
+		NumChunks = 1;
+	m_vData.reserve(MapSize + NumChunks * 32);
+	m_vOffsets.reserve(NumChunks + 1);
+
+	CPacker Packer;
+	for(int Chunk = 0; Chunk < NumChunks; Chunk++)
+	{
+		Pack(&Packer, pMap, MapSize, Crc, Chunk, Sixup);
+		m_vOffsets.push_back(m_vData.size());
+		m_vData.insert(m_vData.end(), Packer.Data(), Packer.Data() + Packer.Size());
+	}
+	m_vOffsets.push_back(m_vData.size());
+}
+
+void CMapChunks::Pack(CPacker *pPacker, const unsigned char *pMap, unsigned MapSize, unsigned Crc, int Chunk, bool Sixup)
+{
+	unsigned Offset = Chunk * CHUNK_SIZE;
+	unsigned ChunkSize = minimum((unsigned)CHUNK_SIZE, MapSize - Offset);
+	int Last = Offset + ChunkSize >= MapSize;
+
+	// what RepackMsg() makes of the message, NETMSG_MAP_DATA keeps its id
+	// for 0.7
+	pPacker->Reset();
+	pPacker->AddInt((NETMSG_MAP_DATA << 1) | 1);
+	if(!Sixup)
+	{
+		pPacker->AddInt(Last);
+		pPacker->AddInt(Crc);
+		pPacker->AddInt(Chunk);
+		pPacker->AddInt(ChunkSize);
+	}
+	pPacker->AddRaw(pMap + Offset, ChunkSize);
+}
+
+void CMapChunks::Clear()
+{
+	m_vData.clear();
+	m_vOffsets.clear();
+}
+
+void CMapDownload::Reset(int InitialWindow, int MinWindow)
+{
+	m_MinWindow = clamp(MinWindow, (int)MIN_WINDOW, (int)MAX_WINDOW);
+	m_Window = clamp(InitialWindow, m_MinWindow, (int)MAX_WINDOW);
+	m_Sent = 0;
+	m_Received = 0;
+	m_GrowCredit = 0;
+	m_ShrinkMark = 0;
+	m_MinRtt = -1;
+	m_Rtt = 0;
+}
+
+void CMapDownload::OnRtt(int64 Rtt)
+{
+	m_MinRtt = m_MinRtt < 0 ? Rtt : minimum(m_MinRtt, Rtt);
+	m_Rtt = m_Rtt == 0 ? Rtt : (m_Rtt * 7 + Rtt) / 8;
+
+	// some slack for the jitter of fast connections
+	int64 Slack = maximum(m_MinRtt / 2, time_freq() / 100);
+	if(Rtt <= m_MinRtt + Slack)
+	{
+		// one more chunk per round trip
+		if(++m_GrowCredit >= m_Window)
+		{
+			m_GrowCredit = 0;
+			m_Window = minimum(m_Window + 1, (int)MAX_WINDOW);
+		}
+	}
+	else if(Rtt > 2 * m_MinRtt + Slack && m_Received > m_ShrinkMark)
+	{
+		// once per round trip, the chunks in flight still carry the old delay
+		m_GrowCredit = 0;
+		m_Window = maximum(m_Window * 3 / 4, m_MinWindow);
+		m_ShrinkMark = m_Sent;
+	}
+}
+
+int CMapDownload::OnRequest(int Received, int NumChunks, int64 Now)
+{
+	if(Received > m_Received && Received <= m_Sent)
+	{
+		m_Received = Received;
+		// the last chunk the client got was sent this long ago
+		if(m_Sent - Received < NUM_SEND_TIMES)
+			OnRtt(Now - m_aSendTimes[(Received - 1) % NUM_SEND_TIMES]);
+	}
+	return minimum(m_Received + m_Window, NumChunks);
+}
+
+void CMapDownload::OnSent(int Chunk, int64 Now)
+{
+	m_aSendTimes[Chunk % NUM_SEND_TIMES] = Now;
+	m_Sent = maximum(m_Sent, Chunk + 1);
+}
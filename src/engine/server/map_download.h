@@ -0,0 +1,87 @@
+#ifndef ENGINE_SERVER_MAP_DOWNLOAD_H
+#define ENGINE_SERVER_MAP_DOWNLOAD_H
+
+#include <base/system.h>
+
+#include <vector>
+
+class CPacker;
+
+// The NETMSG_MAP_DATA messages of a map, packed once when the map is
+// loaded so they can be handed to the network as they are.
+class CMapChunks
+{
+	std::vector<unsigned char> m_vData;
+	std::vector<int> m_vOffsets;
+
+public:
+	enum
+	{
+		CHUNK_SIZE = 1024 - 128,
+	};
+
+	// the 0.6 messages carry their position in the map, the 0.7 ones only
+	// the map data
+	void Init(const unsigned char *pMap, unsigned MapSize, unsigned Crc, bool Sixup);
+	void Clear();
+	// packs a single message the way the server sends it
+	static void Pack(CPacker *pPacker, const unsigned char *pMap, unsigned MapSize, unsigned Crc, int Chunk, bool Sixup);
+
+	int NumChunks() const { return (int)m_vOffsets.size() - 1; }
+	const unsigned char *Data(int Chunk) const { return &m_vData[m_vOffsets[Chunk]]; }
+	int Size(int Chunk) const { return m_vOffsets[Chunk + 1] - m_vOffsets[Chunk]; }
+};
+
+// Paces the map download of one client. The number of chunks in flight
+// grows while the round trip times stay close to the lowest one seen and
+// shrinks once they rise, i.e. once the chunks start queueing up.
+class CMapDownload
+{
+public:
+	enum
+	{
+		// the unacknowledged chunks have to fit into the resend buffer
+		// of the connection
+		MIN_WINDOW = 1,
+		MAX_WINDOW = 30,
+	};
+
+private:
+	enum
+	{
+		NUM_SEND_TIMES = 64,
+	};
+
+	int m_Window;
+	int m_MinWindow;
+	int m_Sent;
+	int m_Received;
+	int m_GrowCredit;
+	int m_ShrinkMark;
+	int64 m_MinRtt;
+	int64 m_Rtt;
+	int64 m_aSendTimes[NUM_SEND_TIMES];
+
+	void OnRtt(int64 Rtt);
+
+public:
+	CMapDownload() { Reset(MIN_WINDOW); }
+
+	// 0.7 clients ask for a fixed number of chunks at a time, the window
+	// may not fall below that
+	void Reset(int InitialWindow, int MinWindow = MIN_WINDOW);
+
+	// the client has all chunks before Received, returns the end of the
+	// chunks to send next, starting at Sent()
+	int OnRequest(int Received, int NumChunks, int64 Now);
+	void OnSent(int Chunk, int64 Now);
+
+	int Window() const { return m_Window; }
+	int MinWindow() const { return m_MinWindow; }
+	int Sent() const { return m_Sent; }
+	int Received() const { return m_Received; }
+	// smoothed round trip time, 0 before the first sample
+	int64 Rtt() const { return m_Rtt; }
+};
+
+#endif
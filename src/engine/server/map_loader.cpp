@@ -0,0 +1,107 @@
+#include "map_loader.h"
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+#include <game/layers.h>
+
+#include <zlib.h>
+
+CMapLoadJob::CMapLoadJob(IStorage *pStorage, const char *pMapName, bool Sixup) :
+	m_pStorage(pStorage),
+	m_Sixup(Sixup),
+	m_pMap(CreateEngineMap()),
+	m_Success(false),
+	m_LoadTime(0),
+	m_pData(nullptr),
+	m_SixupLoaded(false),
+	m_pSixupData(nullptr),
+	m_SixupSize(0),
+	m_SixupCrc(0)
+{
+	str_copy(m_aMapName, pMapName, sizeof(m_aMapName));
+	m_SixupSha256 = SHA256_ZEROED;
+}
+
+CMapLoadJob::~CMapLoadJob()
+{
+	free(m_pData);
+	free(m_pSixupData);
+	delete m_pMap;
+}
+
+unsigned char *CMapLoadJob::ReleaseData()
+{
+	unsigned char *pData = m_pData;
+	m_pData = nullptr;
+	return pData;
+}
+
+unsigned char *CMapLoadJob::ReleaseSixupData()
+{
+	unsigned char *pData = m_pSixupData;
+	m_pSixupData = nullptr;
+	return pData;
+}
+
+void CMapLoadJob::Run()
+{
+	int64 Start = time_get_impl();
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf), "maps/%s.map", m_aMapName);
+	if(!m_pMap->Load(m_pStorage, aBuf))
+		return;
+
+	unsigned Size = m_pMap->FileSize();
+	m_pData = (unsigned char *)malloc(maximum(Size, 1u));
+	mem_copy(m_pData, m_pMap->FileData(), Size);
+	if(crc32(0, m_pData, Size) != m_pMap->Crc())
+	{
+		dbg_msg("maploader", "map '%s' changed while loading", aBuf);
+		return;
+	}
+
+	// decompress the layers the collision is built from, the game only has
+	// to pick them up after the swap
+	CLayers Layers;
+	Layers.Init(m_pMap);
+	if(!Layers.GameLayer())
+	{
+		dbg_msg("maploader", "map '%s' has no game layer", aBuf);
+		return;
+	}
+	m_pMap->GetData(Layers.GameLayer()->m_Data);
+	if(Layers.TeleLayer())
+		m_pMap->GetData(Layers.TeleLayer()->m_Tele);
+	if(Layers.SpeedupLayer())
+		m_pMap->GetData(Layers.SpeedupLayer()->m_Speedup);
+	if(Layers.FrontLayer())
+		m_pMap->GetData(Layers.FrontLayer()->m_Front);
+	if(Layers.SwitchLayer())
+		m_pMap->GetData(Layers.SwitchLayer()->m_Switch);
+	if(Layers.TuneLayer())
+		m_pMap->GetData(Layers.TuneLayer()->m_Tune);
+
+	if(m_Sixup)
+	{
+		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", m_aMapName);
+		IOHANDLE File = m_pStorage->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
+		if(File)
+		{
+			m_SixupSize = (unsigned)io_length(File);
+			m_pSixupData = (unsigned char *)malloc(maximum(m_SixupSize, 1u));
+			m_SixupLoaded = io_read(File, m_pSixupData, m_SixupSize) == m_SixupSize;
+			io_close(File);
+			if(m_SixupLoaded)
+			{
+				m_SixupSha256 = sha256(m_pSixupData, m_SixupSize);
+				m_SixupCrc = crc32(0, m_pSixupData, m_SixupSize);
+			}
+		}
+	}
+
+	m_Success = true;
+	m_LoadTime = time_get_impl() - Start;
+}
@@ -0,0 +1,54 @@
+#ifndef ENGINE_SERVER_MAP_LOADER_H
+#define ENGINE_SERVER_MAP_LOADER_H
+
+#include <base/hash.h>
+#include <engine/shared/jobs.h>
+
+class IEngineMap;
+class IStorage;
+
+// Loads a map off the main thread: the datafile with its hashes, the tile
+// data of the collision layers and optionally the 0.7 version of the map.
+// Once the job is done the server swaps the result in at a tick boundary.
+class CMapLoadJob : public IJob
+{
+	IStorage *m_pStorage;
+	char m_aMapName[128];
+	bool m_Sixup;
+
+	IEngineMap *m_pMap;
+	bool m_Success;
+	int64 m_LoadTime;
+	// the map file for downloads, the map itself reads from a mapping that
+	// changes with the file on disk
+	unsigned char *m_pData;
+
+	bool m_SixupLoaded;
+	unsigned char *m_pSixupData;
+	unsigned m_SixupSize;
+	SHA256_DIGEST m_SixupSha256;
+	unsigned m_SixupCrc;
+
+	virtual void Run();
+
+public:
+	CMapLoadJob(IStorage *pStorage, const char *pMapName, bool Sixup);
+	virtual ~CMapLoadJob();
+
+	// only valid once the job is done
+	const char *MapName() const { return m_aMapName; }
+	bool Success() const { return m_Success; }
+	IEngineMap *Map() { return m_pMap; }
+	int64 LoadTime() const { return m_LoadTime; }
+	// hands a copy of the map file over to the caller, it has to be freed with free()
+	unsigned char *ReleaseData();
+
+	bool SixupLoaded() const { return m_SixupLoaded; }
+	// hands the 0.7 map data over to the caller, it has to be freed with free()
+	unsigned char *ReleaseSixupData();
+	unsigned SixupSize() const { return m_SixupSize; }
+	SHA256_DIGEST SixupSha256() const { return m_SixupSha256; }
+	unsigned SixupCrc() const { return m_SixupCrc; }
+};
+
+#endif
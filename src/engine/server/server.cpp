@@ -23,14 +23,17 @@
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
 #include <engine/shared/filecollection.h>
+#include <engine/shared/metrics.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/protocol_ex.h>
 #include <engine/shared/snapshot.h>
 
 // DDRace
+#include <algorithm>
 #include <cstring>
 #include <engine/shared/linereader.h>
 #include <game/extrainfo.h>
@@ -46,92 +49,13 @@
 #include <windows.h>
 #endif
 
-CSnapIDPool::CSnapIDPool()
-{
-	Reset();
-}
-
-void CSnapIDPool::Reset()
-{
-	for(int i = 0; i < MAX_IDS; i++)
-	{
-		m_aIDs[i].m_Next = i + 1;
-		m_aIDs[i].m_State = 0;
-	}
-
-	m_aIDs[MAX_IDS - 1].m_Next = -1;
-	m_FirstFree = 0;
-	m_FirstTimed = -1;
-	m_LastTimed = -1;
-	m_Usage = 0;
-	m_InUsage = 0;
-}
-
-void CSnapIDPool::RemoveFirstTimeout()
-{
-	int NextTimed = m_aIDs[m_FirstTimed].m_Next;
-
-	// add it to the free list
-	m_aIDs[m_FirstTimed].m_Next = m_FirstFree;
-	m_aIDs[m_FirstTimed].m_State = 0;
-	m_FirstFree = m_FirstTimed;
-
-	// remove it from the timed list
-	m_FirstTimed = NextTimed;
-	if(m_FirstTimed == -1)
-		m_LastTimed = -1;
-
-	m_Usage--;
-}
-
-int CSnapIDPool::NewID()
-{
-	int64 Now = time_get();
-
-	// process timed ids
-	while(m_FirstTimed != -1 && m_aIDs[m_FirstTimed].m_Timeout < Now)
-		RemoveFirstTimeout();
-
-	int ID = m_FirstFree;
-	dbg_assert(ID != -1, "id error");
-	if(ID == -1)
-		return ID;
-	m_FirstFree = m_aIDs[m_FirstFree].m_Next;
-	m_aIDs[ID].m_State = 1;
-	m_Usage++;
-	m_InUsage++;
-	return ID;
-}
-
-void CSnapIDPool::TimeoutIDs()
-{
-	// process timed ids
-	while(m_FirstTimed != -1)
-		RemoveFirstTimeout();
-}
-
-void CSnapIDPool::FreeID(int ID)
-{
-	if(ID < 0)
-		return;
-	dbg_assert(m_aIDs[ID].m_State == 1, "id is not allocated");
-
-	m_InUsage--;
-	m_aIDs[ID].m_State = 2;
-	m_aIDs[ID].m_Timeout = time_get() + time_freq() * 5;
-	m_aIDs[ID].m_Next = -1;
-
-	if(m_LastTimed != -1)
-	{
-		m_aIDs[m_LastTimed].m_Next = ID;
-		m_LastTimed = ID;
-	}
-	else
-	{
-		m_FirstTimed = ID;
-		m_LastTimed = ID;
-	}
-}
+static const int64 s_aTickDurationBounds[] = {250, 500, 1000, 2000, 5000, 10000, 20000, 50000};
+static CMetricHistogram s_MetricTickDuration("ddnet_tick_duration_seconds", "Time spent in the game tick",
+	s_aTickDurationBounds, sizeof(s_aTickDurationBounds) / sizeof(s_aTickDurationBounds[0]), 1000000.0);
+static const int64 s_aSnapshotSizeBounds[] = {64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384};
+static CMetricHistogram s_MetricSnapshotSize("ddnet_snapshot_size_bytes", "Compressed size of the snapshots sent to a client",
+	s_aSnapshotSizeBounds, sizeof(s_aSnapshotSizeBounds) / sizeof(s_aSnapshotSizeBounds[0]));
+static CMetricCounter s_MetricSnapItemsDropped("ddnet_snapshot_items_dropped_total", "Snapshot items left out to stay inside sv_snap_budget");
 
 void CServerBan::InitServerBan(IConsole *pConsole, IStorage *pStorage, CServer *pServer)
 {
@@ -273,11 +197,12 @@ void CServer::CClient::Reset()
 	mem_zero(&m_LatestInput, sizeof(m_LatestInput));
 
 	m_Snapshots.PurgeAll();
+	m_SnapshotBytes = 0;
+	mem_zero(&m_SnapStats, sizeof(m_SnapStats));
 	m_LastAckedSnapshot = -1;
 	m_LastInputTick = -1;
 	m_SnapRate = CClient::SNAPRATE_INIT;
 	m_Score = 0;
-	m_NextMapChunk = 0;
 	m_Flags = 0;
 	m_DDNetVersion = VERSION_NONE;
 	m_GotDDNetVersionPacket = false;
@@ -288,8 +213,10 @@ CServer::CServer() :
 	m_Register(false), m_RegSixup(true)
 {
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
-	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false);
+		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true, &m_DemoWriter);
+	m_aDemoRecorder[MAX_CLIENTS] = CDemoRecorder(&m_SnapshotDelta, false, &m_DemoWriter);
+	for(auto &Recorder : m_aRoomDemoRecorder)
+		Recorder = CDemoRecorder(&m_SnapshotDelta, true, &m_DemoWriter);
 
 	m_TickSpeed = SERVER_TICK_SPEED;
 
@@ -312,6 +239,8 @@ CServer::CServer() :
 
 	m_RconRestrict = -1;
 
+	ResetSnapStats();
+
 	m_ServerInfoFirstRequest = 0;
 	m_ServerInfoNumRequests = 0;
 	m_ServerInfoNeedsUpdate = false;
@@ -329,11 +258,8 @@ CServer::CServer() :
 
 CServer::~CServer()
 {
-	for(auto &pCurrentMapData : m_apCurrentMapData)
-	{
-		if(pCurrentMapData)
-			free(pCurrentMapData);
-	}
+	free((void *)m_apCurrentMapData[SIX]);
+	free((void *)m_apCurrentMapData[SIXUP]);
 
 	delete m_pConnectionPool;
 }
@@ -526,6 +452,12 @@ int CServer::Init()
 		Client.m_DisruptiveLeave = false;
 	}
 
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aIdMaps[i].Clear();
+		UpdateIdTranslation(i);
+	}
+
 	m_CurrentGameTick = 0;
 
 	m_AnnouncementLastLine = 0;
@@ -588,9 +520,15 @@ void CServer::SetClientDDNetVersion(int ClientID, int DDNetVersion)
 	{
 		m_aClients[ClientID].m_DDNetVersion = DDNetVersion;
 		m_aClients[ClientID].m_DDNetVersionSettled = true;
+		UpdateIdTranslation(ClientID);
 	}
 }
 
+void CServer::UpdateIdTranslation(int ClientID)
+{
+	m_aIdMaps[ClientID].SetNoTranslation(m_aClients[ClientID].m_Sixup || m_aClients[ClientID].m_DDNetVersion >= VERSION_DDNET_OLD);
+}
+
 void CServer::GetClientAddr(int ClientID, char *pAddrStr, int Size) const
 {
 	if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME)
@@ -828,6 +766,8 @@ void CServer::SendMsgRaw(int ClientID, const void *pData, int Size, int Flags)
 
 void CServer::DoSnapshot()
 {
+	PROFILE_SCOPE("DoSnapshot");
+
 	GameServer()->OnPreSnap();
 
 	// create snapshot for demo recording
@@ -849,6 +789,24 @@ void CServer::DoSnapshot()
 		m_aDemoRecorder[MAX_CLIENTS].RecordSnapshot(Tick(), aExtraInfoRemoved, SnapshotSize);
 	}
 
+	// create snapshots for room demos, one per room instead of one per player
+	for(int Room = 0; Room < MAX_CLIENTS; Room++)
+	{
+		if(!m_aRoomDemoRecorder[Room].IsRecording())
+			continue;
+
+		PROFILE_SCOPE("room demo", Room);
+		char aData[CSnapshot::MAX_SIZE];
+		m_SnapshotBuilder.Init();
+		GameServer()->OnSnapRoom(Room);
+		int SnapshotSize = m_SnapshotBuilder.Finish(aData);
+
+		unsigned char aExtraInfoRemoved[CSnapshot::MAX_SIZE];
+		mem_copy(aExtraInfoRemoved, aData, SnapshotSize);
+		SnapshotRemoveExtraInfo(aExtraInfoRemoved);
+		m_aRoomDemoRecorder[Room].RecordSnapshot(Tick(), aExtraInfoRemoved, SnapshotSize);
+	}
+
 	// create snapshots for all clients
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -877,12 +835,27 @@ void CServer::DoSnapshot()
 			int DeltaTick = -1;
 			int DeltaSize;
 
-			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
+			{
+				PROFILE_SCOPE("snap build", i);
+				m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
+				m_SnapshotBuilder.SetBudget(g_Config.m_SvSnapBudget ? g_Config.m_SvSnapBudget : (int)CSnapshot::MAX_SIZE,
+					g_Config.m_SvSnapBudgetItems ? g_Config.m_SvSnapBudgetItems : (int)CSnapshotBuilder::MAX_ITEMS);
 
-			GameServer()->OnSnap(i);
+				GameServer()->OnSnap(i);
 
-			// finish snapshot
-			SnapshotSize = m_SnapshotBuilder.Finish(pData);
+				// finish snapshot
+				SnapshotSize = m_SnapshotBuilder.Finish(pData);
+			}
+
+			if(m_SnapshotBuilder.NumDropped())
+			{
+				s_MetricSnapItemsDropped.Add(m_SnapshotBuilder.NumDropped());
+				if(g_Config.m_SvSnapStats)
+				{
+					m_aClients[i].m_SnapStats.m_NumDropped += m_SnapshotBuilder.NumDropped();
+					m_aRoomSnapStats[clamp(GameServer()->GetClientRoom(i), 0, (int)MAX_CLIENTS)].m_NumDropped += m_SnapshotBuilder.NumDropped();
+				}
+			}
 
 			if(m_aDemoRecorder[i].IsRecording())
 			{
@@ -921,7 +894,12 @@ void CServer::DoSnapshot()
 			// create delta
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			{
+				PROFILE_SCOPE("snap delta", i);
+				m_SnapshotDelta.SetDataRateAccounting(g_Config.m_SvSnapStats, m_aClients[i].m_Sixup);
+				DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+				m_SnapshotDelta.SetDataRateAccounting(false);
+			}
 
 			if(DeltaSize)
 			{
@@ -930,9 +908,21 @@ void CServer::DoSnapshot()
 				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
 				int NumPackets;
 
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				{
+					PROFILE_SCOPE("snap compress", i);
+					SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				}
+				s_MetricSnapshotSize.Observe(SnapshotSize);
+				m_aClients[i].m_SnapshotBytes += SnapshotSize;
 				NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
 
+				if(g_Config.m_SvSnapStats)
+				{
+					m_aClients[i].m_SnapStats.Add(SnapshotSize, NumPackets);
+					m_aRoomSnapStats[clamp(GameServer()->GetClientRoom(i), 0, (int)MAX_CLIENTS)].Add(SnapshotSize, NumPackets);
+				}
+
+				PROFILE_SCOPE("snap send", i);
 				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
 				{
 					int Chunk = Left < MaxSize ? Left : MaxSize;
@@ -984,6 +974,7 @@ int CServer::ClientRejoinCallback(int ClientID, void *pUser)
 	pThis->m_aClients[ClientID].m_pRconCmdToSend = 0;
 
 	pThis->m_aClients[ClientID].Reset();
+	pThis->UpdateIdTranslation(ClientID);
 
 	pThis->SendMap(ClientID);
 
@@ -1008,6 +999,7 @@ int CServer::NewClientNoAuthCallback(int ClientID, void *pUser)
 	pThis->m_aClients[ClientID].m_ShowIps = false;
 	pThis->m_aClients[ClientID].m_DisruptiveLeave = false;
 	pThis->m_aClients[ClientID].Reset();
+	pThis->UpdateIdTranslation(ClientID);
 
 	pThis->SendCapabilities(ClientID);
 	pThis->SendMap(ClientID);
@@ -1041,6 +1033,7 @@ int CServer::NewClientCallback(int ClientID, void *pUser, bool Sixup)
 	pThis->Antibot()->OnEngineClientJoin(ClientID, Sixup);
 
 	pThis->m_aClients[ClientID].m_Sixup = Sixup;
+	pThis->UpdateIdTranslation(ClientID);
 
 #if defined(CONF_FAMILY_UNIX)
 	pThis->SendConnLoggingCommand(OPEN_SESSION, pThis->m_NetServer.ClientAddr(ClientID));
@@ -1130,6 +1123,7 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	pThis->m_aPrevStates[ClientID] = CClient::STATE_EMPTY;
 	pThis->m_aClients[ClientID].m_Snapshots.PurgeAll();
 	pThis->m_aClients[ClientID].m_Sixup = false;
+	pThis->UpdateIdTranslation(ClientID);
 
 	pThis->GameServer()->OnClientEngineDrop(ClientID, pReason);
 	pThis->Antibot()->OnEngineClientDrop(ClientID, pReason);
@@ -1180,48 +1174,41 @@ void CServer::SendMap(int ClientID)
 		Msg.AddInt(m_aCurrentMapSize[Sixup]);
 		if(Sixup)
 		{
-			Msg.AddInt(g_Config.m_SvMapWindow);
-			Msg.AddInt(1024 - 128);
+			Msg.AddInt(clamp(g_Config.m_SvMapWindow, (int)CMapDownload::MIN_WINDOW, (int)CMapDownload::MAX_WINDOW));
+			Msg.AddInt(CMapChunks::CHUNK_SIZE);
 			Msg.AddRaw(m_aCurrentMapSha256[Sixup].data, sizeof(m_aCurrentMapSha256[Sixup].data));
 		}
 		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientID);
 	}
 
-	m_aClients[ClientID].m_NextMapChunk = 0;
+	// 0.7 clients request the announced number of chunks at a time
+	if(Sixup)
+		m_aClients[ClientID].m_MapDownload.Reset(g_Config.m_SvMapWindow, g_Config.m_SvMapWindow);
+	else
+		m_aClients[ClientID].m_MapDownload.Reset(g_Config.m_SvMapWindow);
 }
 
 void CServer::SendMapData(int ClientID, int Chunk)
 {
-	int Sixup = IsSixup(ClientID);
-	unsigned int ChunkSize = 1024 - 128;
-	unsigned int Offset = Chunk * ChunkSize;
-	int Last = 0;
+	const CMapChunks &Chunks = m_aMapChunks[IsSixup(ClientID)];
 
 	// drop faulty map data requests
-	if(Chunk < 0 || Offset > m_aCurrentMapSize[Sixup])
+	if(Chunk < 0 || Chunk >= Chunks.NumChunks())
 		return;
 
-	if(Offset + ChunkSize >= m_aCurrentMapSize[Sixup])
-	{
-		ChunkSize = m_aCurrentMapSize[Sixup] - Offset;
-		Last = 1;
-	}
-
-	CMsgPacker Msg(NETMSG_MAP_DATA, true);
-	if(!Sixup)
-	{
-		Msg.AddInt(Last);
-		Msg.AddInt(m_aCurrentMapCrc[SIX]);
-		Msg.AddInt(Chunk);
-		Msg.AddInt(ChunkSize);
-	}
-	Msg.AddRaw(&m_apCurrentMapData[Sixup][Offset], ChunkSize);
-	SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientID);
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(CNetChunk));
+	Packet.m_ClientID = ClientID;
+	Packet.m_Flags = NETSENDFLAG_VITAL | NETSENDFLAG_FLUSH;
+	Packet.m_pData = Chunks.Data(Chunk);
+	Packet.m_DataSize = Chunks.Size(Chunk);
+	m_NetServer.Send(&Packet);
+	m_aClients[ClientID].m_MapDownload.OnSent(Chunk, time_get());
 
 	if(g_Config.m_Debug)
 	{
 		char aBuf[256];
-		str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, ChunkSize);
+		str_format(aBuf, sizeof(aBuf), "sending chunk %d with size %d", Chunk, Chunks.Size(Chunk));
 		Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBuf);
 	}
 }
@@ -1403,6 +1390,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				}
 				m_aClients[ClientID].m_ConnectionID = *pConnectionID;
 				m_aClients[ClientID].m_DDNetVersion = DDNetVersion;
+				UpdateIdTranslation(ClientID);
 				str_copy(m_aClients[ClientID].m_aDDNetVersionStr, pDDNetVersionStr, sizeof(m_aClients[ClientID].m_aDDNetVersionStr));
 				m_aClients[ClientID].m_DDNetVersionSettled = true;
 				m_aClients[ClientID].m_GotDDNetVersionPacket = true;
@@ -1457,31 +1445,30 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			if((pPacket->m_Flags & NET_CHUNKFLAG_VITAL) == 0 || m_aClients[ClientID].m_State < CClient::STATE_CONNECTING)
 				return;
 
+			CMapDownload *pDownload = &m_aClients[ClientID].m_MapDownload;
+			int NumChunks = m_aMapChunks[IsSixup(ClientID)].NumChunks();
+			int Received;
 			if(m_aClients[ClientID].m_Sixup)
 			{
-				for(int i = 0; i < g_Config.m_SvMapWindow; i++)
-				{
-					SendMapData(ClientID, m_aClients[ClientID].m_NextMapChunk++);
-				}
-				return;
+				// 0.7 clients ask again after every window they got
+				Received = pDownload->Sent() ? pDownload->Received() + pDownload->MinWindow() : 0;
 			}
-
-			int Chunk = Unpacker.GetInt();
-			if(Chunk != m_aClients[ClientID].m_NextMapChunk || !g_Config.m_SvFastDownload)
-			{
-				SendMapData(ClientID, Chunk);
-				return;
-			}
-
-			if(Chunk == 0)
+			else
 			{
-				for(int i = 0; i < g_Config.m_SvMapWindow; i++)
+				int Chunk = Unpacker.GetInt();
+				bool InOrder = Chunk > pDownload->Received() || (Chunk == 0 && pDownload->Sent() == 0);
+				if(!InOrder || Chunk > pDownload->Sent() || !g_Config.m_SvFastDownload)
 				{
-					SendMapData(ClientID, i);
+					SendMapData(ClientID, Chunk);
+					return;
 				}
+				Received = Chunk;
 			}
-			SendMapData(ClientID, g_Config.m_SvMapWindow + m_aClients[ClientID].m_NextMapChunk);
-			m_aClients[ClientID].m_NextMapChunk++;
+
+			// send ahead as far as the window allows
+			int End = pDownload->OnRequest(Received, NumChunks, time_get());
+			for(int Chunk = pDownload->Sent(); Chunk < End; Chunk++)
+				SendMapData(ClientID, Chunk);
 		}
 		else if(Msg == NETMSG_READY)
 		{
@@ -1591,6 +1578,7 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 				if(GameServer()->PlayerExists(ClientID) && Version < VERSION_DDNET_OLD)
 				{
 					m_aClients[ClientID].m_DDNetVersion = VERSION_DDNET_OLD;
+					UpdateIdTranslation(ClientID);
 				}
 			}
 			else if((pPacket->m_Flags & NET_CHUNKFLAG_VITAL) != 0 && Unpacker.Error() == 0 && m_aClients[ClientID].m_Authed)
@@ -2193,6 +2181,8 @@ void CServer::UpdateServerInfo(bool Resend)
 
 void CServer::PumpNetwork(bool PacketWaiting)
 {
+	PROFILE_SCOPE("PumpNetwork");
+
 	CNetChunk Packet;
 	SECURITY_TOKEN ResponseToken;
 
@@ -2296,12 +2286,24 @@ void CServer::ChangeMap(const char *pMap)
 
 int CServer::LoadMap(const char *pMapName)
 {
-	char aBuf[512];
-	str_format(aBuf, sizeof(aBuf), "maps/%s.map", pMapName);
+	CMapLoadJob Job(Storage(), pMapName, g_Config.m_SvSixup);
+	IEngine::RunJobBlocking(&Job);
+	return SwapMap(&Job);
+}
 
-	if(!m_pMap->Load(aBuf))
+void CServer::StartMapLoad(const char *pMapName)
+{
+	m_pMapLoadJob = std::make_shared<CMapLoadJob>(Storage(), pMapName, g_Config.m_SvSixup);
+	Kernel()->RequestInterface<IEngine>()->AddJob(m_pMapLoadJob);
+}
+
+int CServer::SwapMap(CMapLoadJob *pJob)
+{
+	if(!pJob->Success())
 		return 0;
 
+	int64 SwapStart = time_get_impl();
+
 	// stop recording when we change map
 	for(int i = 0; i < MAX_CLIENTS + 1; i++)
 	{
@@ -2319,36 +2321,39 @@ int CServer::LoadMap(const char *pMapName)
 		}
 	}
 
+	for(auto &Recorder : m_aRoomDemoRecorder)
+		if(Recorder.IsRecording())
+			Recorder.Stop();
+
+	// the previous map stays with the job until it is destroyed
+	m_pMap->Swap(pJob->Map());
+
 	// reinit snapshot ids
 	m_IDPool.TimeoutIDs();
 
 	// get the crc of the map
 	m_aCurrentMapSha256[SIX] = m_pMap->Sha256();
 	m_aCurrentMapCrc[SIX] = m_pMap->Crc();
+	char aBuf[512];
 	char aBufMsg[256];
 	char aSha256[SHA256_MAXSTRSIZE];
+	str_format(aBuf, sizeof(aBuf), "maps/%s.map", pJob->MapName());
 	sha256_str(m_aCurrentMapSha256[SIX], aSha256, sizeof(aSha256));
 	str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
-	str_copy(m_aCurrentMap, pMapName, sizeof(m_aCurrentMap));
+	str_copy(m_aCurrentMap, pJob->MapName(), sizeof(m_aCurrentMap));
 
-	// load complete map into memory for download
-	{
-		IOHANDLE File = Storage()->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
-		m_aCurrentMapSize[SIX] = (unsigned int)io_length(File);
-		free(m_apCurrentMapData[SIX]);
-		m_apCurrentMapData[SIX] = (unsigned char *)malloc(m_aCurrentMapSize[SIX]);
-		io_read(File, m_apCurrentMapData[SIX], m_aCurrentMapSize[SIX]);
-		io_close(File);
-	}
+	free((void *)m_apCurrentMapData[SIX]);
+	m_apCurrentMapData[SIX] = pJob->ReleaseData();
+	m_aCurrentMapSize[SIX] = m_pMap->FileSize();
+	m_aMapChunks[SIX].Init(m_apCurrentMapData[SIX], m_aCurrentMapSize[SIX], m_aCurrentMapCrc[SIX], false);
 
-	// load sixup version of the map
+	// take over the sixup version of the map
 	if(g_Config.m_SvSixup)
 	{
-		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pMapName);
-		IOHANDLE File = Storage()->OpenFile(aBuf, IOFLAG_READ, IStorage::TYPE_ALL);
-		if(!File)
+		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pJob->MapName());
+		if(!pJob->SixupLoaded())
 		{
 			g_Config.m_SvSixup = 0;
 			dbg_msg("sixup", "couldn't load map %s", aBuf);
@@ -2356,14 +2361,12 @@ int CServer::LoadMap(const char *pMapName)
 		}
 		else
 		{
-			m_aCurrentMapSize[SIXUP] = (unsigned int)io_length(File);
-			free(m_apCurrentMapData[SIXUP]);
-			m_apCurrentMapData[SIXUP] = (unsigned char *)malloc(m_aCurrentMapSize[SIXUP]);
-			io_read(File, m_apCurrentMapData[SIXUP], m_aCurrentMapSize[SIXUP]);
-			io_close(File);
-
-			m_aCurrentMapSha256[SIXUP] = sha256(m_apCurrentMapData[SIXUP], m_aCurrentMapSize[SIXUP]);
-			m_aCurrentMapCrc[SIXUP] = crc32(0, m_apCurrentMapData[SIXUP], m_aCurrentMapSize[SIXUP]);
+			free((void *)m_apCurrentMapData[SIXUP]);
+			m_apCurrentMapData[SIXUP] = pJob->ReleaseSixupData();
+			m_aCurrentMapSize[SIXUP] = pJob->SixupSize();
+			m_aCurrentMapSha256[SIXUP] = pJob->SixupSha256();
+			m_aCurrentMapCrc[SIXUP] = pJob->SixupCrc();
+			m_aMapChunks[SIXUP].Init(m_apCurrentMapData[SIXUP], m_aCurrentMapSize[SIXUP], m_aCurrentMapCrc[SIXUP], true);
 			sha256_str(m_aCurrentMapSha256[SIXUP], aSha256, sizeof(aSha256));
 			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "sixup", aBufMsg);
@@ -2373,6 +2376,10 @@ int CServer::LoadMap(const char *pMapName)
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		m_aPrevStates[i] = m_aClients[i].m_State;
 
+	str_format(aBufMsg, sizeof(aBufMsg), "map '%s' loaded in %.2fms, swapped in %.2fms",
+		pJob->MapName(), pJob->LoadTime() * 1000.0 / time_freq(), (time_get_impl() - SwapStart) * 1000.0 / time_freq());
+	Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "server", aBufMsg);
+
 	return 1;
 }
 
@@ -2432,6 +2439,9 @@ int CServer::Run()
 		}
 	}
 
+	DbPool()->Start(g_Config.m_SvSqlReadWorkers, g_Config.m_SvSqlWriteWorkers, g_Config.m_SvSqlQueueSize);
+	m_DemoWriter.Init();
+
 	// start server
 	NETADDR BindAddr;
 	int NetType = g_Config.m_SvIpv4Only ? NETTYPE_IPV4 : NETTYPE_ALL;
@@ -2462,6 +2472,9 @@ int CServer::Run()
 
 	m_Econ.Init(Config(), Console(), &m_ServerBan);
 
+	CMetrics::AddCollector(CollectMetrics, this);
+	m_NextMetricsDump = 0;
+
 #if defined(CONF_FAMILY_UNIX)
 	m_Fifo.Init(Console(), g_Config.m_SvInputFifo, CFGFLAG_SERVER);
 #endif
@@ -2508,13 +2521,26 @@ int CServer::Run()
 			int64 t = time_get();
 			int NewTicks = 0;
 
-			// load new map TODO: don't poll this
-			if(m_MapReload || m_CurrentGameTick >= 0x6FFFFFFF) //	force reload to make sure the ticks stay within a valid range
+			// load new map in the background TODO: don't poll this
+			if(!m_pMapLoadJob && (m_MapReload || m_CurrentGameTick >= 0x6FFFFFFF)) //	force reload to make sure the ticks stay within a valid range
 			{
 				m_MapReload = false;
+				StartMapLoad(g_Config.m_SvMap);
+			}
+
+			// swap the loaded map in between two ticks
+			if(m_pMapLoadJob && m_pMapLoadJob->Status() == IJob::STATE_DONE)
+			{
+				std::shared_ptr<CMapLoadJob> pJob = std::move(m_pMapLoadJob);
+				m_pMapLoadJob = nullptr;
 
-				// load map
-				if(LoadMap(g_Config.m_SvMap))
+				// sv_map changed while loading, m_MapReload tells whether another map is to be loaded
+				if(str_comp(pJob->MapName(), g_Config.m_SvMap) != 0)
+				{
+					str_format(aBuf, sizeof(aBuf), "discarding map '%s', sv_map changed while loading", pJob->MapName());
+					Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBuf);
+				}
+				else if(SwapMap(pJob.get()))
 				{
 					// new map loaded
 
@@ -2539,6 +2565,7 @@ int CServer::Run()
 						m_aClients[ClientID].Reset();
 						m_aClients[ClientID].m_HasPersistentData = HasPersistentData;
 						m_aClients[ClientID].m_State = CClient::STATE_CONNECTING;
+						UpdateIdTranslation(ClientID);
 					}
 
 					m_GameStartTime = time_get();
@@ -2630,7 +2657,13 @@ int CServer::Run()
 					}
 				}
 
-				GameServer()->OnTick();
+				m_IDPool.Update();
+				{
+					PROFILE_SCOPE("OnTick");
+					int64 TickStart = time_get_impl();
+					GameServer()->OnTick();
+					s_MetricTickDuration.Observe((time_get_impl() - TickStart) * 1000000 / time_freq());
+				}
 				if(ErrorShutdown())
 				{
 					break;
@@ -2648,6 +2681,13 @@ int CServer::Run()
 #if defined(CONF_FAMILY_UNIX)
 				m_Fifo.Update();
 #endif
+
+				if(g_Config.m_SvMetricsFile[0] && time_get() >= m_NextMetricsDump)
+				{
+					if(!CMetrics::Dump(Storage(), g_Config.m_SvMetricsFile))
+						dbg_msg("metrics", "failed to write '%s'", g_Config.m_SvMetricsFile);
+					m_NextMetricsDump = time_get() + g_Config.m_SvMetricsInterval * time_freq();
+				}
 			}
 
 			// master server stuff
@@ -2714,6 +2754,7 @@ int CServer::Run()
 	}
 
 	m_Econ.Shutdown();
+	CMetrics::RemoveCollector(CollectMetrics, this);
 
 #if defined(CONF_FAMILY_UNIX)
 	m_Fifo.Shutdown();
@@ -2723,6 +2764,7 @@ int CServer::Run()
 	m_pMap->Unload();
 
 	DbPool()->OnShutdown();
+	m_DemoWriter.Flush();
 
 #if defined(CONF_UPNP)
 	m_UPnP.Shutdown();
@@ -3083,6 +3125,173 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConSnapIDs(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+
+	CSnapIDPool::CStats Stats = pThis->m_IDPool.Stats();
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "allocated=%d timed=%d free=%d peak=%d failed=%d max=%d (%d%% used)",
+		Stats.m_Allocated, Stats.m_Timed, Stats.m_Free, Stats.m_PeakAllocated, Stats.m_Failed, (int)CSnapIDPool::MAX_IDS,
+		(CSnapIDPool::MAX_IDS - Stats.m_Free) * 100 / CSnapIDPool::MAX_IDS);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_ids", aBuf);
+}
+
+void CServer::SendMetricsLine(const char *pLine, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	// econ clients get the bare exposition so scrapers don't have to strip the console prefix
+	int EconClientID = pThis->m_Econ.UserClientID();
+	if(EconClientID >= 0)
+		pThis->m_Econ.Send(EconClientID, pLine);
+	else
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "metrics", pLine);
+}
+
+void CServer::ConMetrics(IConsole::IResult *pResult, void *pUser)
+{
+	CMetricsWriter Writer(SendMetricsLine, pUser);
+	CMetrics::Write(&Writer);
+}
+
+void CServer::CollectMetrics(CMetricsWriter *pWriter, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+
+	int NumClients = 0;
+	for(const auto &Client : pThis->m_aClients)
+		if(Client.m_State != CClient::STATE_EMPTY)
+			NumClients++;
+	pWriter->Header("ddnet_clients", "Connected clients", "gauge");
+	pWriter->Sample("ddnet_clients", nullptr, (int64)NumClients);
+
+	pWriter->Header("ddnet_client_snapshot_bytes_total", "Compressed snapshot bytes sent to a client since it connected", "counter");
+	char aLabels[32];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(pThis->m_aClients[i].m_State != CClient::STATE_INGAME)
+			continue;
+		str_format(aLabels, sizeof(aLabels), "client=\"%d\"", i);
+		pWriter->Sample("ddnet_client_snapshot_bytes_total", aLabels, pThis->m_aClients[i].m_SnapshotBytes);
+	}
+}
+
+void CServer::ResetSnapStats()
+{
+	m_SnapshotDelta.ResetDataRate();
+	for(auto &Client : m_aClients)
+		mem_zero(&Client.m_SnapStats, sizeof(Client.m_SnapStats));
+	mem_zero(m_aRoomSnapStats, sizeof(m_aRoomSnapStats));
+	m_SnapStatsStart = time_get();
+}
+
+void CServer::ConSnapStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const int Num = pResult->NumArguments() ? maximum(pResult->GetInteger(0), 1) : 10;
+	const float Seconds = maximum((time_get() - pThis->m_SnapStatsStart) / (float)time_freq(), 1.0f);
+	char aBuf[256];
+
+	if(!g_Config.m_SvSnapStats)
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", "accounting is off, enable it with sv_snap_stats 1");
+	str_format(aBuf, sizeof(aBuf), "top talkers of the last %.0f seconds, the counters start over after each report", Seconds);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", aBuf);
+
+	// netobject types, by delta bytes before the packet compression
+	std::vector<int> vTypes;
+	for(int Type = 0; Type <= 0xffff; Type++)
+		if(pThis->m_SnapshotDelta.GetDataRate(Type))
+			vTypes.push_back(Type);
+	std::sort(vTypes.begin(), vTypes.end(), [pThis](int A, int B) { return pThis->m_SnapshotDelta.GetDataRate(A) > pThis->m_SnapshotDelta.GetDataRate(B); });
+	for(int i = 0; i < minimum((int)vTypes.size(), Num); i++)
+	{
+		const bool Sixup = vTypes[i] >= CSnapshotDelta::DATARATE_SIXUP_OFFSET;
+		const int Type = Sixup ? vTypes[i] - CSnapshotDelta::DATARATE_SIXUP_OFFSET : vTypes[i];
+		const int64 Bytes = pThis->m_SnapshotDelta.GetDataRate(vTypes[i]) / 8;
+		const int64 Updates = pThis->m_SnapshotDelta.GetDataUpdates(vTypes[i]);
+		str_format(aBuf, sizeof(aBuf), "type %s(%d)%s: %.0f bytes/s, %.1f updates/s, %d bytes/update",
+			pThis->GameServer()->NetObjName(Type, Sixup), Type, Sixup ? " sixup" : "",
+			Bytes / Seconds, Updates / Seconds, Updates ? (int)(Bytes / Updates) : 0);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", aBuf);
+	}
+
+	// rooms and clients, by compressed snapshot bytes
+	std::vector<int> vRooms;
+	for(int Room = 0; Room <= MAX_CLIENTS; Room++)
+		if(pThis->m_aRoomSnapStats[Room].m_NumSnapshots)
+			vRooms.push_back(Room);
+	std::sort(vRooms.begin(), vRooms.end(), [pThis](int A, int B) { return pThis->m_aRoomSnapStats[A].m_Bytes > pThis->m_aRoomSnapStats[B].m_Bytes; });
+	for(int i = 0; i < minimum((int)vRooms.size(), Num); i++)
+	{
+		const CSnapStats &Stats = pThis->m_aRoomSnapStats[vRooms[i]];
+		str_format(aBuf, sizeof(aBuf), "room %d: %.0f bytes/s, %d bytes/snap, %d%% split, %d items dropped",
+			vRooms[i], Stats.m_Bytes / Seconds, (int)(Stats.m_Bytes / Stats.m_NumSnapshots), Stats.m_NumSplit * 100 / Stats.m_NumSnapshots, Stats.m_NumDropped);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", aBuf);
+	}
+
+	std::vector<int> vClients;
+	for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		if(pThis->m_aClients[ClientID].m_State == CClient::STATE_INGAME && pThis->m_aClients[ClientID].m_SnapStats.m_NumSnapshots)
+			vClients.push_back(ClientID);
+	std::sort(vClients.begin(), vClients.end(), [pThis](int A, int B) { return pThis->m_aClients[A].m_SnapStats.m_Bytes > pThis->m_aClients[B].m_SnapStats.m_Bytes; });
+	for(int i = 0; i < minimum((int)vClients.size(), Num); i++)
+	{
+		const CSnapStats &Stats = pThis->m_aClients[vClients[i]].m_SnapStats;
+		str_format(aBuf, sizeof(aBuf), "id=%d name='%s' room=%d: %.0f bytes/s, %d bytes/snap, %d%% split, %d items dropped",
+			vClients[i], pThis->ClientName(vClients[i]), pThis->GameServer()->GetClientRoom(vClients[i]),
+			Stats.m_Bytes / Seconds, (int)(Stats.m_Bytes / Stats.m_NumSnapshots), Stats.m_NumSplit * 100 / Stats.m_NumSnapshots, Stats.m_NumDropped);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", aBuf);
+	}
+
+	// every report covers the time since the previous one
+	pThis->ResetSnapStats();
+}
+
+void CServer::ConSnapStatsReset(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	pThis->ResetSnapStats();
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "snap_stats", "reset");
+}
+
+void CServer::ConProfilerStart(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	CProfiler::Start();
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "recording");
+}
+
+void CServer::ConProfilerStop(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	CProfiler::Stop();
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", "stopped");
+}
+
+void CServer::ConProfilerDump(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+
+	char aFilename[128];
+	if(pResult->NumArguments())
+		str_format(aFilename, sizeof(aFilename), "profiles/%s.json", pResult->GetString(0));
+	else
+	{
+		char aDate[20];
+		str_timestamp(aDate, sizeof(aDate));
+		str_format(aFilename, sizeof(aFilename), "profiles/tick_%s.json", aDate);
+	}
+
+	pThis->Storage()->CreateFolder("profiles", IStorage::TYPE_SAVE);
+	int NumEvents = CProfiler::Dump(pThis->Storage(), aFilename);
+	char aBuf[256];
+	if(NumEvents < 0)
+		str_format(aBuf, sizeof(aBuf), "failed to open '%s'", aFilename);
+	else
+		str_format(aBuf, sizeof(aBuf), "wrote %d events to '%s'", NumEvents, aFilename);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "profiler", aBuf);
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = STOPPING;
@@ -3154,6 +3363,48 @@ bool CServer::IsRecording(int ClientID)
 	return m_aDemoRecorder[ClientID].IsRecording();
 }
 
+void CServer::StartRoomRecord(int Room)
+{
+	if(Room < 0 || Room >= MAX_CLIENTS)
+		return;
+
+	char aDesc[16];
+	char aDate[20];
+	char aFilename[128];
+	str_format(aDesc, sizeof(aDesc), "room%d", Room);
+	str_timestamp(aDate, sizeof(aDate));
+	str_format(aFilename, sizeof(aFilename), "demos/%s_%s.demo", aDesc, aDate);
+	m_aRoomDemoRecorder[Room].Start(Storage(), Console(), aFilename, GameServer()->NetVersion(), m_aCurrentMap, &m_aCurrentMapSha256[SIX], m_aCurrentMapCrc[SIX], "server", m_aCurrentMapSize[SIX], m_apCurrentMapData[SIX]);
+	if(g_Config.m_SvRoomDemoMax)
+	{
+		// clean up the old demos of this room
+		CFileCollection RoomDemos;
+		RoomDemos.Init(Storage(), "demos", aDesc, ".demo", g_Config.m_SvRoomDemoMax);
+	}
+}
+
+void CServer::StopRoomRecord(int Room)
+{
+	if(IsRoomRecording(Room))
+		m_aRoomDemoRecorder[Room].Stop();
+}
+
+bool CServer::IsRoomRecording(int Room) const
+{
+	return Room >= 0 && Room < MAX_CLIENTS && m_aRoomDemoRecorder[Room].IsRecording();
+}
+
+void CServer::RecordRoomMsg(CMsgPacker *pMsg, int Room)
+{
+	if(!IsRoomRecording(Room))
+		return;
+
+	CPacker Pack;
+	if(RepackMsg(pMsg, Pack, false))
+		return;
+	m_aRoomDemoRecorder[Room].RecordMessage(Pack.Data(), Pack.Size());
+}
+
 void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pServer = (CServer *)pUser;
@@ -3175,6 +3426,16 @@ void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_aDemoRecorder[MAX_CLIENTS].Stop();
 }
 
+void CServer::ConRecordRoom(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->StartRoomRecord(pResult->GetInteger(0));
+}
+
+void CServer::ConStopRecordRoom(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->StopRoomRecord(pResult->GetInteger(0));
+}
+
 void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_MapReload = true;
@@ -3295,6 +3556,15 @@ void CServer::ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pU
 		((CServer *)pUserData)->m_NetServer.SetMaxClientsPerIP(pResult->GetInteger(0));
 }
 
+void CServer::ConchainSnapStatsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	int Old = g_Config.m_SvSnapStats;
+	pfnCallback(pResult, pCallbackUserData);
+	// start counting from the moment it was enabled
+	if(pResult->NumArguments() && !Old && g_Config.m_SvSnapStats)
+		((CServer *)pUserData)->ResetSnapStats();
+}
+
 void CServer::ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	if(pResult->NumArguments() == 2)
@@ -3485,6 +3755,8 @@ void CServer::RegisterCommands()
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
+	Console()->Register("record_room", "i[room]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecordRoom, this, "Record a demo of a room");
+	Console()->Register("stoprecord_room", "i[room]", CFGFLAG_SERVER, ConStopRecordRoom, this, "Stop recording the demo of a room");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
 
@@ -3502,10 +3774,19 @@ void CServer::RegisterCommands()
 	Console()->Register("name_unban", "s[name]", CFGFLAG_SERVER, ConNameUnban, this, "Unban a certain nickname");
 	Console()->Register("name_bans", "", CFGFLAG_SERVER, ConNameBans, this, "List all name bans");
 
+	Console()->Register("snap_ids", "", CFGFLAG_SERVER, ConSnapIDs, this, "Show the usage of the snapshot id pool");
+	Console()->Register("profiler_start", "", CFGFLAG_SERVER, ConProfilerStart, this, "Start recording tick timings");
+	Console()->Register("profiler_stop", "", CFGFLAG_SERVER, ConProfilerStop, this, "Stop recording tick timings");
+	Console()->Register("profiler_dump", "?s[file]", CFGFLAG_SERVER, ConProfilerDump, this, "Write the recorded tick timings to profiles/<file>.json in chrome trace format");
+	Console()->Register("metrics", "", CFGFLAG_SERVER, ConMetrics, this, "Print the server metrics in the prometheus text format");
+	Console()->Register("snap_stats", "?i[num]", CFGFLAG_SERVER, ConSnapStats, this, "List the netobject types, rooms and clients with the most snapshot traffic since the last report");
+	Console()->Register("snap_stats_reset", "", CFGFLAG_SERVER, ConSnapStatsReset, this, "Restart the snapshot traffic accounting");
+
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
+	Console()->Chain("sv_snap_stats", ConchainSnapStatsUpdate, this);
 	Console()->Chain("access_level", ConchainCommandAccessUpdate, this);
 	Console()->Chain("console_output_level", ConchainConsoleOutputLevelUpdate, this);
 
@@ -3703,11 +3984,6 @@ const char *CServer::GetAnnouncementLine(char const *pFileName)
 	return Lines[m_AnnouncementLastLine];
 }
 
-int *CServer::GetIdMap(int ClientID)
-{
-	return m_aIdMap + VANILLA_MAX_CLIENTS * ClientID;
-}
-
 bool CServer::SetTimedOut(int ClientID, int OrigID)
 {
 	if(!m_NetServer.SetTimedOut(ClientID, OrigID))
@@ -3715,6 +3991,7 @@ bool CServer::SetTimedOut(int ClientID, int OrigID)
 		return false;
 	}
 	m_aClients[ClientID].m_Sixup = m_aClients[OrigID].m_Sixup;
+	UpdateIdTranslation(ClientID);
 
 	if(m_aClients[OrigID].m_Authed != AUTHED_NO)
 	{
@@ -27,45 +27,15 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "map_download.h"
+#include "map_loader.h"
 #include "name_ban.h"
+#include "snap_id_pool.h"
 
 #if defined(CONF_UPNP)
 #include "upnp.h"
 #endif
 
-class CSnapIDPool
-{
-	enum
-	{
-		MAX_IDS = 16 * 1024,
-	};
-
-	class CID
-	{
-	public:
-		short m_Next;
-		short m_State; // 0 = free, 1 = allocated, 2 = timed
-		int m_Timeout;
-	};
-
-	CID m_aIDs[MAX_IDS];
-
-	int m_FirstFree;
-	int m_FirstTimed;
-	int m_LastTimed;
-	int m_Usage;
-	int m_InUsage;
-
-public:
-	CSnapIDPool();
-
-	void Reset();
-	void RemoveFirstTimeout();
-	int NewID();
-	void TimeoutIDs();
-	void FreeID(int ID);
-};
-
 class CServerBan : public CNetBan
 {
 	class CServer *m_pServer;
@@ -119,6 +89,22 @@ public:
 		MAX_RCONCMD_SEND = 16,
 	};
 
+	struct CSnapStats
+	{
+		int64 m_Bytes;
+		int m_NumSnapshots;
+		int m_NumSplit; // snapshots that needed more than one packet
+		int m_NumDropped; // items left out for the snapshot budget
+
+		void Add(int Bytes, int NumPackets)
+		{
+			m_Bytes += Bytes;
+			m_NumSnapshots++;
+			if(NumPackets > 1)
+				m_NumSplit++;
+		}
+	};
+
 	class CClient
 	{
 	public:
@@ -156,6 +142,8 @@ public:
 
 		float m_Traffic;
 		int64 m_TrafficSince;
+		int64 m_SnapshotBytes;
+		CSnapStats m_SnapStats;
 
 		int m_LastAckedSnapshot;
 		int m_LastInputTick;
@@ -172,7 +160,7 @@ public:
 		int m_Authed;
 		int m_AuthKey;
 		int m_AuthTries;
-		int m_NextMapChunk;
+		CMapDownload m_MapDownload;
 		int m_Flags;
 		bool m_ShowIps;
 
@@ -201,7 +189,6 @@ public:
 	};
 
 	CClient m_aClients[MAX_CLIENTS];
-	int m_aIdMap[MAX_CLIENTS * VANILLA_MAX_CLIENTS];
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
@@ -228,6 +215,7 @@ public:
 	int m_RunServer;
 
 	bool m_MapReload;
+	std::shared_ptr<CMapLoadJob> m_pMapLoadJob;
 	bool m_ReloadedWhenEmpty;
 	int m_RconClientID;
 	int m_RconAuthLevel;
@@ -245,10 +233,13 @@ public:
 	char m_aCurrentMap[MAX_PATH_LENGTH];
 	SHA256_DIGEST m_aCurrentMapSha256[2];
 	unsigned m_aCurrentMapCrc[2];
-	unsigned char *m_apCurrentMapData[2];
+	const unsigned char *m_apCurrentMapData[2];
 	unsigned int m_aCurrentMapSize[2];
+	CMapChunks m_aMapChunks[2];
 
+	CDemoWriter m_DemoWriter;
 	CDemoRecorder m_aDemoRecorder[MAX_CLIENTS + 1];
+	CDemoRecorder m_aRoomDemoRecorder[MAX_CLIENTS];
 	CRegister m_Register;
 	CRegister m_RegSixup;
 	CAuthManager m_AuthManager;
@@ -258,6 +249,13 @@ public:
 	int64 m_ServerInfoFirstRequest;
 	int m_ServerInfoNumRequests;
 
+	int64 m_NextMetricsDump;
+
+	// snapshot bandwidth accounting, see sv_snap_stats
+	CSnapStats m_aRoomSnapStats[MAX_CLIENTS + 1];
+	int64 m_SnapStatsStart;
+	void ResetSnapStats();
+
 	char m_aErrorShutdownReason[128];
 
 	array<CNameBan> m_aNameBans;
@@ -293,6 +291,7 @@ public:
 	void GetMapInfo(char *pMapName, int MapNameSize, int *pMapSize, SHA256_DIGEST *pMapSha256, int *pMapCrc);
 	int GetClientInfo(int ClientID, CClientInfo *pInfo) const;
 	void SetClientDDNetVersion(int ClientID, int DDNetVersion);
+	void UpdateIdTranslation(int ClientID);
 	void GetClientAddr(int ClientID, char *pAddrStr, int Size) const;
 	const char *ClientName(int ClientID) const;
 	const char *ClientClan(int ClientID) const;
@@ -367,13 +366,21 @@ public:
 
 	char *GetMapName() const;
 	void ChangeMap(const char *pMap);
+	// loads synchronously, the main loop loads through StartMapLoad() instead
 	int LoadMap(const char *pMapName);
+	void StartMapLoad(const char *pMapName);
+	int SwapMap(CMapLoadJob *pJob);
 
 	void SaveDemo(int ClientID, float Time);
 	void StartRecord(int ClientID);
 	void StopRecord(int ClientID);
 	bool IsRecording(int ClientID);
 
+	void StartRoomRecord(int Room);
+	void StopRoomRecord(int Room);
+	bool IsRoomRecording(int Room) const;
+	void RecordRoomMsg(CMsgPacker *pMsg, int Room);
+
 	void InitRegister(CNetServer *pNetServer, IEngineMasterServer *pMasterServer, CConfig *pConfig, IConsole *pConsole);
 	int Run();
 
@@ -383,6 +390,8 @@ public:
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConRecordRoom(IConsole::IResult *pResult, void *pUser);
+	static void ConStopRecordRoom(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
@@ -397,6 +406,15 @@ public:
 	static void ConNameBan(IConsole::IResult *pResult, void *pUser);
 	static void ConNameUnban(IConsole::IResult *pResult, void *pUser);
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapIDs(IConsole::IResult *pResult, void *pUser);
+	static void ConProfilerStart(IConsole::IResult *pResult, void *pUser);
+	static void ConProfilerStop(IConsole::IResult *pResult, void *pUser);
+	static void ConProfilerDump(IConsole::IResult *pResult, void *pUser);
+	static void ConMetrics(IConsole::IResult *pResult, void *pUser);
+	static void SendMetricsLine(const char *pLine, void *pUser);
+	static void CollectMetrics(class CMetricsWriter *pWriter, void *pUser);
+	static void ConSnapStats(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapStatsReset(IConsole::IResult *pResult, void *pUser);
 
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
@@ -404,6 +422,7 @@ public:
 
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainSnapStatsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainConsoleOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -425,6 +444,11 @@ public:
 	virtual int SnapNewID();
 	virtual void SnapFreeID(int ID);
 	virtual void *SnapNewItem(int Type, int ID, int Size);
+	virtual int SnapNumItems() const { return m_SnapshotBuilder.NumItems(); }
+	virtual int SnapNumDropped() const { return m_SnapshotBuilder.NumDropped(); }
+	virtual void SnapCopyItems(int FromItem, CSnapshotItemCache *pCache) const { m_SnapshotBuilder.CopyItems(FromItem, pCache); }
+	virtual void SnapAddItems(const CSnapshotItemCache &Cache) { m_SnapshotBuilder.AddItems(Cache); }
+	virtual int SnapSetPriority(int Priority) { return m_SnapshotBuilder.SetPriority(Priority); }
 	void SnapSetStaticsize(int ItemType, int Size);
 
 	// DDRace
@@ -435,8 +459,6 @@ public:
 	unsigned m_AnnouncementLastLine;
 	void RestrictRconOutput(int ClientID) { m_RconRestrict = ClientID; }
 
-	virtual int *GetIdMap(int ClientID);
-
 	void InitDnsbl(int ClientID);
 	bool DnsblWhite(int ClientID)
 	{
@@ -467,7 +489,7 @@ public:
 	bool ErrorShutdown() const { return m_aErrorShutdownReason[0] != 0; }
 	void SetErrorShutdown(const char *pReason);
 
-	bool IsSixup(int ClientID) const { return m_aClients[ClientID].m_Sixup; }
+	bool IsSixup(int ClientID) const { return ClientID >= 0 && m_aClients[ClientID].m_Sixup; }
 
 #ifdef CONF_FAMILY_UNIX
 	enum CONN_LOGGING_CMD
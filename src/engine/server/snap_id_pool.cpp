@@ -0,0 +1,156 @@
+#include "snap_id_pool.h"
+
+static const uint64 FREE_INDEX_MASK = 0xffffffffu;
+
+CSnapIDPool::CSnapIDPool()
+{
+	Reset();
+}
+
+void CSnapIDPool::Reset()
+{
+	for(int i = 0; i < MAX_IDS; i++)
+	{
+		m_aIDs[i].m_Next.store(i + 1, std::memory_order_relaxed);
+		m_aIDs[i].m_State.store(0, std::memory_order_relaxed);
+	}
+
+	m_aIDs[MAX_IDS - 1].m_Next.store(-1, std::memory_order_relaxed);
+	m_FreeHead.store(0);
+	m_FirstPending.store(-1);
+	m_FirstTimed = -1;
+	m_LastTimed = -1;
+	m_Usage.store(0);
+	m_InUsage.store(0);
+	m_PeakInUsage.store(0);
+	m_Failed.store(0);
+}
+
+void CSnapIDPool::PushFree(int ID)
+{
+	m_aIDs[ID].m_State.store(0, std::memory_order_relaxed);
+	uint64 Head = m_FreeHead.load(std::memory_order_relaxed);
+	uint64 NewHead;
+	do
+	{
+		m_aIDs[ID].m_Next.store((int)(Head & FREE_INDEX_MASK), std::memory_order_relaxed);
+		NewHead = (Head & ~FREE_INDEX_MASK) | (unsigned)ID;
+	} while(!m_FreeHead.compare_exchange_weak(Head, NewHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+int CSnapIDPool::NewID()
+{
+	uint64 Head = m_FreeHead.load(std::memory_order_acquire);
+	int ID;
+	while(true)
+	{
+		ID = (int)(Head & FREE_INDEX_MASK);
+		if(ID == -1)
+			break;
+		uint64 NewHead = ((Head >> 32) + 1) << 32 | (unsigned)m_aIDs[ID].m_Next.load(std::memory_order_relaxed);
+		if(m_FreeHead.compare_exchange_weak(Head, NewHead, std::memory_order_acquire, std::memory_order_acquire))
+			break;
+	}
+
+	if(ID == -1)
+	{
+		m_Failed++;
+		dbg_assert(false, "id error");
+		return -1;
+	}
+
+	m_aIDs[ID].m_State.store(1, std::memory_order_relaxed);
+	m_Usage++;
+	int InUsage = ++m_InUsage;
+	int Peak = m_PeakInUsage.load(std::memory_order_relaxed);
+	while(InUsage > Peak && !m_PeakInUsage.compare_exchange_weak(Peak, InUsage, std::memory_order_relaxed))
+	{
+	}
+	return ID;
+}
+
+void CSnapIDPool::FreeID(int ID)
+{
+	if(ID < 0)
+		return;
+	// an id freed twice at the same time is freed by only one of the threads
+	int State = 1;
+	if(!m_aIDs[ID].m_State.compare_exchange_strong(State, 2, std::memory_order_relaxed))
+	{
+		dbg_assert(false, "id is not allocated");
+		return;
+	}
+
+	m_InUsage--;
+	m_aIDs[ID].m_Timeout = time_get() + time_freq() * 5;
+
+	int First = m_FirstPending.load(std::memory_order_relaxed);
+	do
+		m_aIDs[ID].m_Next.store(First, std::memory_order_relaxed);
+	while(!m_FirstPending.compare_exchange_weak(First, ID, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void CSnapIDPool::QueuePending()
+{
+	// the pending list is newest first, reverse it to keep the timed list ordered
+	int ID = m_FirstPending.exchange(-1, std::memory_order_acquire);
+	int First = -1;
+	int Last = ID;
+	while(ID != -1)
+	{
+		int Next = m_aIDs[ID].m_Next.load(std::memory_order_relaxed);
+		m_aIDs[ID].m_Next.store(First, std::memory_order_relaxed);
+		First = ID;
+		ID = Next;
+	}
+	if(First == -1)
+		return;
+
+	if(m_LastTimed != -1)
+		m_aIDs[m_LastTimed].m_Next.store(First, std::memory_order_relaxed);
+	else
+		m_FirstTimed = First;
+	m_LastTimed = Last;
+}
+
+void CSnapIDPool::RemoveFirstTimeout()
+{
+	int ID = m_FirstTimed;
+
+	// remove it from the timed list
+	m_FirstTimed = m_aIDs[ID].m_Next.load(std::memory_order_relaxed);
+	if(m_FirstTimed == -1)
+		m_LastTimed = -1;
+
+	// add it to the free list
+	PushFree(ID);
+	m_Usage--;
+}
+
+void CSnapIDPool::Update()
+{
+	QueuePending();
+
+	int64 Now = time_get();
+	while(m_FirstTimed != -1 && m_aIDs[m_FirstTimed].m_Timeout < Now)
+		RemoveFirstTimeout();
+}
+
+void CSnapIDPool::TimeoutIDs()
+{
+	QueuePending();
+
+	while(m_FirstTimed != -1)
+		RemoveFirstTimeout();
+}
+
+CSnapIDPool::CStats CSnapIDPool::Stats() const
+{
+	CStats Stats;
+	Stats.m_Allocated = m_InUsage.load();
+	Stats.m_Timed = m_Usage.load() - Stats.m_Allocated;
+	Stats.m_Free = MAX_IDS - m_Usage.load();
+	Stats.m_PeakAllocated = m_PeakInUsage.load();
+	Stats.m_Failed = m_Failed.load();
+	return Stats;
+}
@@ -0,0 +1,71 @@
+#ifndef ENGINE_SERVER_SNAP_ID_POOL_H
+#define ENGINE_SERVER_SNAP_ID_POOL_H
+
+#include <base/system.h>
+
+#include <atomic>
+
+// NewID() and FreeID() may be called from any thread. Freed ids are only
+// handed out again after a timeout, Update() moves them along and must be
+// called regularly from the thread that owns the pool.
+class CSnapIDPool
+{
+public:
+	enum
+	{
+		MAX_IDS = 16 * 1024,
+	};
+
+	struct CStats
+	{
+		int m_Allocated; // in use by entities
+		int m_Timed; // freed, waiting for the timeout
+		int m_Free;
+		int m_PeakAllocated;
+		int m_Failed; // allocations that found no free id
+	};
+
+private:
+	class CID
+	{
+	public:
+		std::atomic<int> m_Next;
+		// 0 = free, 1 = allocated, 2 = timed, checked by whichever thread frees the id
+		std::atomic<int> m_State;
+		int64 m_Timeout;
+	};
+
+	CID m_aIDs[MAX_IDS];
+
+	// free list, the upper 32 bits count pops to rule out ABA
+	std::atomic<uint64> m_FreeHead;
+	// freed ids not yet queued for the timeout, newest first
+	std::atomic<int> m_FirstPending;
+	// owned by Update()
+	int m_FirstTimed;
+	int m_LastTimed;
+
+	std::atomic<int> m_Usage;
+	std::atomic<int> m_InUsage;
+	std::atomic<int> m_PeakInUsage;
+	std::atomic<int> m_Failed;
+
+	void PushFree(int ID);
+	void QueuePending();
+	void RemoveFirstTimeout();
+
+public:
+	CSnapIDPool();
+
+	void Reset();
+	int NewID();
+	void FreeID(int ID);
+
+	void Update();
+	// frees all timed ids right away, the ids must not be in any snapshot anymore
+	void TimeoutIDs();
+
+	CStats Stats() const;
+};
+
+#endif
@@ -41,6 +41,8 @@ MACRO_CONFIG_INT(SvRconVote, sv_rcon_vote, 0, 0, 1, CFGFLAG_SERVER, "Only allow
 MACRO_CONFIG_INT(SvRagequitBanTime, sv_ragequit_bantime, 0, 0, 1440, CFGFLAG_SERVER, "The time a client gets banned if quickly rejoined after ragequit. 0 disables this.")
 
 MACRO_CONFIG_INT(SvPlayerDemoRecord, sv_player_demo_record, 0, 0, 1, CFGFLAG_SERVER, "Automatically record demos for each player")
+MACRO_CONFIG_INT(SvRoomDemoRecord, sv_room_demo_record, 0, 0, 1, CFGFLAG_SERVER, "Automatically record a demo of every match in each room")
+MACRO_CONFIG_INT(SvRoomDemoMax, sv_room_demo_max, 10, 0, 1000, CFGFLAG_SERVER, "Maximum number of recorded demos kept per room (0 = no limit)")
 MACRO_CONFIG_INT(SvDemoChat, sv_demo_chat, 0, 0, 1, CFGFLAG_SERVER, "Record chat for demos")
 MACRO_CONFIG_INT(SvServerInfoPerSecond, sv_server_info_per_second, 50, 0, 10000, CFGFLAG_SERVER, "Maximum number of complete server info responses that are sent out per second (0 for no limit)")
 MACRO_CONFIG_INT(SvVanConnPerSecond, sv_van_conn_per_second, 10, 0, 10000, CFGFLAG_SERVER, "Antispoof specific ratelimit (0 for no limit)")
@@ -111,6 +113,11 @@ MACRO_CONFIG_STR(SvRegionName, sv_region_name, 5, "UNK", CFGFLAG_SERVER, "Server
 MACRO_CONFIG_STR(SvSqlServerName, sv_sql_servername, 5, "UNK", CFGFLAG_SERVER, "SQL Server name that is inserted into record table")
 MACRO_CONFIG_INT(SvUseSQL, sv_use_sql, 0, 0, 1, CFGFLAG_SERVER, "Enables MySQL backend instead of SQLite backend (sv_sqlite_file is still used as fallback write server when no MySQL server is reachable)")
 MACRO_CONFIG_INT(SvSqlQueriesDelay, sv_sql_queries_delay, 1, 0, 20, CFGFLAG_SERVER, "Delay in seconds between SQL queries of a single player")
+MACRO_CONFIG_INT(SvSqlReadWorkers, sv_sql_read_workers, 1, 1, 16, CFGFLAG_SERVER, "Number of threads running database reads, each with its own connections (needs restart)")
+MACRO_CONFIG_INT(SvSqlWriteWorkers, sv_sql_write_workers, 1, 1, 16, CFGFLAG_SERVER, "Number of threads running database writes, each with its own connections (needs restart)")
+MACRO_CONFIG_INT(SvSqlQueueSize, sv_sql_queue_size, 512, 16, 65536, CFGFLAG_SERVER, "Maximum number of queued database reads and writes each, further tasks are dropped (needs restart)")
+MACRO_CONFIG_INT(SvPvpStats, sv_pvp_stats, 0, 0, 1, CFGFLAG_SERVER, "Record kills, deaths, captures, wins and matches per player and gamemode in the database")
+MACRO_CONFIG_INT(SvPvpStatsInterval, sv_pvp_stats_interval, 60, 1, 3600, CFGFLAG_SERVER, "Seconds between writes of the collected pvp statistics to the database")
 MACRO_CONFIG_STR(SvSqliteFile, sv_sqlite_file, 64, "ddnet-server.sqlite", CFGFLAG_SERVER, "File to store ranks in case sv_use_sql is turned off or used as backup sql server")
 
 #if defined(CONF_UPNP)
@@ -149,6 +156,11 @@ MACRO_CONFIG_INT(SvPlasmaPerSec, sv_plasma_per_sec, 3, 0, 50, CFGFLAG_SERVER | C
 MACRO_CONFIG_INT(SvDraggerRange, sv_dragger_range, 700, 1, 99999, CFGFLAG_SERVER | CFGFLAG_GAME, "How far will the dragger track tees")
 MACRO_CONFIG_INT(SvTuneReset, sv_tune_reset, 1, 0, 1, CFGFLAG_SERVER, "Whether tuning is reset after each map change or not")
 MACRO_CONFIG_STR(SvResetFile, sv_reset_file, 128, "reset.cfg", CFGFLAG_SERVER, "File to execute on map change or reload to set the default server settings")
+MACRO_CONFIG_STR(SvMetricsFile, sv_metrics_file, 128, "", CFGFLAG_SERVER, "File the metrics are periodically written to in the prometheus text format (empty = off)")
+MACRO_CONFIG_INT(SvMetricsInterval, sv_metrics_interval, 15, 1, 3600, CFGFLAG_SERVER, "How often the metrics file is written, in seconds")
+MACRO_CONFIG_INT(SvSnapBudget, sv_snap_budget, 0, 0, 65536, CFGFLAG_SERVER, "Maximum size of a snapshot in bytes before the least important items are dropped (0 = no limit)")
+MACRO_CONFIG_INT(SvSnapBudgetItems, sv_snap_budget_items, 0, 0, 1024, CFGFLAG_SERVER, "Maximum number of items in a snapshot before the least important ones are dropped (0 = no limit)")
+MACRO_CONFIG_INT(SvSnapStats, sv_snap_stats, 0, 0, 1, CFGFLAG_SERVER, "Account snapshot traffic per netobject type, room and client for snap_stats")
 MACRO_CONFIG_STR(SvInputFifo, sv_input_fifo, 128, "", CFGFLAG_SERVER, "Fifo file to use as input for server console")
 MACRO_CONFIG_INT(SvDDRaceTuneReset, sv_ddrace_tune_reset, 1, 0, 1, CFGFLAG_SERVER, "Whether DDRace tuning (sv_hit, sv_endless_drag and sv_old_laser) is reset after each map change or not")
 MACRO_CONFIG_INT(SvNamelessScore, sv_nameless_score, 1, 0, 1, CFGFLAG_SERVER, "Whether nameless tee has a score or not")
@@ -629,11 +629,45 @@ void CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPoss
 	}
 }
 
+unsigned CConsole::HashName(const char *pName)
+{
+	// FNV-1a of the lowercase name
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = (Hash ^ c) * 16777619u;
+	}
+	return Hash;
+}
+
+void CConsole::AddCommandHash(CCommand *pCommand)
+{
+	CCommand **ppBucket = &m_apCommandHash[pCommand->m_Hash % COMMAND_HASH_SIZE];
+	pCommand->m_pNextHash = *ppBucket;
+	*ppBucket = pCommand;
+}
+
+void CConsole::RemoveCommandHash(CCommand *pCommand)
+{
+	for(CCommand **ppCommand = &m_apCommandHash[pCommand->m_Hash % COMMAND_HASH_SIZE]; *ppCommand; ppCommand = &(*ppCommand)->m_pNextHash)
+	{
+		if(*ppCommand == pCommand)
+		{
+			*ppCommand = pCommand->m_pNextHash;
+			return;
+		}
+	}
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	unsigned Hash = HashName(pName);
+	for(CCommand *pCommand = m_apCommandHash[Hash % COMMAND_HASH_SIZE]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
-		if(pCommand->m_Flags & FlagMask)
+		if(pCommand->m_Flags & FlagMask && pCommand->m_Hash == Hash)
 		{
 			if(str_comp_nocase(pCommand->m_pName, pName) == 0)
 				return pCommand;
@@ -643,6 +677,24 @@ CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 	return 0x0;
 }
 
+CConsole::CCommand *CConsole::FindTableCommand(const char *pName, int Flags)
+{
+	if(!m_pTableCommands)
+		return 0;
+
+	unsigned Hash = HashName(pName);
+	for(CCommand *pCommand = m_apCommandHash[Hash % COMMAND_HASH_SIZE]; pCommand; pCommand = pCommand->m_pNextHash)
+	{
+		if(!IsTableCommand(pCommand) || pCommand->m_Flags || pCommand->m_Hash != Hash)
+			continue;
+		int TableFlags = m_pCommandTable->m_vEntries[pCommand - m_pTableCommands].m_Flags;
+		if((TableFlags & Flags || TableFlags == Flags) && str_comp_nocase(pCommand->m_pName, pName) == 0)
+			return pCommand;
+	}
+
+	return 0;
+}
+
 void CConsole::ExecuteLine(const char *pStr, int ClientID, bool InterpretSemicolons)
 {
 	CConsole::ExecuteLineStroked(1, pStr, ClientID, InterpretSemicolons); // press it
@@ -882,7 +934,8 @@ void CConsole::ConToggleStroke(IConsole::IResult *pResult, void *pUser)
 		pConsole->Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 }
 
-CConsole::CConsole(int FlagMask)
+CConsole::CConsole(int FlagMask, std::shared_ptr<const CCommandTable> pCommandTable) :
+	m_pCommandTable(std::move(pCommandTable))
 {
 	m_FlagMask = FlagMask;
 	m_AccessLevel = ACCESS_LEVEL_ADMIN;
@@ -893,12 +946,37 @@ CConsole::CConsole(int FlagMask)
 	m_apStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
+	m_pTableCommands = 0;
+	m_CommandsAdded = false;
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
 
 	m_pStorage = 0;
 
+	if(m_pCommandTable && !m_pCommandTable->m_vEntries.empty())
+	{
+		int NumCommands = m_pCommandTable->m_vEntries.size();
+		m_pTableCommands = new CCommand[NumCommands];
+		for(int i = NumCommands - 1; i >= 0; i--)
+		{
+			const CCommandTable::CEntry &Entry = m_pCommandTable->m_vEntries[i];
+			CCommand *pCommand = &m_pTableCommands[i];
+			pCommand->m_pName = Entry.m_Name.c_str();
+			pCommand->m_pHelp = Entry.m_Help.c_str();
+			pCommand->m_pParams = Entry.m_Params.c_str();
+			pCommand->m_Flags = 0;
+			pCommand->m_Temp = false;
+			pCommand->m_pfnCallback = 0;
+			pCommand->m_pUserData = 0;
+			pCommand->m_Hash = Entry.m_Hash;
+			pCommand->m_pNext = m_pFirstCommand;
+			m_pFirstCommand = pCommand;
+			AddCommandHash(pCommand);
+		}
+	}
+
 	// register some basic commands
 	Register("echo", "r[text]", CFGFLAG_SERVER | CFGFLAG_INSTANCE, Con_Echo, this, "Echo the text");
 	Register("exec", "r[file]", CFGFLAG_SERVER | CFGFLAG_CLIENT | CFGFLAG_INSTANCE, Con_Exec, this, "Execute the specified file");
@@ -924,10 +1002,36 @@ CConsole::~CConsole()
 		if(pCommand->m_pfnCallback == Con_Chain)
 			delete static_cast<CChain *>(pCommand->m_pUserData);
 		// Temp commands are on m_TempCommands heap, so don't delete them
-		if(!pCommand->m_Temp)
+		if(!pCommand->m_Temp && !IsTableCommand(pCommand))
 			delete pCommand;
 		pCommand = pNext;
 	}
+	delete[] m_pTableCommands;
+}
+
+std::shared_ptr<const CConsole::CCommandTable> CConsole::CommandTable()
+{
+	if(!m_CommandsAdded)
+		return m_pExportedTable ? m_pExportedTable : m_pCommandTable;
+
+	std::shared_ptr<CCommandTable> pTable = std::make_shared<CCommandTable>();
+	for(const CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	{
+		if(pCommand->m_Temp)
+			continue;
+		CCommandTable::CEntry Entry;
+		Entry.m_Name = pCommand->m_pName;
+		Entry.m_Params = pCommand->m_pParams;
+		Entry.m_Help = pCommand->m_pHelp;
+		Entry.m_Flags = pCommand->m_Flags;
+		if(IsTableCommand(pCommand) && !pCommand->m_Flags)
+			Entry.m_Flags = m_pCommandTable->m_vEntries[pCommand - m_pTableCommands].m_Flags;
+		Entry.m_Hash = pCommand->m_Hash;
+		pTable->m_vEntries.push_back(Entry);
+	}
+	m_pExportedTable = pTable;
+	m_CommandsAdded = false;
+	return m_pExportedTable;
 }
 
 void CConsole::Init()
@@ -1020,6 +1124,8 @@ void CConsole::Register(const char *pName, const char *pParams,
 	int Flags, FCommandCallback pfnFunc, void *pUser, const char *pHelp)
 {
 	CCommand *pCommand = FindCommand(pName, Flags);
+	if(pCommand == 0)
+		pCommand = FindTableCommand(pName, Flags);
 	bool DoAdd = false;
 	if(pCommand == 0)
 	{
@@ -1037,7 +1143,12 @@ void CConsole::Register(const char *pName, const char *pParams,
 	pCommand->m_Temp = false;
 
 	if(DoAdd)
+	{
+		pCommand->m_Hash = HashName(pName);
 		AddCommandSorted(pCommand);
+		AddCommandHash(pCommand);
+		m_CommandsAdded = true;
+	}
 
 	if(pCommand->m_Flags & CFGFLAG_CHAT)
 		pCommand->SetAccessLevel(ACCESS_LEVEL_USER);
@@ -1073,8 +1184,10 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams, int Flags, c
 	pCommand->m_pUserData = 0;
 	pCommand->m_Flags = Flags;
 	pCommand->m_Temp = true;
+	pCommand->m_Hash = HashName(pCommand->m_pName);
 
 	AddCommandSorted(pCommand);
+	AddCommandHash(pCommand);
 }
 
 void CConsole::DeregisterTemp(const char *pName)
@@ -1104,6 +1217,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHash(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -1127,6 +1241,17 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(CCommand *&pBucket : m_apCommandHash)
+	{
+		for(CCommand **ppCommand = &pBucket; *ppCommand;)
+		{
+			if((*ppCommand)->m_Temp)
+				*ppCommand = (*ppCommand)->m_pNextHash;
+			else
+				ppCommand = &(*ppCommand)->m_pNextHash;
+		}
+	}
+
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
 }
@@ -1175,9 +1300,10 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	unsigned Hash = HashName(pName);
+	for(CCommand *pCommand = m_apCommandHash[Hash % COMMAND_HASH_SIZE]; pCommand; pCommand = pCommand->m_pNextHash)
 	{
-		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
+		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp && pCommand->m_Hash == Hash)
 		{
 			if(str_comp_nocase(pCommand->m_pName, pName) == 0)
 				return pCommand;
@@ -9,12 +9,38 @@
 #include <engine/console.h>
 #include <engine/storage.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 class CConsole : public IConsole
 {
+public:
+	// The commands of a console without their callbacks. Consoles created
+	// from it start with all of its commands allocated, sorted and hashed,
+	// registering one of them only binds its callback. It is never changed
+	// once created, so any number of consoles can share it.
+	class CCommandTable
+	{
+	public:
+		struct CEntry
+		{
+			std::string m_Name;
+			std::string m_Params;
+			std::string m_Help;
+			int m_Flags;
+			unsigned m_Hash;
+		};
+		std::vector<CEntry> m_vEntries; // in the order of the command list
+	};
+
+private:
 	class CCommand : public CCommandInfo
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pNextHash;
+		unsigned m_Hash;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
 		void *m_pUserData;
@@ -38,6 +64,19 @@ class CConsole : public IConsole
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
 
+	enum
+	{
+		COMMAND_HASH_SIZE = 512,
+	};
+	CCommand *m_apCommandHash[COMMAND_HASH_SIZE];
+
+	// commands not registered yet have no flags
+	std::shared_ptr<const CCommandTable> m_pCommandTable;
+	CCommand *m_pTableCommands;
+	// the last one CommandTable() made, until commands are added
+	std::shared_ptr<const CCommandTable> m_pExportedTable;
+	bool m_CommandsAdded;
+
 	class CExecFile
 	{
 	public:
@@ -187,13 +226,21 @@ class CConsole : public IConsole
 		}
 	} m_ExecutionQueue;
 
+	static unsigned HashName(const char *pName);
+	bool IsTableCommand(const CCommand *pCommand) const { return pCommand >= m_pTableCommands && pCommand < m_pTableCommands + (m_pCommandTable ? m_pCommandTable->m_vEntries.size() : 0); }
 	void AddCommandSorted(CCommand *pCommand);
+	void AddCommandHash(CCommand *pCommand);
+	void RemoveCommandHash(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
+	CCommand *FindTableCommand(const char *pName, int Flags);
 
 public:
-	CConsole(int FlagMask);
+	CConsole(int FlagMask, std::shared_ptr<const CCommandTable> pCommandTable = nullptr);
 	~CConsole();
 
+	// the table of the registered commands, for more consoles like this one
+	std::shared_ptr<const CCommandTable> CommandTable();
+
 	virtual void Init();
 	virtual void InitNoConfig(class IStorage *pStorage);
 	virtual const CCommandInfo *FirstCommandInfo(int AccessLevel, int FlagMask) const;
@@ -10,6 +10,8 @@
 
 #include "uuid_manager.h"
 
+#include <utility>
+
 static const int DEBUG = 0;
 
 enum
@@ -101,6 +103,23 @@ struct CDatafileInfo
 	char *m_pDataStart;
 };
 
+enum
+{
+	DATA_OWNED = 0, // allocated for this index alone, freed by UnloadData()
+	DATA_ARENA, // shares an arena block, stays until the file is closed
+	DATA_MAPPED, // served straight from the mapped file
+
+	// decompressed data smaller than a quarter block goes to the arena
+	ARENA_BLOCK_SIZE = 256 * 1024,
+};
+
+struct CDatafileArenaBlock
+{
+	CDatafileArenaBlock *m_pNext;
+	unsigned m_Size;
+	unsigned m_Used;
+};
+
 struct CDatafile
 {
 	IOHANDLE m_File;
@@ -109,10 +128,45 @@ struct CDatafile
 	CDatafileInfo m_Info;
 	CDatafileHeader m_Header;
 	int m_DataStartOffset;
+	// the file as it is on disk, never written to
+	unsigned char *m_pFileData;
+	unsigned m_FileSize;
+	bool m_Mapped;
+	// a second private mapping for uncompressed data handed out by
+	// GetData(), the callers may modify it
+	unsigned char *m_pDataMapping;
+	unsigned m_DataMappingSize;
+	CDatafileArenaBlock *m_pArena;
 	char **m_ppDataPtrs;
+	unsigned char *m_pDataKinds;
 	char *m_pData;
 };
 
+static void ReleaseFileData(unsigned char *pData, unsigned Size, bool Mapped)
+{
+	if(Mapped)
+		io_unmap(pData, Size);
+	else
+		free(pData);
+}
+
+static void *ArenaAlloc(CDatafile *pDataFile, unsigned Size)
+{
+	Size = (Size + 7) & ~7u;
+	CDatafileArenaBlock *pBlock = pDataFile->m_pArena;
+	if(!pBlock || pBlock->m_Size - pBlock->m_Used < Size)
+	{
+		pBlock = (CDatafileArenaBlock *)malloc(sizeof(CDatafileArenaBlock) + ARENA_BLOCK_SIZE);
+		pBlock->m_pNext = pDataFile->m_pArena;
+		pBlock->m_Size = ARENA_BLOCK_SIZE;
+		pBlock->m_Used = 0;
+		pDataFile->m_pArena = pBlock;
+	}
+	void *pData = (char *)(pBlock + 1) + pBlock->m_Used;
+	pBlock->m_Used += Size;
+	return pData;
+}
+
 bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
 {
 	dbg_msg("datafile", "loading. filename='%s'", pFilename);
@@ -124,45 +178,47 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
-	// take the CRC of the file and store it
-	unsigned Crc = 0;
-	SHA256_DIGEST Sha256;
+	// map the whole file, the hashes, the header and the data are all
+	// taken from memory afterwards. read it in one go where mapping fails
+	unsigned FileSize;
+	unsigned char *pFileData = (unsigned char *)io_map(File, &FileSize);
+	bool Mapped = pFileData != 0;
+	if(!Mapped)
 	{
-		enum
+		long FileLength = io_length(File);
+		FileSize = FileLength > 0 ? FileLength : 0;
+		pFileData = (unsigned char *)malloc(maximum(FileSize, 1u));
+		if(io_read(File, pFileData, FileSize) != FileSize)
 		{
-			BUFFER_SIZE = 64 * 1024
-		};
-
-		SHA256_CTX Sha256Ctxt;
-		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[BUFFER_SIZE];
-
-		while(1)
-		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes <= 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes); // ignore_convention
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			dbg_msg("datafile", "couldn't read the file '%s'", pFilename);
+			free(pFileData);
+			io_close(File);
+			return false;
 		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
-
-		io_seek(File, 0, IOSEEK_START);
 	}
 
+	// take the CRC of the file and store it
+	unsigned Crc = crc32(0, pFileData, FileSize); // ignore_convention
+	SHA256_DIGEST Sha256 = sha256(pFileData, FileSize);
+
 	// TODO: change this header
 	CDatafileHeader Header;
-	if(sizeof(Header) != io_read(File, &Header, sizeof(Header)))
+	if(FileSize < sizeof(Header))
 	{
 		dbg_msg("datafile", "couldn't load header");
-		return 0;
+		ReleaseFileData(pFileData, FileSize, Mapped);
+		io_close(File);
+		return false;
 	}
+	mem_copy(&Header, pFileData, sizeof(Header));
 	if(Header.m_aID[0] != 'A' || Header.m_aID[1] != 'T' || Header.m_aID[2] != 'A' || Header.m_aID[3] != 'D')
 	{
 		if(Header.m_aID[0] != 'D' || Header.m_aID[1] != 'A' || Header.m_aID[2] != 'T' || Header.m_aID[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aID[0], Header.m_aID[1], Header.m_aID[2], Header.m_aID[3]);
-			return 0;
+			ReleaseFileData(pFileData, FileSize, Mapped);
+			io_close(File);
+			return false;
 		}
 	}
 
@@ -172,7 +228,9 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
-		return 0;
+		ReleaseFileData(pFileData, FileSize, Mapped);
+		io_close(File);
+		return false;
 	}
 
 	// read in the rest except the data
@@ -183,32 +241,44 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Size += Header.m_NumRawData * sizeof(int); // v4 has uncompressed data sizes as well
 	Size += Header.m_ItemSize;
 
+	unsigned AvailableSize = FileSize - sizeof(CDatafileHeader);
+	if(Size > AvailableSize)
+	{
+		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, AvailableSize);
+		ReleaseFileData(pFileData, FileSize, Mapped);
+		io_close(File);
+		return false;
+	}
+	unsigned ReadSize = Size;
+
 	unsigned AllocSize = Size;
 	AllocSize += sizeof(CDatafile); // add space for info structure
 	AllocSize += Header.m_NumRawData * sizeof(void *); // add space for data pointers
+	AllocSize += Header.m_NumRawData; // add space for data kinds
 
 	CDatafile *pTmpDataFile = (CDatafile *)malloc(AllocSize);
 	pTmpDataFile->m_Header = Header;
 	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
 	pTmpDataFile->m_ppDataPtrs = (char **)(pTmpDataFile + 1);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile + 1) + Header.m_NumRawData * sizeof(char *);
+	pTmpDataFile->m_pDataKinds = (unsigned char *)pTmpDataFile->m_pData + Size;
 	pTmpDataFile->m_File = File;
+	pTmpDataFile->m_pFileData = pFileData;
+	pTmpDataFile->m_FileSize = FileSize;
+	pTmpDataFile->m_Mapped = Mapped;
+	pTmpDataFile->m_pDataMapping = 0;
+	pTmpDataFile->m_DataMappingSize = 0;
+	pTmpDataFile->m_pArena = 0;
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
 
 	// clear the data pointers
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
+	mem_zero(pTmpDataFile->m_pDataKinds, Header.m_NumRawData);
 
-	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
-	if(ReadSize != Size)
-	{
-		io_close(pTmpDataFile->m_File);
-		free(pTmpDataFile);
-		pTmpDataFile = 0;
-		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
-		return false;
-	}
+	// types, offsets, sizes and item data get their own copy, the items can
+	// be modified in place while the file contents stay untouched
+	mem_copy(pTmpDataFile->m_pData, pFileData + sizeof(CDatafileHeader), Size);
 
 	Close();
 	m_pDataFile = pTmpDataFile;
@@ -328,41 +398,73 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 	{
 		// fetch the data size
 		int DataSize = GetFileDataSize(Index);
+		unsigned Offset = m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index];
+		if(DataSize < 0 || Offset > m_pDataFile->m_FileSize || (unsigned)DataSize > m_pDataFile->m_FileSize - Offset)
+		{
+			dbg_msg("datafile", "data index=%d is out of bounds", Index);
+			return 0;
+		}
+		const unsigned char *pFileData = m_pDataFile->m_pFileData + Offset;
 #if defined(CONF_ARCH_ENDIAN_BIG)
 		int SwapSize = DataSize;
 #endif
 
 		if(m_pDataFile->m_Header.m_Version == 4)
 		{
-			// v4 has compressed data
-			void *pTemp = malloc(DataSize);
+			// v4 has compressed data, it's decompressed once and kept
 			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
 			unsigned long s;
 
 			dbg_msg("datafile", "loading data index=%d size=%d uncompressed=%lu", Index, DataSize, UncompressedSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(UncompressedSize);
-
-			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
+			char *pData;
+			if(UncompressedSize <= ARENA_BLOCK_SIZE / 4)
+			{
+				pData = (char *)ArenaAlloc(m_pDataFile, UncompressedSize);
+				m_pDataFile->m_pDataKinds[Index] = DATA_ARENA;
+			}
+			else
+			{
+				pData = (char *)malloc(UncompressedSize);
+				m_pDataFile->m_pDataKinds[Index] = DATA_OWNED;
+			}
 
-			// decompress the data, TODO: check for errors
+			// decompress the data
 			s = UncompressedSize;
-			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef *)pTemp, DataSize); // ignore_convention
+			if(uncompress((Bytef *)pData, &s, (const Bytef *)pFileData, DataSize) != Z_OK) // ignore_convention
+				dbg_msg("datafile", "failed to decompress data index=%d", Index);
+			m_pDataFile->m_ppDataPtrs[Index] = pData;
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
-
-			// clean up the temporary buffers
-			free(pTemp);
 		}
 		else
 		{
-			// load the data
-			dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(DataSize);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
+#if !defined(CONF_ARCH_ENDIAN_BIG)
+			// uncompressed data is used in place, from a mapping of its own
+			// so modifications don't show up in FileData()
+			if(m_pDataFile->m_Mapped && !m_pDataFile->m_pDataMapping)
+			{
+				m_pDataFile->m_pDataMapping = (unsigned char *)io_map(m_pDataFile->m_File, &m_pDataFile->m_DataMappingSize);
+				if(m_pDataFile->m_pDataMapping && m_pDataFile->m_DataMappingSize != m_pDataFile->m_FileSize)
+				{
+					io_unmap(m_pDataFile->m_pDataMapping, m_pDataFile->m_DataMappingSize);
+					m_pDataFile->m_pDataMapping = 0;
+				}
+			}
+			if(m_pDataFile->m_pDataMapping)
+			{
+				m_pDataFile->m_ppDataPtrs[Index] = (char *)m_pDataFile->m_pDataMapping + Offset;
+				m_pDataFile->m_pDataKinds[Index] = DATA_MAPPED;
+			}
+			else
+#endif
+			{
+				// load the data
+				dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
+				m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(DataSize);
+				m_pDataFile->m_pDataKinds[Index] = DATA_OWNED;
+				mem_copy(m_pDataFile->m_ppDataPtrs[Index], pFileData, DataSize);
+			}
 		}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
@@ -386,11 +488,15 @@ void *CDataFileReader::GetDataSwapped(int Index)
 
 void CDataFileReader::UnloadData(int Index)
 {
-	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
+	if(!m_pDataFile || Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
-	//
-	free(m_pDataFile->m_ppDataPtrs[Index]);
+	// data in the arena stays until the file is closed, it's decompressed
+	// once only
+	if(m_pDataFile->m_pDataKinds[Index] == DATA_ARENA)
+		return;
+	if(m_pDataFile->m_pDataKinds[Index] == DATA_OWNED)
+		free(m_pDataFile->m_ppDataPtrs[Index]);
 	m_pDataFile->m_ppDataPtrs[Index] = 0x0;
 }
 
@@ -533,9 +639,20 @@ bool CDataFileReader::Close()
 	// free the data that is loaded
 	int i;
 	for(i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
-		free(m_pDataFile->m_ppDataPtrs[i]);
+		if(m_pDataFile->m_ppDataPtrs[i] && m_pDataFile->m_pDataKinds[i] == DATA_OWNED)
+			free(m_pDataFile->m_ppDataPtrs[i]);
 
+	CDatafileArenaBlock *pBlock = m_pDataFile->m_pArena;
+	while(pBlock)
+	{
+		CDatafileArenaBlock *pNext = pBlock->m_pNext;
+		free(pBlock);
+		pBlock = pNext;
+	}
+
+	io_unmap(m_pDataFile->m_pDataMapping, m_pDataFile->m_DataMappingSize);
 	io_close(m_pDataFile->m_File);
+	ReleaseFileData(m_pDataFile->m_pFileData, m_pDataFile->m_FileSize, m_pDataFile->m_Mapped);
 	free(m_pDataFile);
 	m_pDataFile = 0;
 	return true;
@@ -576,6 +693,25 @@ IOHANDLE CDataFileReader::File()
 	return m_pDataFile->m_File;
 }
 
+const unsigned char *CDataFileReader::FileData() const
+{
+	if(!m_pDataFile)
+		return 0;
+	return m_pDataFile->m_pFileData;
+}
+
+unsigned CDataFileReader::FileSize() const
+{
+	if(!m_pDataFile)
+		return 0;
+	return m_pDataFile->m_FileSize;
+}
+
+void CDataFileReader::Swap(CDataFileReader &Other)
+{
+	std::swap(m_pDataFile, Other.m_pDataFile);
+}
+
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
@@ -52,6 +52,12 @@ public:
 	unsigned Crc() const;
 	int MapSize() const;
 	IOHANDLE File();
+	// the whole file as it was read from disk
+	const unsigned char *FileData() const;
+	unsigned FileSize() const;
+
+	// exchanges the opened files of both readers
+	void Swap(CDataFileReader &Other);
 };
 
 // write access
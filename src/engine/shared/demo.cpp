@@ -14,6 +14,7 @@
 #include "demo.h"
 #include "memheap.h"
 #include "network.h"
+#include "ringbuffer.h"
 #include "snapshot.h"
 
 static const unsigned char s_aHeaderMarker[7] = {'T', 'W', 'D', 'E', 'M', 'O', 0};
@@ -24,7 +25,155 @@ static const unsigned char s_VersionTickCompression = 5; // demo files with this
 static const int s_LengthOffset = 152;
 static const int s_NumMarkersOffset = 176;
 
-CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
+class CDemoWriter::CQueue : public CRingBufferBase
+{
+	void *m_pMemory;
+
+public:
+	CQueue(int Size)
+	{
+		m_pMemory = malloc(Size);
+		Init(m_pMemory, Size, 0);
+	}
+	~CQueue() { free(m_pMemory); }
+
+	CChunk *Allocate(int Size) { return (CChunk *)CRingBufferBase::Allocate(Size); }
+	CChunk *First() { return (CChunk *)CRingBufferBase::First(); }
+	int PopFirst() { return CRingBufferBase::PopFirst(); }
+};
+
+CDemoWriter::CDemoWriter(int QueueSize) :
+	m_QueueSize(QueueSize),
+	m_QueuedBytes(0),
+	m_NumQueued(0),
+	m_NumWritten(0),
+	m_Shutdown(false),
+	m_pThread(nullptr)
+{
+	m_pQueue = new CQueue(QueueSize);
+	m_pBatch = (unsigned char *)malloc(BATCH_SIZE);
+}
+
+CDemoWriter::~CDemoWriter()
+{
+	if(m_pThread)
+	{
+		// the thread drains the queue before exiting
+		m_Shutdown.store(true);
+		m_Work.Signal();
+		thread_wait(m_pThread);
+	}
+	else
+		Drain();
+	delete m_pQueue;
+	free(m_pBatch);
+}
+
+void CDemoWriter::Init()
+{
+	if(!m_pThread)
+		m_pThread = thread_init(Thread, this, "demo writer");
+}
+
+int64 CDemoWriter::Write(IOHANDLE File, const void *pData, int Size, int Offset, bool Close)
+{
+	if(Size > BATCH_SIZE)
+		return 0;
+
+	int64 Ticket;
+	{
+		CScopeLock Lock(&m_Lock);
+		CChunk *pChunk = m_pQueue->Allocate(sizeof(CChunk) + Size);
+		if(!pChunk)
+			return 0;
+		pChunk->m_File = File;
+		pChunk->m_Offset = Offset;
+		pChunk->m_Size = Size;
+		pChunk->m_Close = Close;
+		mem_copy(pChunk + 1, pData, Size);
+		m_QueuedBytes += sizeof(CChunk) + Size;
+		Ticket = ++m_NumQueued;
+	}
+	m_Work.Signal();
+	return Ticket;
+}
+
+void CDemoWriter::Wait(int64 Ticket)
+{
+	if(!m_pThread)
+	{
+		Drain();
+		return;
+	}
+	while(!IsWritten(Ticket))
+		thread_sleep(1000);
+}
+
+void CDemoWriter::Flush()
+{
+	int64 Ticket;
+	{
+		CScopeLock Lock(&m_Lock);
+		Ticket = m_NumQueued;
+	}
+	Wait(Ticket);
+}
+
+void CDemoWriter::Drain()
+{
+	while(true)
+	{
+		IOHANDLE File;
+		int Offset;
+		bool Close;
+		int Size = 0;
+		int Bytes = 0;
+		int NumChunks = 0;
+		{
+			CScopeLock Lock(&m_Lock);
+			CChunk *pChunk = m_pQueue->First();
+			if(!pChunk)
+				return;
+			File = pChunk->m_File;
+			Offset = pChunk->m_Offset;
+			Close = pChunk->m_Close;
+			// consecutive appends to the same file go out in one write
+			do
+			{
+				mem_copy(m_pBatch + Size, pChunk + 1, pChunk->m_Size);
+				Size += pChunk->m_Size;
+				Bytes += sizeof(CChunk) + pChunk->m_Size;
+				NumChunks++;
+				m_pQueue->PopFirst();
+				pChunk = m_pQueue->First();
+			} while(Offset < 0 && !Close && pChunk && pChunk->m_File == File && pChunk->m_Offset < 0 && !pChunk->m_Close && Size + pChunk->m_Size <= BATCH_SIZE);
+		}
+
+		if(Offset >= 0)
+			io_seek(File, Offset, IOSEEK_START);
+		if(Size > 0)
+			io_write(File, m_pBatch, Size);
+		if(Close)
+			io_close(File);
+		m_QueuedBytes -= Bytes;
+		m_NumWritten += NumChunks;
+	}
+}
+
+void CDemoWriter::Thread(void *pUser)
+{
+	CDemoWriter *pSelf = (CDemoWriter *)pUser;
+	while(true)
+	{
+		pSelf->m_Work.Wait();
+		pSelf->Drain();
+		if(pSelf->m_Shutdown.load())
+			break;
+	}
+	pSelf->Drain();
+}
+
+CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData, CDemoWriter *pWriter)
 {
 	m_File = 0;
 	m_aCurrentFilename[0] = '\0';
@@ -33,10 +182,14 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapDat
 	m_LastTickMarker = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_NoMapData = NoMapData;
+	m_pWriter = pWriter;
+	m_KeyframesOnly = false;
+	m_NumDropped = 0;
+	m_LastTicket = 0;
 }
 
 // Record
-int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, SHA256_DIGEST *pSha256, unsigned Crc, const char *pType, unsigned int MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser)
+int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, SHA256_DIGEST *pSha256, unsigned Crc, const char *pType, unsigned int MapSize, const unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser)
 {
 	m_pfnFilter = pfnFilter;
 	m_pUser = pUser;
@@ -44,6 +197,12 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_pMapData = pMapData;
 	m_pConsole = pConsole;
 
+	// the last recording of this recorder might still be in the queue, replace
+	// the file instead of truncating it so the remaining writes of the old
+	// recording don't end up in the new one
+	if(m_pWriter && !m_File && !m_pWriter->IsWritten(m_LastTicket) && str_comp(m_aCurrentFilename, pFilename) == 0)
+		pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+
 	IOHANDLE DemoFile = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 	if(!DemoFile)
 	{
@@ -58,6 +217,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 
 	CDemoHeader Header;
 	CTimelineMarkers TimelineMarkers;
+	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
 	if(m_File)
 	{
 		io_close(DemoFile);
@@ -170,6 +330,8 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_KeyframesOnly = false;
+	m_NumDropped = 0;
 
 	if(m_pConsole)
 	{
@@ -213,45 +375,40 @@ enum
 	CHUNKFLAG_BIGSIZE = 0x10
 };
 
-void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
+int CDemoRecorder::WriteTickMarker(int Tick, int Keyframe, unsigned char *pOut)
 {
+	int Size;
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
-		unsigned char aChunk[5];
-		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER;
-		aChunk[1] = (Tick >> 24) & 0xff;
-		aChunk[2] = (Tick >> 16) & 0xff;
-		aChunk[3] = (Tick >> 8) & 0xff;
-		aChunk[4] = (Tick) & 0xff;
+		pOut[0] = CHUNKTYPEFLAG_TICKMARKER;
+		pOut[1] = (Tick >> 24) & 0xff;
+		pOut[2] = (Tick >> 16) & 0xff;
+		pOut[3] = (Tick >> 8) & 0xff;
+		pOut[4] = (Tick) & 0xff;
 
 		if(Keyframe)
-			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
-
-		io_write(m_File, aChunk, sizeof(aChunk));
+			pOut[0] |= CHUNKTICKFLAG_KEYFRAME;
+		Size = 5;
 	}
 	else
 	{
-		unsigned char aChunk[1];
-		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		pOut[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
+		Size = 1;
 	}
 
 	m_LastTickMarker = Tick;
 	if(m_FirstTick < 0)
 		m_FirstTick = Tick;
+	return Size;
 }
 
-void CDemoRecorder::Write(int Type, const void *pData, int Size)
+int CDemoRecorder::WriteChunk(int Type, const void *pData, int Size, unsigned char *pOut)
 {
 	char aBuffer[64 * 1024];
 	char aBuffer2[64 * 1024];
-	unsigned char aChunk[3];
-
-	if(!m_File)
-		return;
 
 	if(Size > 64 * 1024)
-		return;
+		return 0;
 
 	/* pad the data with 0 so we get an alignment of 4,
 	else the compression won't work and miss some bytes */
@@ -260,50 +417,116 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		aBuffer2[Size++] = 0;
 	Size = CVariableInt::Compress(aBuffer2, Size, aBuffer, sizeof(aBuffer)); // buffer2 -> buffer
 	if(Size < 0)
-		return;
+		return 0;
 
 	Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2)); // buffer -> buffer2
 	if(Size < 0)
-		return;
+		return 0;
 
-	aChunk[0] = ((Type & 0x3) << 5);
+	int HeaderSize;
+	pOut[0] = ((Type & 0x3) << 5);
 	if(Size < 30)
 	{
-		aChunk[0] |= Size;
-		io_write(m_File, aChunk, 1);
+		pOut[0] |= Size;
+		HeaderSize = 1;
 	}
 	else
 	{
 		if(Size < 256)
 		{
-			aChunk[0] |= 30;
-			aChunk[1] = Size & 0xff;
-			io_write(m_File, aChunk, 2);
+			pOut[0] |= 30;
+			pOut[1] = Size & 0xff;
+			HeaderSize = 2;
 		}
 		else
 		{
-			aChunk[0] |= 31;
-			aChunk[1] = Size & 0xff;
-			aChunk[2] = Size >> 8;
-			io_write(m_File, aChunk, 3);
+			pOut[0] |= 31;
+			pOut[1] = Size & 0xff;
+			pOut[2] = Size >> 8;
+			HeaderSize = 3;
+		}
+	}
+
+	mem_copy(pOut + HeaderSize, aBuffer2, Size);
+	return HeaderSize + Size;
+}
+
+bool CDemoRecorder::Commit(const void *pData, int Size)
+{
+	if(!m_pWriter)
+	{
+		io_write(m_File, pData, Size);
+		return true;
+	}
+	int64 Ticket = m_pWriter->Write(m_File, pData, Size);
+	if(!Ticket)
+		return false;
+	m_LastTicket = Ticket;
+	return true;
+}
+
+void CDemoRecorder::CommitAt(int Offset, const void *pData, int Size, bool Close)
+{
+	if(m_pWriter)
+	{
+		int64 Ticket = m_pWriter->Write(m_File, pData, Size, Offset, Close);
+		if(Ticket)
+		{
+			m_LastTicket = Ticket;
+			return;
 		}
+		// the header has to make it into the file, write it directly once
+		// the writer is done with this file
+		m_pWriter->Wait(m_LastTicket);
 	}
+	io_seek(m_File, Offset, IOSEEK_START);
+	io_write(m_File, pData, Size);
+	if(Close)
+		io_close(m_File);
+}
 
-	io_write(m_File, aBuffer2, Size);
+void CDemoRecorder::OnDropped()
+{
+	m_NumDropped++;
+	if(m_KeyframesOnly)
+		return;
+	m_KeyframesOnly = true;
+	if(m_pConsole)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "Demo writer is behind, recording only keyframes to '%s'", m_aCurrentFilename);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
+	}
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 {
-	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
+	if(!m_File)
+		return;
+
+	// tick marker and snapshot or delta
+	unsigned char aChunk[5 + 3 + 64 * 1024];
+	int ChunkSize;
+	int LastTickMarker = m_LastTickMarker;
+	int FirstTick = m_FirstTick;
+	bool Changed = true;
+
+	bool Keyframe = m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5;
+	if(m_KeyframesOnly)
+	{
+		// a keyframe a second at most until the writer caught up
+		if(m_LastKeyFrame != -1 && Tick - m_LastKeyFrame < SERVER_TICK_SPEED)
+			return;
+		Keyframe = true;
+	}
+
+	if(Keyframe)
 	{
 		// write full tickmarker
-		WriteTickMarker(Tick, 1);
+		ChunkSize = WriteTickMarker(Tick, 1, aChunk);
 
 		// write snapshot
-		Write(CHUNKTYPE_SNAPSHOT, pData, Size);
-
-		m_LastKeyFrame = Tick;
-		mem_copy(m_aLastSnapshotData, pData, Size);
+		ChunkSize += WriteChunk(CHUNKTYPE_SNAPSHOT, pData, Size, aChunk + ChunkSize);
 	}
 	else
 	{
@@ -312,16 +535,35 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		int DeltaSize;
 
 		// write tickmarker
-		WriteTickMarker(Tick, 0);
+		ChunkSize = WriteTickMarker(Tick, 0, aChunk);
 
 		DeltaSize = m_pSnapshotDelta->CreateDelta((CSnapshot *)m_aLastSnapshotData, (CSnapshot *)pData, &aDeltaData);
 		if(DeltaSize)
 		{
 			// record delta
-			Write(CHUNKTYPE_DELTA, aDeltaData, DeltaSize);
-			mem_copy(m_aLastSnapshotData, pData, Size);
+			ChunkSize += WriteChunk(CHUNKTYPE_DELTA, aDeltaData, DeltaSize, aChunk + ChunkSize);
 		}
+		Changed = DeltaSize != 0;
 	}
+
+	if(!Commit(aChunk, ChunkSize))
+	{
+		// the next keyframe tries again in a second
+		m_LastTickMarker = LastTickMarker;
+		m_FirstTick = FirstTick;
+		m_LastKeyFrame = Tick;
+		OnDropped();
+		return;
+	}
+
+	if(Keyframe)
+	{
+		m_LastKeyFrame = Tick;
+		if(m_KeyframesOnly && !m_pWriter->IsBacklogged())
+			m_KeyframesOnly = false;
+	}
+	if(Changed)
+		mem_copy(m_aLastSnapshotData, pData, Size);
 }
 
 void CDemoRecorder::RecordMessage(const void *pData, int Size)
@@ -333,7 +575,13 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 			return;
 		}
 	}
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	if(!m_File || m_KeyframesOnly)
+		return;
+
+	unsigned char aChunk[3 + 64 * 1024];
+	int ChunkSize = WriteChunk(CHUNKTYPE_MESSAGE, pData, Size, aChunk);
+	if(ChunkSize > 0 && !Commit(aChunk, ChunkSize))
+		OnDropped();
 }
 
 int CDemoRecorder::Stop()
@@ -342,38 +590,48 @@ int CDemoRecorder::Stop()
 		return -1;
 
 	// add the demo length to the header
-	io_seek(m_File, s_LengthOffset, IOSEEK_START);
 	int DemoLength = Length();
-	char aLength[4];
+	unsigned char aLength[4];
 	aLength[0] = (DemoLength >> 24) & 0xff;
 	aLength[1] = (DemoLength >> 16) & 0xff;
 	aLength[2] = (DemoLength >> 8) & 0xff;
 	aLength[3] = (DemoLength) & 0xff;
-	io_write(m_File, aLength, sizeof(aLength));
+	CommitAt(s_LengthOffset, aLength, sizeof(aLength), false);
 
 	// add the timeline markers to the header
-	io_seek(m_File, s_NumMarkersOffset, IOSEEK_START);
-	char aNumMarkers[4];
-	aNumMarkers[0] = (m_NumTimelineMarkers >> 24) & 0xff;
-	aNumMarkers[1] = (m_NumTimelineMarkers >> 16) & 0xff;
-	aNumMarkers[2] = (m_NumTimelineMarkers >> 8) & 0xff;
-	aNumMarkers[3] = (m_NumTimelineMarkers) & 0xff;
-	io_write(m_File, aNumMarkers, sizeof(aNumMarkers));
+	unsigned char aMarkers[4 + MAX_TIMELINE_MARKERS * 4];
+	aMarkers[0] = (m_NumTimelineMarkers >> 24) & 0xff;
+	aMarkers[1] = (m_NumTimelineMarkers >> 16) & 0xff;
+	aMarkers[2] = (m_NumTimelineMarkers >> 8) & 0xff;
+	aMarkers[3] = (m_NumTimelineMarkers) & 0xff;
 	for(int i = 0; i < m_NumTimelineMarkers; i++)
 	{
 		int Marker = m_aTimelineMarkers[i];
-		char aMarker[4];
-		aMarker[0] = (Marker >> 24) & 0xff;
-		aMarker[1] = (Marker >> 16) & 0xff;
-		aMarker[2] = (Marker >> 8) & 0xff;
-		aMarker[3] = (Marker) & 0xff;
-		io_write(m_File, aMarker, sizeof(aMarker));
+		unsigned char *pMarker = &aMarkers[4 + i * 4];
+		pMarker[0] = (Marker >> 24) & 0xff;
+		pMarker[1] = (Marker >> 16) & 0xff;
+		pMarker[2] = (Marker >> 8) & 0xff;
+		pMarker[3] = (Marker) & 0xff;
 	}
+	CommitAt(s_NumMarkersOffset, aMarkers, 4 + m_NumTimelineMarkers * 4, true);
+#if defined(CONF_FAMILY_WINDOWS)
+	// open files can't be renamed or removed
+	if(m_pWriter)
+		m_pWriter->Wait(m_LastTicket);
+#endif
 
-	io_close(m_File);
 	m_File = 0;
 	if(m_pConsole)
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording");
+	{
+		char aBuf[256];
+		if(m_NumDropped > 0)
+		{
+			str_format(aBuf, sizeof(aBuf), "Stopped recording, %d snapshots and messages were dropped", m_NumDropped);
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
+		}
+		else
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording");
+	}
 
 	return 0;
 }
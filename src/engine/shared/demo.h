@@ -4,12 +4,77 @@
 #define ENGINE_SHARED_DEMO_H
 
 #include <base/hash.h>
+#include <base/tl/threading.h>
 
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
 
 #include "snapshot.h"
 
+#include <atomic>
+
+// Writes the chunks of demo recorders on its own thread, so a slow disk
+// doesn't delay the tick. Appends to the same file are merged into large
+// writes. The queue is bounded, writes fail instead of blocking when it's
+// full.
+class CDemoWriter
+{
+public:
+	enum
+	{
+		DEFAULT_QUEUE_SIZE = 4 * 1024 * 1024,
+		// largest write, has to fit every single chunk
+		BATCH_SIZE = 256 * 1024,
+	};
+
+	CDemoWriter(int QueueSize = DEFAULT_QUEUE_SIZE);
+	~CDemoWriter();
+	CDemoWriter(const CDemoWriter &) = delete;
+
+	// starts the writer thread, without it chunks are only written by Flush
+	void Init();
+
+	// Queues data for the file, appended or at Offset. The file is closed
+	// after the write if Close is set. Returns the ticket of the write, 0 if
+	// the queue is full, nothing is queued then.
+	int64 Write(IOHANDLE File, const void *pData, int Size, int Offset = -1, bool Close = false);
+	// the write with the ticket and everything queued before it is written
+	bool IsWritten(int64 Ticket) const { return m_NumWritten.load() >= Ticket; }
+	// waits until the write with the ticket is written
+	void Wait(int64 Ticket);
+	// waits until everything queued before is written
+	void Flush();
+
+	// more than half of the queue is used
+	bool IsBacklogged() const { return m_QueuedBytes.load() > m_QueueSize / 2; }
+	int QueuedBytes() const { return m_QueuedBytes.load(); }
+
+private:
+	struct CChunk
+	{
+		IOHANDLE m_File;
+		int m_Offset;
+		int m_Size;
+		bool m_Close;
+	};
+	class CQueue;
+
+	int m_QueueSize;
+	CQueue *m_pQueue;
+	unsigned char *m_pBatch;
+	CLock m_Lock;
+	CSemaphore m_Work;
+	std::atomic_int m_QueuedBytes;
+	// chunks queued and written so far, the ticket of a chunk is its number
+	int64 m_NumQueued;
+	std::atomic<int64> m_NumWritten;
+	std::atomic_bool m_Shutdown;
+	void *m_pThread;
+
+	void Drain();
+	static void Thread(void *pUser);
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
 	class IConsole *m_pConsole;
@@ -23,19 +88,31 @@ class CDemoRecorder : public IDemoRecorder
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
 	bool m_NoMapData;
-	unsigned char *m_pMapData;
+	const unsigned char *m_pMapData;
 
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
-	void WriteTickMarker(int Tick, int Keyframe);
-	void Write(int Type, const void *pData, int Size);
+	// chunks go through the writer if set, straight into the file otherwise
+	CDemoWriter *m_pWriter;
+	// the writer's queue was full, skip deltas and messages until a
+	// keyframe makes it in again
+	bool m_KeyframesOnly;
+	int m_NumDropped;
+	// ticket of the last chunk queued for the file
+	int64 m_LastTicket;
+
+	int WriteTickMarker(int Tick, int Keyframe, unsigned char *pOut);
+	int WriteChunk(int Type, const void *pData, int Size, unsigned char *pOut);
+	bool Commit(const void *pData, int Size);
+	void CommitAt(int Offset, const void *pData, int Size, bool Close);
+	void OnDropped();
 
 public:
-	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
+	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false, CDemoWriter *pWriter = nullptr);
 	CDemoRecorder() {}
 
-	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned int MapSize, unsigned char *pMapData, IOHANDLE MapFile = 0, DEMOFUNC_FILTER pfnFilter = 0, void *pUser = 0);
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned int MapSize, const unsigned char *pMapData, IOHANDLE MapFile = 0, DEMOFUNC_FILTER pfnFilter = 0, void *pUser = 0);
 	int Stop();
 	void AddDemoMarker();
 
@@ -46,6 +123,9 @@ public:
 	char *GetCurrentFilename() { return m_aCurrentFilename; }
 
 	int Length() const { return (m_LastTickMarker - m_FirstTick) / SERVER_TICK_SPEED; }
+	bool IsKeyframesOnly() const { return m_KeyframesOnly; }
+	// snapshots and messages that didn't fit into the writer's queue
+	int NumDropped() const { return m_NumDropped; }
 };
 
 class CDemoPlayer : public IDemoPlayer
@@ -46,11 +46,16 @@ class CEcon
 	static int DelClientCallback(int ClientID, const char *pReason, void *pUser);
 
 public:
+	CEcon() :
+		m_Ready(false), m_UserClientID(-1) {}
+
 	IConsole *Console() { return m_pConsole; }
 
 	void Init(CConfig *pConfig, IConsole *pConsole, class CNetBan *pNetBan);
 	void Update();
 	void Send(int ClientID, const char *pLine);
+	// the econ client whose command is currently executed, -1 outside of econ commands
+	int UserClientID() const { return m_UserClientID; }
 	void Shutdown();
 };
 
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "jobs.h"
+#include "metrics.h"
 
 IJob::IJob() :
 	m_Status(STATE_PENDING)
@@ -69,6 +70,7 @@ void CJobPool::WorkerThread(void *pUser)
 			pPool->m_pFirstJob = pPool->m_pFirstJob->m_pNext;
 			if(!pPool->m_pFirstJob)
 				pPool->m_pLastJob = 0;
+			g_MetricJobBacklog.Add(-1);
 		}
 		lock_unlock(pPool->m_Lock);
 
@@ -98,6 +100,7 @@ void CJobPool::Add(std::shared_ptr<IJob> pJob)
 	m_pLastJob = std::move(pJob);
 	if(!m_pFirstJob)
 		m_pFirstJob = m_pLastJob;
+	g_MetricJobBacklog.Add(1);
 
 	lock_unlock(m_Lock);
 	sphore_signal(&m_Semaphore);
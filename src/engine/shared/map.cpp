@@ -51,7 +51,11 @@ void CMap::Unload()
 
 bool CMap::Load(const char *pMapName)
 {
-	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
+	return Load(Kernel()->RequestInterface<IStorage>(), pMapName);
+}
+
+bool CMap::Load(IStorage *pStorage, const char *pMapName)
+{
 	if(!pStorage)
 		return false;
 	return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL);
@@ -82,4 +86,19 @@ IOHANDLE CMap::File()
 	return m_DataFile.File();
 }
 
+const unsigned char *CMap::FileData()
+{
+	return m_DataFile.FileData();
+}
+
+unsigned CMap::FileSize()
+{
+	return m_DataFile.FileSize();
+}
+
+void CMap::Swap(IEngineMap *pOther)
+{
+	m_DataFile.Swap(static_cast<CMap *>(pOther)->m_DataFile);
+}
+
 extern IEngineMap *CreateEngineMap() { return new CMap; }
@@ -28,6 +28,7 @@ public:
 	virtual void Unload();
 
 	virtual bool Load(const char *pMapName);
+	virtual bool Load(class IStorage *pStorage, const char *pMapName);
 
 	virtual bool IsLoaded();
 
@@ -38,6 +39,10 @@ public:
 	virtual int MapSize();
 
 	virtual IOHANDLE File();
+	virtual const unsigned char *FileData();
+	virtual unsigned FileSize();
+
+	virtual void Swap(IEngineMap *pOther);
 };
 
 #endif
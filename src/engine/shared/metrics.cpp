@@ -0,0 +1,215 @@
+#include "metrics.h"
+
+#include <base/math.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <vector>
+
+CMetricCounter g_MetricPacketsIn("ddnet_packets_in_total", "UDP packets received by the game socket");
+CMetricCounter g_MetricPacketsOut("ddnet_packets_out_total", "UDP packets sent by the game socket");
+CMetricCounter g_MetricResends("ddnet_resent_chunks_total", "Vital chunks that had to be sent again");
+CMetricCounter g_MetricBansHit("ddnet_bans_hit_total", "Lookups that matched a ban");
+CMetricGauge g_MetricJobBacklog("ddnet_job_backlog", "Jobs waiting for a job pool worker");
+CMetricGauge g_MetricDbQueueDepth("ddnet_db_queue_depth", "Database tasks waiting for a worker");
+CMetricCounter g_MetricDbTasksDropped("ddnet_db_tasks_dropped_total", "Database tasks dropped because the queue was full");
+
+CMetric *CMetrics::ms_pFirst = nullptr;
+
+struct CMetricsCollector
+{
+	CMetrics::FCollectCallback m_pfnCollect;
+	void *m_pUser;
+};
+
+static LOCK s_CollectorsLock = lock_create();
+static std::vector<CMetricsCollector> s_vCollectors;
+
+void CMetricsWriter::Header(const char *pName, const char *pHelp, const char *pType)
+{
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "# HELP %s %s", pName, pHelp);
+	Line(aBuf);
+	str_format(aBuf, sizeof(aBuf), "# TYPE %s %s", pName, pType);
+	Line(aBuf);
+}
+
+void CMetricsWriter::Sample(const char *pName, const char *pLabels, int64 Value)
+{
+	char aBuf[256];
+	if(pLabels)
+		str_format(aBuf, sizeof(aBuf), "%s{%s} %lld", pName, pLabels, (long long)Value);
+	else
+		str_format(aBuf, sizeof(aBuf), "%s %lld", pName, (long long)Value);
+	Line(aBuf);
+}
+
+void CMetricsWriter::Sample(const char *pName, const char *pLabels, double Value)
+{
+	char aBuf[256];
+	if(pLabels)
+		str_format(aBuf, sizeof(aBuf), "%s{%s} %.9g", pName, pLabels, Value);
+	else
+		str_format(aBuf, sizeof(aBuf), "%s %.9g", pName, Value);
+	Line(aBuf);
+}
+
+CMetric::CMetric(const char *pName, const char *pHelp) :
+	m_pName(pName), m_pHelp(pHelp)
+{
+	// only runs during static initialization, no locking needed
+	m_pNext = CMetrics::ms_pFirst;
+	CMetrics::ms_pFirst = this;
+}
+
+CMetricCounter::CMetricCounter(const char *pName, const char *pHelp) :
+	CMetric(pName, pHelp)
+{
+	for(auto &Shard : m_aShards)
+		Shard.m_Value.store(0);
+}
+
+void CMetricCounter::Add(uint64 Amount)
+{
+	m_aShards[CMetrics::ThreadShard()].m_Value.fetch_add(Amount, std::memory_order_relaxed);
+}
+
+uint64 CMetricCounter::Value() const
+{
+	uint64 Sum = 0;
+	for(const auto &Shard : m_aShards)
+		Sum += Shard.m_Value.load(std::memory_order_relaxed);
+	return Sum;
+}
+
+void CMetricCounter::Write(CMetricsWriter *pWriter) const
+{
+	pWriter->Header(m_pName, m_pHelp, "counter");
+	pWriter->Sample(m_pName, nullptr, (int64)Value());
+}
+
+CMetricGauge::CMetricGauge(const char *pName, const char *pHelp) :
+	CMetric(pName, pHelp), m_Value(0)
+{
+}
+
+void CMetricGauge::Write(CMetricsWriter *pWriter) const
+{
+	pWriter->Header(m_pName, m_pHelp, "gauge");
+	pWriter->Sample(m_pName, nullptr, Value());
+}
+
+CMetricHistogram::CMetricHistogram(const char *pName, const char *pHelp, const int64 *pBounds, int NumBounds, double Scale) :
+	CMetric(pName, pHelp), m_pBounds(pBounds), m_NumBounds(minimum(NumBounds, (int)MAX_BUCKETS)), m_Scale(Scale), m_Sum(0)
+{
+	for(auto &Bucket : m_aBuckets)
+		Bucket.store(0);
+}
+
+void CMetricHistogram::Observe(int64 Value)
+{
+	int Bucket = std::lower_bound(m_pBounds, m_pBounds + m_NumBounds, Value) - m_pBounds;
+	m_aBuckets[Bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(Value, std::memory_order_relaxed);
+}
+
+uint64 CMetricHistogram::Count() const
+{
+	uint64 Count = 0;
+	for(int i = 0; i <= m_NumBounds; i++)
+		Count += BucketCount(i);
+	return Count;
+}
+
+void CMetricHistogram::Write(CMetricsWriter *pWriter) const
+{
+	pWriter->Header(m_pName, m_pHelp, "histogram");
+
+	char aName[128];
+	char aLabels[64];
+	str_format(aName, sizeof(aName), "%s_bucket", m_pName);
+	// the exposition wants cumulative buckets
+	uint64 Cumulative = 0;
+	for(int i = 0; i < m_NumBounds; i++)
+	{
+		Cumulative += BucketCount(i);
+		str_format(aLabels, sizeof(aLabels), "le=\"%.9g\"", m_pBounds[i] / m_Scale);
+		pWriter->Sample(aName, aLabels, (int64)Cumulative);
+	}
+	Cumulative += BucketCount(m_NumBounds);
+	pWriter->Sample(aName, "le=\"+Inf\"", (int64)Cumulative);
+
+	str_format(aName, sizeof(aName), "%s_sum", m_pName);
+	pWriter->Sample(aName, nullptr, m_Sum.load(std::memory_order_relaxed) / m_Scale);
+	str_format(aName, sizeof(aName), "%s_count", m_pName);
+	pWriter->Sample(aName, nullptr, (int64)Cumulative);
+}
+
+int CMetrics::ThreadShard()
+{
+	static std::atomic<int> s_NextShard(0);
+	static thread_local int s_Shard = -1;
+	if(s_Shard < 0)
+		s_Shard = s_NextShard.fetch_add(1) % CMetricCounter::NUM_SHARDS;
+	return s_Shard;
+}
+
+void CMetrics::AddCollector(FCollectCallback pfnCollect, void *pUser)
+{
+	lock_wait(s_CollectorsLock);
+	s_vCollectors.push_back(CMetricsCollector{pfnCollect, pUser});
+	lock_unlock(s_CollectorsLock);
+}
+
+void CMetrics::RemoveCollector(FCollectCallback pfnCollect, void *pUser)
+{
+	lock_wait(s_CollectorsLock);
+	s_vCollectors.erase(std::remove_if(s_vCollectors.begin(), s_vCollectors.end(), [&](const CMetricsCollector &Collector) {
+		return Collector.m_pfnCollect == pfnCollect && Collector.m_pUser == pUser;
+	}),
+		s_vCollectors.end());
+	lock_unlock(s_CollectorsLock);
+}
+
+void CMetrics::Write(CMetricsWriter *pWriter)
+{
+	// sorted by name so consecutive scrapes can be diffed
+	std::vector<const CMetric *> vpMetrics;
+	for(const CMetric *pMetric = ms_pFirst; pMetric; pMetric = pMetric->m_pNext)
+		vpMetrics.push_back(pMetric);
+	std::sort(vpMetrics.begin(), vpMetrics.end(), [](const CMetric *pA, const CMetric *pB) {
+		return str_comp(pA->m_pName, pB->m_pName) < 0;
+	});
+	for(const CMetric *pMetric : vpMetrics)
+		pMetric->Write(pWriter);
+
+	lock_wait(s_CollectorsLock);
+	for(const auto &Collector : s_vCollectors)
+		Collector.m_pfnCollect(pWriter, Collector.m_pUser);
+	lock_unlock(s_CollectorsLock);
+}
+
+static void WriteFileLine(const char *pLine, void *pUser)
+{
+	IOHANDLE File = (IOHANDLE)pUser;
+	io_write(File, pLine, str_length(pLine));
+	io_write(File, "\n", 1);
+}
+
+bool CMetrics::Dump(IStorage *pStorage, const char *pFilename)
+{
+	char aTmpFilename[256];
+	str_format(aTmpFilename, sizeof(aTmpFilename), "%s.tmp", pFilename);
+	IOHANDLE File = pStorage->OpenFile(aTmpFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	CMetricsWriter Writer(WriteFileLine, File);
+	Write(&Writer);
+	io_close(File);
+	if(pStorage->RenameFile(aTmpFilename, pFilename, IStorage::TYPE_SAVE))
+		return true;
+	// windows does not replace existing files on rename
+	pStorage->RemoveFile(pFilename, IStorage::TYPE_SAVE);
+	return pStorage->RenameFile(aTmpFilename, pFilename, IStorage::TYPE_SAVE);
+}
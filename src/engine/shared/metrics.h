@@ -0,0 +1,147 @@
+#ifndef ENGINE_SHARED_METRICS_H
+#define ENGINE_SHARED_METRICS_H
+
+#include <base/system.h>
+
+#include <atomic>
+
+class IStorage;
+
+// Writes the prometheus text exposition format line by line.
+class CMetricsWriter
+{
+public:
+	typedef void (*FLineCallback)(const char *pLine, void *pUser);
+
+private:
+	FLineCallback m_pfnLine;
+	void *m_pUser;
+
+public:
+	CMetricsWriter(FLineCallback pfnLine, void *pUser) :
+		m_pfnLine(pfnLine), m_pUser(pUser) {}
+
+	void Line(const char *pLine) { m_pfnLine(pLine, m_pUser); }
+	void Header(const char *pName, const char *pHelp, const char *pType);
+	// pLabels is the part between the braces, e.g. `room="3"`, or null
+	void Sample(const char *pName, const char *pLabels, int64 Value);
+	void Sample(const char *pName, const char *pLabels, double Value);
+};
+
+// Metrics are global objects that link themselves into the registry on
+// construction, define them with static storage duration only.
+class CMetric
+{
+	friend class CMetrics;
+	CMetric *m_pNext;
+
+protected:
+	const char *m_pName;
+	const char *m_pHelp;
+
+	CMetric(const char *pName, const char *pHelp);
+	virtual ~CMetric() {}
+	virtual void Write(CMetricsWriter *pWriter) const = 0;
+
+public:
+	const char *Name() const { return m_pName; }
+};
+
+// Monotonic counter, every thread adds to its own cache line so it can be
+// bumped from the network and database threads without contention.
+class CMetricCounter : public CMetric
+{
+public:
+	enum
+	{
+		NUM_SHARDS = 16,
+	};
+
+private:
+	struct CShard
+	{
+		std::atomic<uint64> m_Value;
+		char m_aPadding[64 - sizeof(std::atomic<uint64>)];
+	};
+	CShard m_aShards[NUM_SHARDS];
+
+	virtual void Write(CMetricsWriter *pWriter) const;
+
+public:
+	CMetricCounter(const char *pName, const char *pHelp);
+
+	void Add(uint64 Amount = 1);
+	uint64 Value() const;
+};
+
+class CMetricGauge : public CMetric
+{
+	std::atomic<int64> m_Value;
+
+	virtual void Write(CMetricsWriter *pWriter) const;
+
+public:
+	CMetricGauge(const char *pName, const char *pHelp);
+
+	void Set(int64 Value) { m_Value.store(Value, std::memory_order_relaxed); }
+	void Add(int64 Amount) { m_Value.fetch_add(Amount, std::memory_order_relaxed); }
+	int64 Value() const { return m_Value.load(std::memory_order_relaxed); }
+};
+
+// Observations are integers (e.g. microseconds), they are divided by Scale
+// for the exposition so the exported unit can be a base unit like seconds.
+class CMetricHistogram : public CMetric
+{
+public:
+	enum
+	{
+		MAX_BUCKETS = 16,
+	};
+
+private:
+	const int64 *m_pBounds;
+	int m_NumBounds;
+	double m_Scale;
+	std::atomic<uint64> m_aBuckets[MAX_BUCKETS + 1];
+	std::atomic<int64> m_Sum;
+
+	virtual void Write(CMetricsWriter *pWriter) const;
+
+public:
+	// pBounds are the sorted inclusive upper bounds, the +Inf bucket is implicit
+	CMetricHistogram(const char *pName, const char *pHelp, const int64 *pBounds, int NumBounds, double Scale = 1.0);
+
+	void Observe(int64 Value);
+	uint64 Count() const;
+	uint64 BucketCount(int Bucket) const { return m_aBuckets[Bucket].load(std::memory_order_relaxed); }
+};
+
+class CMetrics
+{
+	friend class CMetric;
+	static CMetric *ms_pFirst;
+
+public:
+	// called for every exposition, for metrics that only exist per room, client etc.
+	typedef void (*FCollectCallback)(CMetricsWriter *pWriter, void *pUser);
+
+	static int ThreadShard();
+
+	static void AddCollector(FCollectCallback pfnCollect, void *pUser);
+	static void RemoveCollector(FCollectCallback pfnCollect, void *pUser);
+
+	static void Write(CMetricsWriter *pWriter);
+	// replaces the file atomically so scrapers never see half of it
+	static bool Dump(IStorage *pStorage, const char *pFilename);
+};
+
+// engine wide metrics
+extern CMetricCounter g_MetricPacketsIn;
+extern CMetricCounter g_MetricPacketsOut;
+extern CMetricCounter g_MetricResends;
+extern CMetricCounter g_MetricBansHit;
+extern CMetricGauge g_MetricJobBacklog;
+extern CMetricGauge g_MetricDbQueueDepth;
+extern CMetricCounter g_MetricDbTasksDropped;
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <engine/console.h>
 #include <engine/shared/config.h>
+#include <engine/shared/metrics.h>
 #include <engine/storage.h>
 
 #include "netban.h"
@@ -410,6 +411,7 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
+		g_MetricBansHit.Add();
 		return true;
 	}
 
@@ -421,6 +423,7 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 			if(NetMatch(&pBan->m_Data, pAddr, i, Length))
 			{
 				MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
+				g_MetricBansHit.Add();
 				return true;
 			}
 		}
@@ -4,6 +4,7 @@
 
 #include "config.h"
 #include "huffman.h"
+#include "metrics.h"
 #include "network.h"
 
 void CNetRecvUnpacker::Clear()
@@ -107,6 +108,7 @@ void CNetBase::SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *
 	}
 	mem_copy(aBuffer + DATA_OFFSET, pData, DataSize);
 	net_udp_send(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
+	g_MetricPacketsOut.Add();
 }
 
 void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket, SECURITY_TOKEN SecurityToken, bool Sixup, bool NoCompress)
@@ -177,6 +179,7 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 		aBuffer[1] = pPacket->m_Ack & 0xff;
 		aBuffer[2] = pPacket->m_NumChunks;
 		net_udp_send(Socket, pAddr, aBuffer, FinalSize);
+		g_MetricPacketsOut.Add();
 
 		// log raw socket data
 		if(ms_DataLogSent)
@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "config.h"
+#include "metrics.h"
 #include "network.h"
 #include <base/system.h>
 
@@ -174,6 +175,7 @@ void CNetConnection::ResendChunk(CNetChunkResend *pResend)
 {
 	QueueChunkEx(pResend->m_Flags | NET_CHUNKFLAG_RESEND, pResend->m_DataSize, pResend->m_pData, pResend->m_Sequence);
 	pResend->m_LastSendTime = time_get();
+	g_MetricResends.Add();
 }
 
 void CNetConnection::Resend()
@@ -6,6 +6,7 @@
 #include <engine/console.h>
 
 #include "config.h"
+#include "metrics.h"
 #include "netban.h"
 #include "network.h"
 #include <engine/message.h>
@@ -653,6 +654,7 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		// no more packets for now
 		if(Bytes <= 0)
 			break;
+		g_MetricPacketsIn.Add();
 
 		// check if we just should drop the packet
 		char aBuf[128];
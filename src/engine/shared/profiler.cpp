@@ -0,0 +1,116 @@
+#include "profiler.h"
+#include "json.h"
+
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> CProfiler::ms_Enabled(false);
+
+struct CProfilerThread
+{
+	int m_ID;
+	// only the owning thread writes, Dump() may read a few torn events while it is running
+	std::atomic<uint64> m_NumEvents;
+	CProfiler::CEvent m_aEvents[CProfiler::MAX_EVENTS_PER_THREAD];
+};
+
+static LOCK s_ThreadsLock = lock_create();
+static std::vector<std::unique_ptr<CProfilerThread>> s_vpThreads;
+static thread_local CProfilerThread *s_pThread = nullptr;
+
+void CProfiler::Start()
+{
+	lock_wait(s_ThreadsLock);
+	for(auto &pThread : s_vpThreads)
+		pThread->m_NumEvents.store(0);
+	lock_unlock(s_ThreadsLock);
+	ms_Enabled.store(true);
+}
+
+void CProfiler::Stop()
+{
+	ms_Enabled.store(false);
+}
+
+void CProfiler::Record(const char *pName, int Arg, int64 Start, int64 End)
+{
+	if(!s_pThread)
+	{
+		// buffers live until exit, they are reused by Start()
+		std::unique_ptr<CProfilerThread> pThread(new CProfilerThread());
+		pThread->m_NumEvents.store(0);
+		lock_wait(s_ThreadsLock);
+		pThread->m_ID = s_vpThreads.size();
+		s_pThread = pThread.get();
+		s_vpThreads.push_back(std::move(pThread));
+		lock_unlock(s_ThreadsLock);
+	}
+
+	uint64 Num = s_pThread->m_NumEvents.load(std::memory_order_relaxed);
+	CEvent *pEvent = &s_pThread->m_aEvents[Num % MAX_EVENTS_PER_THREAD];
+	pEvent->m_pName = pName;
+	pEvent->m_Arg = Arg;
+	pEvent->m_Start = Start;
+	pEvent->m_End = End;
+	s_pThread->m_NumEvents.store(Num + 1, std::memory_order_release);
+}
+
+int CProfiler::Dump(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return -1;
+
+	// copy the rings first so writing the file does not race with new events
+	struct CThreadEvents
+	{
+		int m_ID;
+		std::vector<CEvent> m_vEvents;
+	};
+	std::vector<CThreadEvents> vThreads;
+	int64 Origin = -1;
+	lock_wait(s_ThreadsLock);
+	for(auto &pThread : s_vpThreads)
+	{
+		uint64 Num = pThread->m_NumEvents.load(std::memory_order_acquire);
+		uint64 First = Num > MAX_EVENTS_PER_THREAD ? Num - MAX_EVENTS_PER_THREAD : 0;
+		CThreadEvents Events;
+		Events.m_ID = pThread->m_ID;
+		for(uint64 i = First; i < Num; i++)
+		{
+			const CEvent &Event = pThread->m_aEvents[i % MAX_EVENTS_PER_THREAD];
+			Events.m_vEvents.push_back(Event);
+			if(Origin < 0 || Event.m_Start < Origin)
+				Origin = Event.m_Start;
+		}
+		vThreads.push_back(std::move(Events));
+	}
+	lock_unlock(s_ThreadsLock);
+
+	const double Scale = 1000000.0 / time_freq();
+	int NumWritten = 0;
+	char aBuf[512];
+	char aName[128];
+	const char *pHeader = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	io_write(File, pHeader, str_length(pHeader));
+	for(const auto &Thread : vThreads)
+	{
+		for(const auto &Event : Thread.m_vEvents)
+		{
+			int Length = str_format(aBuf, sizeof(aBuf), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+				NumWritten ? "," : "", EscapeJson(aName, sizeof(aName), Event.m_pName), Thread.m_ID,
+				(Event.m_Start - Origin) * Scale, (Event.m_End - Event.m_Start) * Scale);
+			if(Event.m_Arg != NO_ARG)
+				Length += str_format(aBuf + Length, sizeof(aBuf) - Length, ",\"args\":{\"arg\":%d}", Event.m_Arg);
+			Length += str_format(aBuf + Length, sizeof(aBuf) - Length, "}");
+			io_write(File, aBuf, Length);
+			NumWritten++;
+		}
+	}
+	io_write(File, "\n]}\n", 4);
+	io_close(File);
+	return NumWritten;
+}
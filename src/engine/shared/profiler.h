@@ -0,0 +1,64 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+#include <atomic>
+
+class IStorage;
+
+// Scoped timers for finding out where the time of a tick goes. Every thread
+// records into its own ring buffer, the newest events can be written out in
+// the chrome trace format (chrome://tracing, ui.perfetto.dev, speedscope).
+class CProfiler
+{
+	static std::atomic<bool> ms_Enabled;
+
+public:
+	enum
+	{
+		MAX_EVENTS_PER_THREAD = 32 * 1024,
+		NO_ARG = -1,
+	};
+
+	struct CEvent
+	{
+		const char *m_pName; // must be a string literal
+		int m_Arg;
+		int64 m_Start;
+		int64 m_End;
+	};
+
+	static bool Enabled() { return ms_Enabled.load(std::memory_order_relaxed); }
+	static void Start();
+	static void Stop();
+	static void Record(const char *pName, int Arg, int64 Start, int64 End);
+
+	// returns the number of events written or -1 if the file could not be opened
+	static int Dump(IStorage *pStorage, const char *pFilename);
+};
+
+class CProfileScope
+{
+	const char *m_pName;
+	int m_Arg;
+	int64 m_Start;
+
+public:
+	CProfileScope(const char *pName, int Arg = CProfiler::NO_ARG) :
+		m_pName(pName), m_Arg(Arg), m_Start(CProfiler::Enabled() ? time_get_impl() : -1)
+	{
+	}
+	~CProfileScope()
+	{
+		if(m_Start >= 0)
+			CProfiler::Record(m_pName, m_Arg, m_Start, time_get_impl());
+	}
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// times the rest of the enclosing scope, the optional argument is shown with the event (e.g. a room number)
+#define PROFILE_SCOPE(...) CProfileScope PROFILE_CONCAT(ProfileScope, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -4,9 +4,12 @@
 #include "compression.h"
 #include "uuid_manager.h"
 
+#include <base/math.h>
 #include <game/generated/protocol.h>
 #include <game/generated/protocolglue.h>
 
+#include <algorithm>
+
 // CSnapshot
 
 CSnapshotItem *CSnapshot::GetItem(int Index) const
@@ -175,6 +178,7 @@ CSnapshotDelta::CSnapshotDelta()
 	mem_zero(m_aSnapshotDataRate, sizeof(m_aSnapshotDataRate));
 	mem_zero(m_aSnapshotDataUpdates, sizeof(m_aSnapshotDataUpdates));
 	m_SnapshotCurrent = 0;
+	m_DataRateOffset = -1;
 	mem_zero(&m_Empty, sizeof(m_Empty));
 }
 
@@ -184,9 +188,26 @@ CSnapshotDelta::CSnapshotDelta(const CSnapshotDelta &Old)
 	mem_copy(m_aSnapshotDataRate, Old.m_aSnapshotDataRate, sizeof(m_aSnapshotDataRate));
 	mem_copy(m_aSnapshotDataUpdates, Old.m_aSnapshotDataUpdates, sizeof(m_aSnapshotDataUpdates));
 	mem_copy(&m_SnapshotCurrent, &Old.m_SnapshotCurrent, sizeof(m_SnapshotCurrent));
+	m_DataRateOffset = Old.m_DataRateOffset;
 	mem_copy(&m_Empty, &Old.m_Empty, sizeof(m_Empty));
 }
 
+void CSnapshotDelta::ResetDataRate()
+{
+	mem_zero(m_aSnapshotDataRate, sizeof(m_aSnapshotDataRate));
+	mem_zero(m_aSnapshotDataUpdates, sizeof(m_aSnapshotDataUpdates));
+}
+
+// size of the ints once CVariableInt::Compress() packed them
+static int PackedBits(const int *pData, int Num)
+{
+	int Bits = 0;
+	unsigned char aBuf[16];
+	for(int i = 0; i < Num; i++)
+		Bits += (int)(CVariableInt::Pack(aBuf, pData[i]) - aBuf) * 8;
+	return Bits;
+}
+
 void CSnapshotDelta::SetStaticsize(int ItemType, int Size)
 {
 	if(ItemType < 0 || ItemType >= MAX_NETOBJSIZES)
@@ -226,6 +247,8 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 			// deleted
 			pDelta->m_NumDeletedItems++;
 			*pData = pFromItem->Key();
+			if(m_DataRateOffset >= 0)
+				m_aSnapshotDataRate[m_DataRateOffset + pFromItem->Type()] += PackedBits(pData, 1);
 			pData++;
 		}
 	}
@@ -250,6 +273,7 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 		PastIndex = aPastIndices[i];
 
 		bool IncludeSize = pCurItem->Type() >= MAX_NETOBJSIZES || !m_aItemSizes[pCurItem->Type()];
+		int *pItemStart = pData;
 
 		if(PastIndex != -1)
 		{
@@ -282,6 +306,12 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 			pDelta->m_NumUpdateItems++;
 			Count++;
 		}
+
+		if(m_DataRateOffset >= 0 && pData != pItemStart)
+		{
+			m_aSnapshotDataRate[m_DataRateOffset + pCurItem->Type()] += PackedBits(pItemStart, pData - pItemStart);
+			m_aSnapshotDataUpdates[m_DataRateOffset + pCurItem->Type()]++;
+		}
 	}
 
 	if(0)
@@ -543,12 +573,34 @@ void CSnapshotBuilder::Init(bool Sixup)
 	m_NumItems = 0;
 	m_Sixup = Sixup;
 
+	m_MaxSize = CSnapshot::MAX_SIZE;
+	m_MaxItems = MAX_ITEMS;
+	m_Priority = PRIORITY_ESSENTIAL;
+	m_LiveSize = 0;
+	m_NumLiveItems = 0;
+	m_NumDropped = 0;
+	m_NumDropOrder = 0;
+	m_DropOrderBuilt = false;
+
 	for(int i = 0; i < m_NumExtendedItemTypes; i++)
 	{
 		AddExtendedItemType(i);
 	}
 }
 
+void CSnapshotBuilder::SetBudget(int MaxSize, int MaxItems)
+{
+	m_MaxSize = clamp(MaxSize, (int)sizeof(CSnapshot), (int)CSnapshot::MAX_SIZE);
+	m_MaxItems = clamp(MaxItems, 1, (int)MAX_ITEMS);
+}
+
+int CSnapshotBuilder::SetPriority(int Priority)
+{
+	int Old = m_Priority;
+	m_Priority = Priority;
+	return Old;
+}
+
 CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 {
 	return (CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
@@ -559,23 +611,139 @@ int *CSnapshotBuilder::GetItemData(int Key)
 	int i;
 	for(i = 0; i < m_NumItems; i++)
 	{
-		if(GetItem(i)->Key() == Key)
+		if(m_aPriorities[i] != PRIORITY_DROPPED && GetItem(i)->Key() == Key)
 			return GetItem(i)->Data();
 	}
 	return 0;
 }
 
+int CSnapshotBuilder::ItemSize(int Index) const
+{
+	return (Index + 1 < m_NumItems ? m_aOffsets[Index + 1] : m_DataSize) - m_aOffsets[Index];
+}
+
+// heap order, true if B is dropped before A
+bool CSnapshotBuilder::DropsBefore(int A, int B) const
+{
+	return m_aPriorities[A] > m_aPriorities[B] || (m_aPriorities[A] == m_aPriorities[B] && A < B);
+}
+
+void CSnapshotBuilder::PushDropOrder(int Index)
+{
+	m_aDropOrder[m_NumDropOrder++] = Index;
+	std::push_heap(m_aDropOrder, m_aDropOrder + m_NumDropOrder, [this](int A, int B) { return DropsBefore(A, B); });
+}
+
+bool CSnapshotBuilder::DropItem(int BelowPriority)
+{
+	if(!m_DropOrderBuilt)
+	{
+		// essential items are never dropped and stay out of the heap
+		m_NumDropOrder = 0;
+		for(int i = 0; i < m_NumItems; i++)
+			if(m_aPriorities[i] != PRIORITY_DROPPED && m_aPriorities[i] != PRIORITY_ESSENTIAL)
+				m_aDropOrder[m_NumDropOrder++] = i;
+		std::make_heap(m_aDropOrder, m_aDropOrder + m_NumDropOrder, [this](int A, int B) { return DropsBefore(A, B); });
+		m_DropOrderBuilt = true;
+	}
+
+	// the least important item, the latest one of those
+	if(m_NumDropOrder == 0 || m_aPriorities[m_aDropOrder[0]] >= BelowPriority)
+		return false;
+	int Drop = m_aDropOrder[0];
+	std::pop_heap(m_aDropOrder, m_aDropOrder + m_NumDropOrder, [this](int A, int B) { return DropsBefore(A, B); });
+	m_NumDropOrder--;
+
+	m_aPriorities[Drop] = PRIORITY_DROPPED;
+	m_LiveSize -= ItemSize(Drop);
+	m_NumLiveItems--;
+	m_NumDropped++;
+	return true;
+}
+
+void *CSnapshotBuilder::AllocItem(int Size)
+{
+	const int HeaderSize = sizeof(CSnapshot);
+	while(m_NumLiveItems + 1 > m_MaxItems ||
+		HeaderSize + (m_NumLiveItems + 1) * (int)sizeof(int) + m_LiveSize + Size > m_MaxSize)
+	{
+		if(!DropItem(m_Priority))
+		{
+			m_NumDropped++;
+			return 0;
+		}
+	}
+
+	if(m_DataSize + Size > MAX_BUFFER_SIZE || m_NumItems + 1 > MAX_BUFFER_ITEMS)
+	{
+		m_NumDropped++;
+		return 0;
+	}
+
+	void *pItem = m_aData + m_DataSize;
+	m_aOffsets[m_NumItems] = m_DataSize;
+	m_aPriorities[m_NumItems] = m_Priority;
+	if(m_DropOrderBuilt && m_Priority != PRIORITY_ESSENTIAL)
+		PushDropOrder(m_NumItems);
+	m_DataSize += Size;
+	m_NumItems++;
+	m_LiveSize += Size;
+	m_NumLiveItems++;
+	return pItem;
+}
+
+void CSnapshotBuilder::CopyItems(int FromItem, CSnapshotItemCache *pCache) const
+{
+	pCache->m_vOffsets.clear();
+	pCache->m_vData.clear();
+	for(int i = FromItem; i < m_NumItems; i++)
+	{
+		const CSnapshotItem *pItem = (const CSnapshotItem *)&m_aData[m_aOffsets[i]];
+		if(pItem->Type() == 0 || m_aPriorities[i] == PRIORITY_DROPPED) // NETOBJTYPE_EX
+			continue;
+		int Size = ItemSize(i);
+		pCache->m_vOffsets.push_back(pCache->m_vData.size());
+		pCache->m_vData.insert(pCache->m_vData.end(), (const char *)pItem, (const char *)pItem + Size);
+	}
+}
+
+bool CSnapshotBuilder::AddItems(const CSnapshotItemCache &Cache)
+{
+	bool Complete = true;
+	const int NumItems = Cache.m_vOffsets.size();
+	for(int i = 0; i < NumItems; i++)
+	{
+		int Size = (i + 1 < NumItems ? Cache.m_vOffsets[i + 1] : (int)Cache.m_vData.size()) - Cache.m_vOffsets[i];
+		void *pItem = AllocItem(Size);
+		if(pItem)
+			mem_copy(pItem, &Cache.m_vData[Cache.m_vOffsets[i]], Size);
+		else
+			Complete = false;
+	}
+	return Complete;
+}
+
 int CSnapshotBuilder::Finish(void *pSnapData)
 {
 	// dbg_msg("snap", "---------------------------");
-	//  flattern and make the snapshot
+	//  flattern and make the snapshot, leaving out the dropped items
 	CSnapshot *pSnap = (CSnapshot *)pSnapData;
-	int OffsetSize = sizeof(int) * m_NumItems;
-	pSnap->m_DataSize = m_DataSize;
-	pSnap->m_NumItems = m_NumItems;
-	mem_copy(pSnap->Offsets(), m_aOffsets, OffsetSize);
-	mem_copy(pSnap->DataStart(), m_aData, m_DataSize);
-	return sizeof(CSnapshot) + OffsetSize + m_DataSize;
+	int OffsetSize = sizeof(int) * m_NumLiveItems;
+	pSnap->m_DataSize = m_LiveSize;
+	pSnap->m_NumItems = m_NumLiveItems;
+	int *pOffsets = pSnap->Offsets();
+	char *pData = (char *)pSnap->DataStart();
+	int DataSize = 0;
+	for(int i = 0, Item = 0; i < m_NumItems; i++)
+	{
+		if(m_aPriorities[i] == PRIORITY_DROPPED)
+			continue;
+		int Size = ItemSize(i);
+		pOffsets[Item++] = DataSize;
+		mem_copy(pData + DataSize, m_aData + m_aOffsets[i], Size);
+		DataSize += Size;
+	}
+	return sizeof(CSnapshot) + OffsetSize + m_LiveSize;
 }
 
 static int GetTypeFromIndex(int Index)
@@ -588,7 +756,10 @@ void CSnapshotBuilder::AddExtendedItemType(int Index)
 	dbg_assert(0 <= Index && Index < m_NumExtendedItemTypes, "index out of range");
 	int TypeID = m_aExtendedItemTypes[Index];
 	CUuid Uuid = g_UuidManager.GetUuid(TypeID);
+	// items of the type can't be decoded without it, never drop it for the budget
+	int OldPriority = SetPriority(PRIORITY_ESSENTIAL);
 	int *pUuidItem = (int *)NewItem(0, GetTypeFromIndex(Index), sizeof(Uuid)); // NETOBJTYPE_EX
+	SetPriority(OldPriority);
 	if(pUuidItem)
 	{
 		for(int i = 0; i < (int)sizeof(CUuid) / 4; i++)
@@ -615,19 +786,13 @@ int CSnapshotBuilder::GetExtendedItemTypeIndex(int TypeID)
 	int Index = m_NumExtendedItemTypes;
 	m_aExtendedItemTypes[Index] = TypeID;
 	m_NumExtendedItemTypes++;
+	// registered in the middle of a snapshot, Init() adds it to the later ones
+	AddExtendedItemType(Index);
 	return Index;
 }
 
 void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 {
-	if(m_DataSize + sizeof(CSnapshotItem) + Size >= CSnapshot::MAX_SIZE ||
-		m_NumItems + 1 >= MAX_ITEMS)
-	{
-		dbg_assert(m_DataSize < CSnapshot::MAX_SIZE, "too much data");
-		dbg_assert(m_NumItems < MAX_ITEMS, "too many items");
-		return 0;
-	}
-
 	bool Extended = false;
 	if(Type >= OFFSET_UUID)
 	{
@@ -635,8 +800,6 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 		Type = GetTypeFromIndex(GetExtendedItemTypeIndex(Type));
 	}
 
-	CSnapshotItem *pObj = (CSnapshotItem *)(m_aData + m_DataSize);
-
 	if(m_Sixup && !Extended)
 	{
 		if(Type >= 0)
@@ -645,14 +808,20 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 			Type *= -1;
 
 		if(Type < 0)
-			return pObj;
+		{
+			// not part of this protocol, give the caller something to write to
+			if(m_DataSize + (int)sizeof(CSnapshotItem) + Size > MAX_BUFFER_SIZE)
+				return 0;
+			return ((CSnapshotItem *)(m_aData + m_DataSize))->Data();
+		}
 	}
 
+	CSnapshotItem *pObj = (CSnapshotItem *)AllocItem(sizeof(CSnapshotItem) + Size);
+	if(!pObj)
+		return 0;
+
 	mem_zero(pObj, sizeof(CSnapshotItem) + Size);
 	pObj->m_TypeAndID = (Type << 16) | ID;
-	m_aOffsets[m_NumItems] = m_DataSize;
-	m_DataSize += sizeof(CSnapshotItem) + Size;
-	m_NumItems++;
 
 	return pObj->Data();
 }
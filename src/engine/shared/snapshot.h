@@ -5,6 +5,8 @@
 
 #include <base/system.h>
 
+#include <vector>
+
 // CSnapshot
 
 class CSnapshotItem
@@ -72,9 +74,11 @@ private:
 		MAX_NETOBJSIZES = 64
 	};
 	short m_aItemSizes[MAX_NETOBJSIZES];
-	int m_aSnapshotDataRate[0xffff];
-	int m_aSnapshotDataUpdates[0xffff];
+	// summed up for all clients, wide enough to never overflow
+	int64 m_aSnapshotDataRate[0x10000];
+	int64 m_aSnapshotDataUpdates[0x10000];
 	int m_SnapshotCurrent;
+	int m_DataRateOffset;
 	CData m_Empty;
 
 	void UndiffItem(int *pPast, int *pDiff, int *pOut, int Size);
@@ -83,8 +87,17 @@ public:
 	static int DiffItem(int *pPast, int *pCurrent, int *pOut, int Size);
 	CSnapshotDelta();
 	CSnapshotDelta(const CSnapshotDelta &Old);
-	int GetDataRate(int Index) { return m_aSnapshotDataRate[Index]; }
-	int GetDataUpdates(int Index) { return m_aSnapshotDataUpdates[Index]; }
+	enum
+	{
+		DATARATE_SIXUP_OFFSET = 0x8000,
+	};
+
+	int64 GetDataRate(int Index) { return m_aSnapshotDataRate[Index]; }
+	int64 GetDataUpdates(int Index) { return m_aSnapshotDataUpdates[Index]; }
+	// makes CreateDelta() add the packed bits and the number of updates of
+	// every item type to the data rates, sixup types start at DATARATE_SIXUP_OFFSET
+	void SetDataRateAccounting(bool Enabled, bool Sixup = false) { m_DataRateOffset = Enabled ? (Sixup ? (int)DATARATE_SIXUP_OFFSET : 0) : -1; }
+	void ResetDataRate();
 	void SetStaticsize(int ItemType, int Size);
 	CData *EmptyDelta();
 	int CreateDelta(class CSnapshot *pFrom, class CSnapshot *pTo, void *pData);
@@ -122,18 +135,41 @@ public:
 	int Get(int Tick, int64 *pTagtime, CSnapshot **ppData, CSnapshot **ppAltData);
 };
 
+// items taken out of a snapshot builder, to add them to other snapshots of the same protocol
+class CSnapshotItemCache
+{
+public:
+	std::vector<int> m_vOffsets;
+	std::vector<char> m_vData;
+};
+
 class CSnapshotBuilder
 {
+public:
 	enum
 	{
 		MAX_ITEMS = 1024,
 		MAX_EXTENDED_ITEM_TYPES = 64,
+
+		// items that are never dropped for the budget, the default after Init()
+		PRIORITY_ESSENTIAL = 0x7fffffff,
+	};
+
+private:
+	enum
+	{
+		// dropped items keep their space until Finish(), leave room to replace them
+		MAX_BUFFER_ITEMS = MAX_ITEMS * 2,
+		MAX_BUFFER_SIZE = CSnapshot::MAX_SIZE * 2,
+
+		PRIORITY_DROPPED = -0x7fffffff - 1,
 	};
 
-	char m_aData[CSnapshot::MAX_SIZE];
+	char m_aData[MAX_BUFFER_SIZE];
 	int m_DataSize;
 
-	int m_aOffsets[MAX_ITEMS];
+	int m_aOffsets[MAX_BUFFER_ITEMS];
+	int m_aPriorities[MAX_BUFFER_ITEMS];
 	int m_NumItems;
 
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
@@ -144,16 +180,49 @@ class CSnapshotBuilder
 
 	bool m_Sixup;
 
+	// budget of the finished snapshot
+	int m_MaxSize;
+	int m_MaxItems;
+	int m_Priority;
+	int m_LiveSize;
+	int m_NumLiveItems;
+	int m_NumDropped;
+
+	// heap of the items that may be dropped, least important and latest on
+	// top, only built once the snapshot first exceeds its budget
+	int m_aDropOrder[MAX_BUFFER_ITEMS];
+	int m_NumDropOrder;
+	bool m_DropOrderBuilt;
+	bool DropsBefore(int A, int B) const;
+	void PushDropOrder(int Index);
+
+	int ItemSize(int Index) const;
+	bool DropItem(int BelowPriority);
+	void *AllocItem(int Size);
+
 public:
 	CSnapshotBuilder();
 
 	void Init(bool Sixup = false);
+	// limits the size of the finished snapshot, including its header and
+	// offsets, items of the lowest priority are dropped to stay inside
+	void SetBudget(int MaxSize, int MaxItems);
+	// the priority of the items added next, returns the previous one
+	int SetPriority(int Priority);
+	int NumDropped() const { return m_NumDropped; }
 
 	void *NewItem(int Type, int ID, int Size);
 
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
 
+	int NumItems() const { return m_NumItems; }
+	// copies the items added since FromItem, leaving out the extended type
+	// registrations as Init() adds them to every snapshot anyway
+	void CopyItems(int FromItem, CSnapshotItemCache *pCache) const;
+	// returns false if items had to be left out
+	bool AddItems(const CSnapshotItemCache &Cache);
+
 	int Finish(void *pSnapdata);
 };
 
@@ -51,6 +51,7 @@ CCollision::CCollision()
 	m_pDoor = 0;
 	m_pSwitchers = 0;
 	m_pTune = 0;
+	m_Version = 0;
 }
 
 CCollision::~CCollision()
@@ -61,6 +62,7 @@ CCollision::~CCollision()
 void CCollision::Init(class CLayers *pLayers, CPrng *pPrng)
 {
 	Dest();
+	m_Version++;
 	m_NumSwitchers = 0;
 	m_pLayers = pLayers;
 	m_pPrng = pPrng;
@@ -1181,6 +1183,7 @@ void CCollision::SetCollisionAt(float x, float y, int id)
 	int Ny = clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = id;
+	m_Version++;
 }
 
 void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -1193,6 +1196,7 @@ void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Numb
 	m_pDoor[Ny * m_Width + Nx].m_Index = Type;
 	m_pDoor[Ny * m_Width + Nx].m_Flags = Flags;
 	m_pDoor[Ny * m_Width + Nx].m_Number = Number;
+	m_Version++;
 }
 
 int CCollision::GetDTileIndex(int Index) const
@@ -1362,3 +1366,151 @@ int CCollision::IsFCheckpoint(int Index) const
 		return z - 35;
 	return -1;
 }
+
+CLineOfSight::CLineOfSight(int Type)
+{
+	m_Type = Type;
+	m_From = vec2(0, 0);
+	m_Range = 0.0f;
+	m_Version = -1;
+	m_pCollision = 0;
+	m_X0 = 0;
+	m_Y0 = 0;
+	m_Size = 0;
+}
+
+void CLineOfSight::Reset(const CCollision *pCollision, vec2 From, float Range)
+{
+	m_pCollision = pCollision;
+	m_From = From;
+	m_Range = Range;
+	m_Version = pCollision->Version();
+
+	int Radius = (int)ceilf(Range / 32.0f) + 1;
+	m_X0 = (int)floorf(From.x / 32.0f) - Radius;
+	m_Y0 = (int)floorf(From.y / 32.0f) - Radius;
+	m_Size = Radius * 2 + 1;
+	int NumWords = (m_Size * m_Size + 63) / 64;
+	m_vKnown.assign(NumWords, 0);
+	m_vClear.assign(NumWords, 0);
+}
+
+bool CLineOfSight::IsBlocker(int x, int y) const
+{
+	switch(m_Type)
+	{
+	case LOS_LINE:
+		return m_pCollision->IsSolid(x * 32, y * 32);
+	case LOS_NOLASER:
+	{
+		int Index = m_pCollision->GetIndex(x, y);
+		return Index == TILE_SOLID || Index == TILE_NOHOOK || Index == TILE_NOLASER || m_pCollision->GetFIndex(x, y) == TILE_NOLASER;
+	}
+	default:
+		return m_pCollision->IsNoLaser(x * 32, y * 32) || m_pCollision->IsFNoLaser(x * 32, y * 32);
+	}
+}
+
+// whether every ray from m_From to any point of the tile misses all blockers.
+// The rays lie in the convex hull of m_From and the tile, so it suffices that
+// no blocker, grown by the rounding of the sampled positions, touches the hull
+bool CLineOfSight::TileClear(int x, int y) const
+{
+	const float Margin = 2.0f;
+	vec2 aHull[5] = {
+		m_From,
+		vec2(x * 32.0f, y * 32.0f),
+		vec2(x * 32.0f + 32.0f, y * 32.0f),
+		vec2(x * 32.0f, y * 32.0f + 32.0f),
+		vec2(x * 32.0f + 32.0f, y * 32.0f + 32.0f),
+	};
+	vec2 Min = vec2(minimum(m_From.x, x * 32.0f) - Margin, minimum(m_From.y, y * 32.0f) - Margin);
+	vec2 Max = vec2(maximum(m_From.x, x * 32.0f + 32.0f) + Margin, maximum(m_From.y, y * 32.0f + 32.0f) + Margin);
+
+	// positions outside of the map get clamped to the border tiles, leave those to the exact check
+	if(Min.x < 0.0f || Min.y < 0.0f || Max.x >= m_pCollision->GetWidth() * 32.0f || Max.y >= m_pCollision->GetHeight() * 32.0f)
+		return false;
+
+	vec2 aAxes[6] = {vec2(1, 0), vec2(0, 1)};
+	for(int i = 0; i < 4; i++)
+	{
+		vec2 Dir = aHull[i + 1] - m_From;
+		aAxes[i + 2] = vec2(-Dir.y, Dir.x);
+	}
+
+	for(int by = (int)(Min.y / 32.0f); by <= (int)(Max.y / 32.0f); by++)
+	{
+		for(int bx = (int)(Min.x / 32.0f); bx <= (int)(Max.x / 32.0f); bx++)
+		{
+			if(!IsBlocker(bx, by))
+				continue;
+
+			// sampled positions are rounded, so a blocker reaches up to half a unit further
+			vec2 aBlocker[4] = {
+				vec2(bx * 32.0f - Margin, by * 32.0f - Margin),
+				vec2(bx * 32.0f + 32.0f + Margin, by * 32.0f - Margin),
+				vec2(bx * 32.0f - Margin, by * 32.0f + 32.0f + Margin),
+				vec2(bx * 32.0f + 32.0f + Margin, by * 32.0f + 32.0f + Margin),
+			};
+
+			bool Separated = false;
+			for(int a = 0; a < 6 && !Separated; a++)
+			{
+				float HullMin = dot(aAxes[a], aHull[0]), HullMax = HullMin;
+				for(int i = 1; i < 5; i++)
+				{
+					float d = dot(aAxes[a], aHull[i]);
+					HullMin = minimum(HullMin, d);
+					HullMax = maximum(HullMax, d);
+				}
+				float BlockerMin = dot(aAxes[a], aBlocker[0]), BlockerMax = BlockerMin;
+				for(int i = 1; i < 4; i++)
+				{
+					float d = dot(aAxes[a], aBlocker[i]);
+					BlockerMin = minimum(BlockerMin, d);
+					BlockerMax = maximum(BlockerMax, d);
+				}
+				Separated = BlockerMax < HullMin || BlockerMin > HullMax;
+			}
+			if(!Separated)
+				return false;
+		}
+	}
+	return true;
+}
+
+int CLineOfSight::Intersect(vec2 From, vec2 To) const
+{
+	switch(m_Type)
+	{
+	case LOS_LINE:
+		return m_pCollision->IntersectLine(From, To, 0, 0);
+	case LOS_NOLASER:
+		return m_pCollision->IntersectNoLaser(From, To, 0, 0);
+	default:
+		return m_pCollision->IntersectNoLaserNW(From, To, 0, 0);
+	}
+}
+
+bool CLineOfSight::Blocked(const CCollision *pCollision, vec2 From, vec2 To, float Range)
+{
+	if(pCollision != m_pCollision || From != m_From || Range != m_Range || pCollision->Version() != m_Version)
+		Reset(pCollision, From, Range);
+
+	int x = (int)floorf(To.x / 32.0f) - m_X0;
+	int y = (int)floorf(To.y / 32.0f) - m_Y0;
+	if(x < 0 || y < 0 || x >= m_Size || y >= m_Size)
+		return Intersect(From, To) != 0;
+
+	int Bit = y * m_Size + x;
+	uint64 Mask = (uint64)1 << (Bit % 64);
+	if(!(m_vKnown[Bit / 64] & Mask))
+	{
+		m_vKnown[Bit / 64] |= Mask;
+		if(TileClear(x + m_X0, y + m_Y0))
+			m_vClear[Bit / 64] |= Mask;
+	}
+	if(m_vClear[Bit / 64] & Mask)
+		return false;
+	return Intersect(From, To) != 0;
+}
@@ -3,6 +3,7 @@
 #ifndef GAME_COLLISION_H
 #define GAME_COLLISION_H
 
+#include <base/system.h>
 #include <base/vmath.h>
 #include <engine/shared/protocol.h>
 
@@ -140,6 +141,9 @@ public:
 	class CLayers *Layers() { return m_pLayers; }
 	int m_NumSwitchers;
 
+	// changes whenever tiles are modified at runtime
+	int Version() const { return m_Version; }
+
 private:
 	class CTeleTile *m_pTele;
 	class CSpeedupTile *m_pSpeedup;
@@ -147,6 +151,7 @@ private:
 	class CSwitchTile *m_pSwitch;
 	class CTuneTile *m_pTune;
 	class CDoorTile *m_pDoor;
+	int m_Version;
 	struct SSwitchers
 	{
 		bool m_Status[MAX_CLIENTS];
@@ -163,4 +168,41 @@ public:
 };
 
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *Ox, int *Oy);
+
+// line of sight from a fixed point to everything within a range around it.
+// Tiles whose whole area can be seen without any blocking tile in the way
+// are remembered in a bitmap, rays to the other ones are walked as usual.
+class CLineOfSight
+{
+public:
+	enum
+	{
+		LOS_LINE = 0, // IntersectLine
+		LOS_NOLASER, // IntersectNoLaser
+		LOS_NOLASER_NW, // IntersectNoLaserNW
+	};
+
+	CLineOfSight(int Type);
+
+	// same result as the matching intersect function returning non-zero
+	bool Blocked(const CCollision *pCollision, vec2 From, vec2 To, float Range);
+
+private:
+	int m_Type;
+	vec2 m_From;
+	float m_Range;
+	int m_Version;
+	const CCollision *m_pCollision;
+
+	int m_X0;
+	int m_Y0;
+	int m_Size;
+	std::vector<uint64> m_vKnown;
+	std::vector<uint64> m_vClear;
+
+	void Reset(const CCollision *pCollision, vec2 From, float Range);
+	bool IsBlocker(int x, int y) const;
+	bool TileClear(int x, int y) const;
+	int Intersect(vec2 From, vec2 To) const;
+};
 #endif
@@ -11,6 +11,26 @@ const char *CTuningParams::ms_apNames[] =
 #undef MACRO_TUNING_PARAM
 };
 
+const CTuningParams CWorldCore::ms_DefaultTuning;
+
+void CWorldCore::SetCharacter(int ClientID, CCharacterCore *pCharCore)
+{
+	m_apCharacters[ClientID] = pCharCore;
+
+	m_NumCharacters = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(m_apCharacters[i])
+			m_aCharacterIDs[m_NumCharacters++] = i;
+}
+
+int CTuningParams::Index(const char *pName)
+{
+	for(int i = 0; i < Num(); i++)
+		if(str_comp_nocase(pName, ms_apNames[i]) == 0)
+			return i;
+	return -1;
+}
+
 bool CTuningParams::Set(int Index, float Value)
 {
 	if(Index < 0 || Index >= Num())
@@ -29,19 +49,12 @@ bool CTuningParams::Get(int Index, float *pValue) const
 
 bool CTuningParams::Set(const char *pName, float Value)
 {
-	for(int i = 0; i < Num(); i++)
-		if(str_comp_nocase(pName, ms_apNames[i]) == 0)
-			return Set(i, Value);
-	return false;
+	return Set(Index(pName), Value);
 }
 
 bool CTuningParams::Get(const char *pName, float *pValue) const
 {
-	for(int i = 0; i < Num(); i++)
-		if(str_comp_nocase(pName, ms_apNames[i]) == 0)
-			return Get(i, pValue);
-
-	return false;
+	return Get(Index(pName), pValue);
 }
 
 float HermiteBasis1(float v)
@@ -122,11 +135,11 @@ void CCharacterCore::Tick(bool UseInput)
 
 	vec2 TargetDirection = normalize(vec2(m_Input.m_TargetX, m_Input.m_TargetY));
 
-	m_Vel.y += m_pWorld->m_Tuning.m_Gravity;
+	m_Vel.y += m_pWorld->m_pTuning->m_Gravity;
 
-	float MaxSpeed = Grounded ? m_pWorld->m_Tuning.m_GroundControlSpeed : m_pWorld->m_Tuning.m_AirControlSpeed;
-	float Accel = Grounded ? m_pWorld->m_Tuning.m_GroundControlAccel : m_pWorld->m_Tuning.m_AirControlAccel;
-	float Friction = Grounded ? m_pWorld->m_Tuning.m_GroundFriction : m_pWorld->m_Tuning.m_AirFriction;
+	float MaxSpeed = Grounded ? m_pWorld->m_pTuning->m_GroundControlSpeed : m_pWorld->m_pTuning->m_AirControlSpeed;
+	float Accel = Grounded ? m_pWorld->m_pTuning->m_GroundControlAccel : m_pWorld->m_pTuning->m_AirControlAccel;
+	float Friction = Grounded ? m_pWorld->m_pTuning->m_GroundFriction : m_pWorld->m_pTuning->m_AirFriction;
 
 	// handle input
 	if(UseInput)
@@ -153,14 +166,14 @@ void CCharacterCore::Tick(bool UseInput)
 				if(Grounded)
 				{
 					m_TriggeredEvents |= COREEVENT_GROUND_JUMP;
-					m_Vel.y = -m_pWorld->m_Tuning.m_GroundJumpImpulse;
+					m_Vel.y = -m_pWorld->m_pTuning->m_GroundJumpImpulse;
 					m_Jumped |= 1;
 					m_JumpedTotal = 1;
 				}
 				else if(!(m_Jumped & 2))
 				{
 					m_TriggeredEvents |= COREEVENT_AIR_JUMP;
-					m_Vel.y = -m_pWorld->m_Tuning.m_AirJumpImpulse;
+					m_Vel.y = -m_pWorld->m_pTuning->m_AirJumpImpulse;
 					m_Jumped |= 3;
 					m_JumpedTotal++;
 				}
@@ -178,7 +191,7 @@ void CCharacterCore::Tick(bool UseInput)
 				m_HookPos = m_Pos + TargetDirection * PhysSize * 1.5f;
 				m_HookDir = TargetDirection;
 				m_HookedPlayer = -1;
-				m_HookTick = SERVER_TICK_SPEED * (1.25f - m_pWorld->m_Tuning.m_HookDuration);
+				m_HookTick = SERVER_TICK_SPEED * (1.25f - m_pWorld->m_pTuning->m_HookDuration);
 				m_TriggeredEvents |= COREEVENT_HOOK_LAUNCH;
 			}
 		}
@@ -226,11 +239,11 @@ void CCharacterCore::Tick(bool UseInput)
 	}
 	else if(m_HookState == HOOK_FLYING)
 	{
-		vec2 NewPos = m_HookPos + m_HookDir * m_pWorld->m_Tuning.m_HookFireSpeed;
-		if((!m_NewHook && distance(m_Pos, NewPos) > m_pWorld->m_Tuning.m_HookLength) || (m_NewHook && distance(m_HookTeleBase, NewPos) > m_pWorld->m_Tuning.m_HookLength))
+		vec2 NewPos = m_HookPos + m_HookDir * m_pWorld->m_pTuning->m_HookFireSpeed;
+		if((!m_NewHook && distance(m_Pos, NewPos) > m_pWorld->m_pTuning->m_HookLength) || (m_NewHook && distance(m_HookTeleBase, NewPos) > m_pWorld->m_pTuning->m_HookLength))
 		{
 			m_HookState = HOOK_RETRACT_START;
-			NewPos = m_Pos + normalize(NewPos - m_Pos) * m_pWorld->m_Tuning.m_HookLength;
+			NewPos = m_Pos + normalize(NewPos - m_Pos) * m_pWorld->m_pTuning->m_HookLength;
 			m_pReset = true;
 		}
 
@@ -255,13 +268,21 @@ void CCharacterCore::Tick(bool UseInput)
 		}
 
 		// Check against other players first
-		if(this->m_Hook && m_pWorld && m_pWorld->m_Tuning.m_PlayerHooking)
+		if(this->m_Hook && m_pWorld && m_pWorld->m_pTuning->m_PlayerHooking)
 		{
+			// nothing outside the box around the hook's path can be within reach of it
+			const float Reach = PhysSize + 2.0f + 1.0f;
+			const vec2 BoxMin = vec2(minimum(m_HookPos.x, NewPos.x) - Reach, minimum(m_HookPos.y, NewPos.y) - Reach);
+			const vec2 BoxMax = vec2(maximum(m_HookPos.x, NewPos.x) + Reach, maximum(m_HookPos.y, NewPos.y) + Reach);
+
 			float Distance = 0.0f;
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int c = 0; c < m_pWorld->m_NumCharacters; c++)
 			{
+				int i = m_pWorld->m_aCharacterIDs[c];
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
+				if(m_pWorld->m_Cull && (pCharCore->m_Pos.x < BoxMin.x || pCharCore->m_Pos.x > BoxMax.x || pCharCore->m_Pos.y < BoxMin.y || pCharCore->m_Pos.y > BoxMax.y))
+					continue;
+				if(pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
 
 				vec2 ClosestPoint;
@@ -335,7 +356,7 @@ void CCharacterCore::Tick(bool UseInput)
 		// don't do this hook rutine when we are hook to a player
 		if(m_HookedPlayer == -1 && distance(m_HookPos, m_Pos) > 46.0f)
 		{
-			vec2 HookVel = normalize(m_HookPos - m_Pos) * m_pWorld->m_Tuning.m_HookDragAccel;
+			vec2 HookVel = normalize(m_HookPos - m_Pos) * m_pWorld->m_pTuning->m_HookDragAccel;
 			// the hook as more power to drag you up then down.
 			// this makes it easier to get on top of an platform
 			if(HookVel.y > 0)
@@ -351,7 +372,7 @@ void CCharacterCore::Tick(bool UseInput)
 			vec2 NewVel = m_Vel + HookVel;
 
 			// check if we are under the legal limit for the hook
-			if(length(NewVel) < m_pWorld->m_Tuning.m_HookDragSpeed || length(NewVel) < length(m_Vel))
+			if(length(NewVel) < m_pWorld->m_pTuning->m_HookDragSpeed || length(NewVel) < length(m_Vel))
 				m_Vel = NewVel; // no problem. apply
 		}
 
@@ -367,10 +388,14 @@ void CCharacterCore::Tick(bool UseInput)
 
 	if(m_pWorld)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int c = 0; c < m_pWorld->m_NumCharacters; c++)
 		{
+			int i = m_pWorld->m_aCharacterIDs[c];
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-			if(!pCharCore)
+
+			// only the hooked player is influenced from further away than the collision distance
+			const float Reach = PhysSize * 1.25f + 1.0f;
+			if(m_pWorld->m_Cull && i != m_HookedPlayer && (absolute(m_Pos.x - pCharCore->m_Pos.x) > Reach || absolute(m_Pos.y - pCharCore->m_Pos.y) > Reach))
 				continue;
 
 			// player *p = (player*)ent;
@@ -388,7 +413,7 @@ void CCharacterCore::Tick(bool UseInput)
 			{
 				vec2 Dir = normalize(m_Pos - pCharCore->m_Pos);
 
-				bool CanCollide = (m_Super || pCharCore->m_Super) || (pCharCore->m_Collision && m_Collision && !m_NoCollision && !pCharCore->m_NoCollision && m_pWorld->m_Tuning.m_PlayerCollision);
+				bool CanCollide = (m_Super || pCharCore->m_Super) || (pCharCore->m_Collision && m_Collision && !m_NoCollision && !pCharCore->m_NoCollision && m_pWorld->m_pTuning->m_PlayerCollision);
 
 				if(CanCollide && Distance < PhysSize * 1.25f && Distance > 0.0f)
 				{
@@ -405,11 +430,11 @@ void CCharacterCore::Tick(bool UseInput)
 				}
 
 				// handle hook influence
-				if(m_Hook && m_HookedPlayer == i && m_pWorld->m_Tuning.m_PlayerHooking)
+				if(m_Hook && m_HookedPlayer == i && m_pWorld->m_pTuning->m_PlayerHooking)
 				{
 					if(Distance > PhysSize * 1.50f) // TODO: fix tweakable variable
 					{
-						float Accel = m_pWorld->m_Tuning.m_HookDragAccel * (Distance / m_pWorld->m_Tuning.m_HookLength);
+						float Accel = m_pWorld->m_pTuning->m_HookDragAccel * (Distance / m_pWorld->m_pTuning->m_HookLength);
 
 						// add force to the hooked player
 						pCharCore->m_HookDragVel += Dir * Accel * 1.5f;
@@ -435,7 +460,7 @@ void CCharacterCore::Tick(bool UseInput)
 void CCharacterCore::AddDragVelocity()
 {
 	// Apply hook interaction velocity
-	float DragSpeed = m_pWorld->m_Tuning.m_HookDragSpeed;
+	float DragSpeed = m_pWorld->m_pTuning->m_HookDragSpeed;
 
 	vec2 Temp;
 	Temp.x = SaturatedAdd(-DragSpeed, DragSpeed, m_Vel.x, m_HookDragVel.x);
@@ -450,7 +475,7 @@ void CCharacterCore::ResetDragVelocity()
 
 void CCharacterCore::Move()
 {
-	float RampValue = VelocityRamp(length(m_Vel) * 50, m_pWorld->m_Tuning.m_VelrampStart, m_pWorld->m_Tuning.m_VelrampRange, m_pWorld->m_Tuning.m_VelrampCurvature);
+	float RampValue = VelocityRamp(length(m_Vel) * 50, m_pWorld->m_pTuning->m_VelrampStart, m_pWorld->m_pTuning->m_VelrampRange, m_pWorld->m_pTuning->m_VelrampCurvature);
 
 	m_Vel.x = m_Vel.x * RampValue;
 
@@ -472,23 +497,38 @@ void CCharacterCore::Move()
 
 	m_Vel.x = m_Vel.x * (1.0f / RampValue);
 
-	if(m_pWorld && (m_Super || (m_pWorld->m_Tuning.m_PlayerCollision && m_Collision && !m_NoCollision && !m_Solo)))
+	if(m_pWorld && (m_Super || (m_pWorld->m_pTuning->m_PlayerCollision && m_Collision && !m_NoCollision && !m_Solo)))
 	{
 		// check player collision
 		float Distance = distance(m_Pos, NewPos);
 		if(Distance > 0)
 		{
+			// gather the characters close enough to the movement to be touched once,
+			// instead of testing all of them at every step along the way
+			const float Reach = 28.0f + 1.0f;
+			const vec2 BoxMin = vec2(minimum(m_Pos.x, NewPos.x) - Reach, minimum(m_Pos.y, NewPos.y) - Reach);
+			const vec2 BoxMax = vec2(maximum(m_Pos.x, NewPos.x) + Reach, maximum(m_Pos.y, NewPos.y) + Reach);
+			int aNearby[MAX_CLIENTS];
+			int NumNearby = 0;
+			for(int c = 0; c < m_pWorld->m_NumCharacters; c++)
+			{
+				int p = m_pWorld->m_aCharacterIDs[c];
+				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
+				if(pCharCore == this || (m_pWorld->m_Cull && (pCharCore->m_Pos.x < BoxMin.x || pCharCore->m_Pos.x > BoxMax.x || pCharCore->m_Pos.y < BoxMin.y || pCharCore->m_Pos.y > BoxMax.y)))
+					continue;
+				aNearby[NumNearby++] = p;
+			}
+
 			int End = Distance + 1;
 			vec2 LastPos = m_Pos;
-			for(int i = 0; i < End; i++)
+			for(int i = 0; i < End && NumNearby > 0; i++)
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int n = 0; n < NumNearby; n++)
 				{
+					int p = aNearby[n];
 					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-					if(!pCharCore || pCharCore == this)
-						continue;
 					if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || !pCharCore->m_Collision || pCharCore->m_NoCollision || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
 						continue;
 					float D = distance(Pos, pCharCore->m_Pos);
@@ -58,6 +58,7 @@ public:
 	{
 		return sizeof(CTuningParams) / sizeof(int);
 	}
+	static int Index(const char *pName);
 	bool Set(int Index, float Value);
 	bool Set(const char *pName, float Value);
 	bool Get(int Index, float *pValue) const;
@@ -172,10 +173,27 @@ public:
 	CWorldCore()
 	{
 		mem_zero(m_apCharacters, sizeof(m_apCharacters));
+		m_NumCharacters = 0;
+		m_Cull = true;
+		m_pTuning = &ms_DefaultTuning;
 	}
 
-	CTuningParams m_Tuning;
+	// keeps the compact id list in sync, always use this instead of writing m_apCharacters
+	void SetCharacter(int ClientID, class CCharacterCore *pCharCore);
+
+	// points to the tuning currently in effect, owned by the game context or the room
+	const CTuningParams *m_pTuning;
+	static const CTuningParams ms_DefaultTuning;
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
+
+	// ids of the present characters in ascending order, so loops over them
+	// visit characters in the same order as a loop over m_apCharacters
+	int m_aCharacterIDs[MAX_CLIENTS];
+	int m_NumCharacters;
+
+	// skip characters that are too far away to interact, only turned off to
+	// check the results against the full loops
+	bool m_Cull;
 };
 
 class CCharacterCore
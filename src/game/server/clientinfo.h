@@ -0,0 +1,58 @@
+#ifndef GAME_SERVER_CLIENTINFO_H
+#define GAME_SERVER_CLIENTINFO_H
+
+#include <game/gamecore.h>
+#include <game/generated/protocol.h>
+
+#include "teeinfo.h"
+
+// the client info of a player with the strings already encoded, it is the
+// same for every viewer and only encoded again when something changed
+class CClientInfoCache
+{
+public:
+	enum
+	{
+		CLAN = 0,
+		READY, // ready mode shows whether the player is ready instead of the clan
+		NOT_READY,
+	};
+
+private:
+	CNetObj_ClientInfo m_ClientInfo;
+	int m_Clan;
+	bool m_Dirty;
+
+public:
+	CClientInfoCache() :
+		m_Clan(CLAN), m_Dirty(true) {}
+
+	// call when the name, clan, country or skin changed
+	void Invalidate() { m_Dirty = true; }
+
+	const CNetObj_ClientInfo *Get(int Clan, const char *pName, const char *pClan, int Country, const CTeeInfo &TeeInfo)
+	{
+		if(!m_Dirty && m_Clan == Clan)
+			return &m_ClientInfo;
+
+		StrToInts(&m_ClientInfo.m_Name0, 4, pName);
+		if(Clan == READY)
+			StrToInts(&m_ClientInfo.m_Clan0, 3, "READY");
+		else if(Clan == NOT_READY)
+			StrToInts(&m_ClientInfo.m_Clan0, 3, "");
+		else
+			StrToInts(&m_ClientInfo.m_Clan0, 3, pClan);
+		m_ClientInfo.m_Country = Country;
+
+		StrToInts(&m_ClientInfo.m_Skin0, 6, TeeInfo.m_SkinName);
+		m_ClientInfo.m_UseCustomColor = TeeInfo.m_UseCustomColor;
+		m_ClientInfo.m_ColorBody = TeeInfo.m_ColorBody;
+		m_ClientInfo.m_ColorFeet = TeeInfo.m_ColorFeet;
+
+		m_Clan = Clan;
+		m_Dirty = false;
+		return &m_ClientInfo;
+	}
+};
+
+#endif // GAME_SERVER_CLIENTINFO_H
@@ -92,7 +92,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	m_Core.Init(&GameWorld()->m_Core, GameServer()->Collision(), &GameServer()->Teams()->m_Core);
 	m_ActiveWeaponSlot = WEAPON_GAME;
 	m_Core.m_Pos = m_Pos;
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = &m_Core;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), &m_Core);
 
 	m_ReckoningTick = 0;
 	mem_zero(&m_SendCore, sizeof(m_SendCore));
@@ -118,7 +118,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 
 void CCharacter::Destroy()
 {
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 	m_Alive = false;
 	m_Solo = false;
 }
@@ -623,7 +623,7 @@ void CCharacter::Die(int Killer, int Weapon)
 	m_Solo = false;
 
 	GameWorld()->RemoveEntity(this);
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 	GameWorld()->CreateDeath(m_Pos, m_pPlayer->GetCID());
 
 	int DeathFlag = Controller()->OnInternalCharacterDeath(this, GameServer()->m_apPlayers[Killer], Weapon);
@@ -998,9 +998,9 @@ void CCharacter::Snap(int SnappingClient, int OtherMode)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_SUPER;
 	if(m_EndlessHook)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_ENDLESS_HOOK;
-	if(!m_Core.m_Collision || !GameServer()->Tuning()->m_PlayerCollision)
+	if(!m_Core.m_Collision || !GameWorld()->Tuning()->m_PlayerCollision)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_NO_COLLISION;
-	if(!m_Core.m_Hook || !GameServer()->Tuning()->m_PlayerHooking)
+	if(!m_Core.m_Hook || !GameWorld()->Tuning()->m_PlayerHooking)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_NO_HOOK;
 	if(m_SuperJump)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_ENDLESS_JUMP;
@@ -1544,9 +1544,9 @@ void CCharacter::HandleTiles(int Index)
 
 		if(Team != TEAM_FLOCK && Team != TEAM_SUPER)
 		{
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int i : Teams()->m_Core.Members(Team))
 			{
-				if(Teams()->m_Core.Team(i) == Team && i != m_Core.m_Id && GameServer()->m_apPlayers[i])
+				if(i != m_Core.m_Id && GameServer()->m_apPlayers[i])
 				{
 					CCharacter *pChar = GameServer()->m_apPlayers[i]->GetCharacter();
 
@@ -1570,9 +1570,9 @@ void CCharacter::HandleTiles(int Index)
 
 		if(Team != TEAM_FLOCK && Team != TEAM_SUPER)
 		{
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int i : Teams()->m_Core.Members(Team))
 			{
-				if(Teams()->m_Core.Team(i) == Team && i != m_Core.m_Id && GameServer()->m_apPlayers[i])
+				if(i != m_Core.m_Id && GameServer()->m_apPlayers[i])
 				{
 					CCharacter *pChar = GameServer()->m_apPlayers[i]->GetCharacter();
 
@@ -1710,9 +1710,9 @@ void CCharacter::HandleTuneLayer()
 	m_TuneZone = GameServer()->Collision()->IsTune(CurrentIndex);
 
 	if(m_TuneZone)
-		m_Core.m_pWorld->m_Tuning = GameServer()->TuningList()[m_TuneZone]; // throw tunings from specific zone into gamecore
+		m_Core.m_pWorld->m_pTuning = &GameServer()->TuningList()[m_TuneZone]; // throw tunings from specific zone into gamecore
 	else
-		m_Core.m_pWorld->m_Tuning = *GameServer()->Tuning();
+		m_Core.m_pWorld->m_pTuning = GameWorld()->Tuning();
 
 	if(m_TuneZone != m_TuneZoneOld) // don't send tunigs all the time
 	{
@@ -2146,7 +2146,7 @@ void CCharacter::SetDisable(bool Disable)
 	m_Disabled = Disable;
 	if(Disable)
 	{
-		GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+		GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 		GameWorld()->RemoveEntity(this);
 
 		if(m_Core.m_HookedPlayer != -1) // Keeping hook would allow cheats
@@ -2158,7 +2158,7 @@ void CCharacter::SetDisable(bool Disable)
 	else
 	{
 		m_Core.m_Vel = vec2(0, 0);
-		GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = &m_Core;
+		GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), &m_Core);
 		GameWorld()->InsertEntity(this);
 	}
 }
@@ -2182,9 +2182,9 @@ void CCharacter::DDRaceInit()
 
 	if(Teams()->TeamLocked(Team))
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : Teams()->m_Core.Members(Team))
 		{
-			if(Teams()->m_Core.Team(i) == Team && i != m_Core.m_Id && GameServer()->m_apPlayers[i])
+			if(i != m_Core.m_Id && GameServer()->m_apPlayers[i])
 			{
 				CCharacter *pChar = GameServer()->m_apPlayers[i]->GetCharacter();
 
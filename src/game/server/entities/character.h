@@ -277,7 +277,7 @@ public:
 	bool HasTelegunGrenade() { return m_Core.m_HasTelegunGrenade; };
 	bool HasTelegunLaser() { return m_Core.m_HasTelegunLaser; };
 
-	CTuningParams *CurrentTuning() { return m_TuneZone ? &GameServer()->TuningList()[m_TuneZone] : GameServer()->Tuning(); }
+	const CTuningParams *CurrentTuning() { return m_TuneZone ? &GameServer()->TuningList()[m_TuneZone] : GameWorld()->Tuning(); }
 	// hit data
 	struct
 	{
@@ -10,7 +10,8 @@
 #include "character.h"
 
 CDragger::CDragger(CGameWorld *pGameWorld, vec2 Pos, float Strength, bool NW, int Layer, int Number) :
-	CEntity(pGameWorld, CGameWorld::ENTTYPE_DDRACE)
+	CEntity(pGameWorld, CGameWorld::ENTTYPE_DDRACE),
+	m_LineOfSight(NW ? CLineOfSight::LOS_NOLASER_NW : CLineOfSight::LOS_NOLASER)
 {
 	m_Target = 0;
 	m_Layer = Layer;
@@ -50,12 +51,7 @@ void CDragger::Move()
 			m_SoloEnts[i] = 0;
 			continue;
 		}
-		int Res =
-			m_NW ?
-				GameServer()->Collision()->IntersectNoLaserNW(m_Pos, Temp->m_Pos, 0, 0) :
-				GameServer()->Collision()->IntersectNoLaser(m_Pos, Temp->m_Pos, 0, 0);
-
-		if(Res == 0)
+		if(!m_LineOfSight.Blocked(GameServer()->Collision(), m_Pos, Temp->m_Pos, g_Config.m_SvDraggerRange))
 		{
 			int Len = length(Temp->m_Pos - m_Pos);
 			if(MinLen == 0 || MinLen > Len)
@@ -101,14 +97,7 @@ void CDragger::Drag()
 		if(!Target)
 			continue;
 
-		int Res = 0;
-		if(!m_NW)
-			Res = GameServer()->Collision()->IntersectNoLaser(m_Pos,
-				Target->m_Pos, 0, 0);
-		else
-			Res = GameServer()->Collision()->IntersectNoLaserNW(m_Pos,
-				Target->m_Pos, 0, 0);
-		if(Res || length(m_Pos - Target->m_Pos) > g_Config.m_SvDraggerRange)
+		if(m_LineOfSight.Blocked(GameServer()->Collision(), m_Pos, Target->m_Pos, g_Config.m_SvDraggerRange) || length(m_Pos - Target->m_Pos) > g_Config.m_SvDraggerRange)
 		{
 			Target = 0;
 			if(i == -1)
@@ -2,6 +2,7 @@
 #ifndef GAME_SERVER_ENTITIES_DRAGGER_H
 #define GAME_SERVER_ENTITIES_DRAGGER_H
 
+#include <game/collision.h>
 #include <game/server/entity.h>
 class CCharacter;
 
@@ -14,6 +15,7 @@ class CDragger : public CEntity
 	void Drag();
 	CCharacter *m_Target;
 	bool m_NW;
+	CLineOfSight m_LineOfSight;
 
 	CCharacter *m_SoloEnts[MAX_CLIENTS];
 	int m_SoloIDs[MAX_CLIENTS];
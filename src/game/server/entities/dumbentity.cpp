@@ -215,8 +215,8 @@ void CDumbEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_GRENADE:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GrenadeCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GrenadeSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GrenadeCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GrenadeSpeed;
 		}
 		else
 		{
@@ -229,8 +229,8 @@ void CDumbEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_SHOTGUN:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_ShotgunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_ShotgunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_ShotgunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_ShotgunSpeed;
 		}
 		else
 		{
@@ -243,8 +243,8 @@ void CDumbEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_GUN:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GunSpeed;
 		}
 		else
 		{
@@ -14,7 +14,8 @@
 // CGun
 //////////////////////////////////////////////////
 CGun::CGun(CGameWorld *pGameWorld, vec2 Pos, bool Freeze, bool Explosive, int Layer, int Number) :
-	CEntity(pGameWorld, CGameWorld::ENTTYPE_DDRACE)
+	CEntity(pGameWorld, CGameWorld::ENTTYPE_DDRACE),
+	m_LineOfSight(CLineOfSight::LOS_LINE)
 {
 	m_Layer = Layer;
 	m_Number = Number;
@@ -45,8 +46,7 @@ void CGun::Fire()
 			continue;
 		if(m_Layer == LAYER_SWITCH && m_Number > 0 && !GameServer()->Collision()->m_pSwitchers[m_Number].m_Status[Target->Team()])
 			continue;
-		int res = GameServer()->Collision()->IntersectLine(m_Pos, Target->m_Pos, 0, 0);
-		if(!res)
+		if(!m_LineOfSight.Blocked(GameServer()->Collision(), m_Pos, Target->m_Pos, g_Config.m_SvPlasmaRange))
 		{
 			int TargetLen = length(Target->m_Pos - m_Pos);
 			if(Len == 0 || Len > TargetLen)
@@ -71,8 +71,7 @@ void CGun::Fire()
 		{
 			if(Id != i)
 			{
-				int res = GameServer()->Collision()->IntersectLine(m_Pos, Target->m_Pos, 0, 0);
-				if(!res)
+				if(!m_LineOfSight.Blocked(GameServer()->Collision(), m_Pos, Target->m_Pos, g_Config.m_SvPlasmaRange))
 				{
 					new CPlasma(GameWorld(), m_Pos, normalize(Target->m_Pos - m_Pos), m_Freeze, m_Explosive);
 					m_LastFire = Server()->Tick();
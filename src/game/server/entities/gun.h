@@ -3,6 +3,7 @@
 #ifndef GAME_SERVER_ENTITIES_GUN_H
 #define GAME_SERVER_ENTITIES_GUN_H
 
+#include <game/collision.h>
 #include <game/gamecore.h>
 #include <game/server/entity.h>
 
@@ -19,6 +20,8 @@ class CGun : public CEntity
 	void Fire();
 	int m_LastFire;
 
+	CLineOfSight m_LineOfSight;
+
 	int m_ID;
 
 public:
@@ -20,6 +20,7 @@ CLight::CLight(CGameWorld *pGameWorld, vec2 Pos, float Rotation, int Length,
 	m_Rotation = Rotation;
 	m_Length = Length;
 	m_EvalTick = Server()->Tick();
+	m_StepCollisionVersion = -1;
 	m_ID = Server()->SnapNewID();
 	GameWorld()->InsertEntity(this);
 	Step();
@@ -72,6 +73,11 @@ void CLight::Step()
 	Move();
 	vec2 dir(sin(m_Rotation), cos(m_Rotation));
 	vec2 to2 = m_Pos + normalize(dir) * m_CurveLength;
+	if(m_Pos == m_StepFrom && to2 == m_StepTo && GameServer()->Collision()->Version() == m_StepCollisionVersion)
+		return;
+	m_StepFrom = m_Pos;
+	m_StepTo = to2;
+	m_StepCollisionVersion = GameServer()->Collision()->Version();
 	GameServer()->Collision()->IntersectNoLaser(m_Pos, to2, &m_To, 0);
 }
 
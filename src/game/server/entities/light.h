@@ -10,6 +10,11 @@ class CLight : public CEntity
 	vec2 m_To;
 	vec2 m_Core;
 
+	// the ray of the last step, its end only has to be traced again when it changes
+	vec2 m_StepFrom;
+	vec2 m_StepTo;
+	int m_StepCollisionVersion;
+
 	int m_EvalTick;
 
 	int m_Tick;
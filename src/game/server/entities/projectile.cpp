@@ -76,8 +76,8 @@ void CProjectile::GetProjectileProperties(float *pCurvature, float *pSpeed)
 	case WEAPON_GRENADE:
 		if(!m_TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GrenadeCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GrenadeSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GrenadeCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GrenadeSpeed;
 		}
 		else
 		{
@@ -90,8 +90,8 @@ void CProjectile::GetProjectileProperties(float *pCurvature, float *pSpeed)
 	case WEAPON_SHOTGUN:
 		if(!m_TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_ShotgunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_ShotgunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_ShotgunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_ShotgunSpeed;
 		}
 		else
 		{
@@ -104,8 +104,8 @@ void CProjectile::GetProjectileProperties(float *pCurvature, float *pSpeed)
 	case WEAPON_GUN:
 		if(!m_TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GunSpeed;
 		}
 		else
 		{
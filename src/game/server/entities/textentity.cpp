@@ -267,6 +267,7 @@ static struct SFontDot
 CTextEntity::CTextEntity(CGameWorld *pGameWorld, vec2 Pos, int Type, int GapSize, int Align, char *pText, float Time) :
 	CEntity(pGameWorld, CGameWorld::ENTTYPE_CUSTOM, Pos)
 {
+	m_SnapProtocolOnly = true;
 	m_Type = Type;
 	m_PrevPrevPos = m_PrevPos = Pos;
 	m_PrevVelocity = {0.0f, 0.0f};
@@ -305,6 +306,33 @@ CTextEntity::CTextEntity(CGameWorld *pGameWorld, vec2 Pos, int Type, int GapSize
 		m_Offset = {-m_BoxWidth / 2.0f, -m_BoxHeight / 2.0f};
 	else if(Align == ALIGN_RIGHT)
 		m_Offset = {-m_BoxWidth, -m_BoxHeight / 2.0f};
+	else
+		m_Offset = {0.0f, 0.0f};
+
+	// the glyph layout never changes, only where it is drawn
+	m_pDotOffsets = nullptr;
+	m_pItems = nullptr;
+	if(m_NumIDs > 0)
+	{
+		m_pDotOffsets = (vec2 *)malloc(m_NumIDs * sizeof(vec2));
+		float XOffset = 0;
+		int DotIndex = 0;
+		for(int c = 0; c < m_TextLen; c++)
+		{
+			SFontDot Dot = s_FontDotData[(unsigned char)m_pText[c]];
+			for(int d = 0; d < Dot.m_Dots; d++)
+			{
+				int X = (int)Dot.m_Data[d] % 7;
+				int Y = (int)Dot.m_Data[d] / 7;
+				m_pDotOffsets[DotIndex++] = m_Offset + vec2(XOffset + X * m_GapSize, Y * m_GapSize);
+			}
+			XOffset += (Dot.m_Width + 1) * m_GapSize;
+		}
+		m_pItems = (int *)malloc(m_NumIDs * ItemSize());
+	}
+	m_ItemsValid = false;
+	m_ItemsPos = Pos;
+	m_ItemsTick = Server()->Tick();
 
 	pGameWorld->InsertEntity(this);
 }
@@ -317,6 +345,10 @@ CTextEntity::~CTextEntity()
 		free(m_pIDs);
 	if(m_pText)
 		free(m_pText);
+	if(m_pDotOffsets)
+		free(m_pDotOffsets);
+	if(m_pItems)
+		free(m_pItems);
 }
 
 void CTextEntity::Reset()
@@ -368,40 +400,61 @@ void CTextEntity::TeleportTo(vec2 Pos)
 	m_PrevPrevPos = m_PrevPos = m_Pos = Pos;
 }
 
+int CTextEntity::ItemSize() const
+{
+	if(m_Type == TYPE_LASER)
+		return sizeof(CNetObj_Laser);
+	else if(m_Type >= TYPE_GUN && m_Type <= TYPE_GRENADE)
+		return sizeof(CNetObj_Projectile);
+	return sizeof(CNetObj_Pickup);
+}
+
+bool CTextEntity::UpdateItems(vec2 Pos)
+{
+	if(m_ItemsValid && m_ItemsPos == Pos)
+		return false;
+
+	m_ItemsValid = true;
+	m_ItemsPos = Pos;
+	m_ItemsTick = Server()->Tick();
+	return true;
+}
+
+void CTextEntity::SnapItems(int Type, int Size)
+{
+	int Stride = ItemSize();
+	const char *pItem = (const char *)m_pItems;
+	for(int i = 0; i < m_NumIDs; i++, pItem += Stride)
+	{
+		void *pObj = Server()->SnapNewItem(Type, m_pIDs[i], Size);
+		if(!pObj)
+			return;
+		mem_copy(pObj, pItem, Size);
+	}
+}
+
 void CTextEntity::SnapLaser()
 {
-	float XOffset = 0;
-	int DotIndex = 0;
-	for(int c = 0; c < m_TextLen; c++)
+	if(UpdateItems(m_Pos))
 	{
-		SFontDot Dot = s_FontDotData[(unsigned char)m_pText[c]];
-		for(int d = 0; d < Dot.m_Dots; d++)
+		// keeping the start tick while the text stays put lets the snapshot
+		// delta skip the dots entirely, the client renders both the same
+		CNetObj_Laser *pObjs = (CNetObj_Laser *)m_pItems;
+		for(int i = 0; i < m_NumIDs; i++)
 		{
-			int X = (int)Dot.m_Data[d] % 7;
-			int Y = (int)Dot.m_Data[d] / 7;
-
-			vec2 Offset = vec2(XOffset + X * m_GapSize, Y * m_GapSize);
-
-			CNetObj_Laser *pObj = static_cast<CNetObj_Laser *>(Server()->SnapNewItem(NETOBJTYPE_LASER, m_pIDs[DotIndex], sizeof(CNetObj_Laser)));
-			if(!pObj)
-				return;
-
-			vec2 Position = m_Pos + m_Offset + Offset;
-			pObj->m_X = (int)Position.x;
-			pObj->m_Y = (int)Position.y;
-			pObj->m_FromX = (int)Position.x;
-			pObj->m_FromY = (int)Position.y;
-			pObj->m_StartTick = Server()->Tick();
-			DotIndex++;
+			vec2 Position = m_Pos + m_pDotOffsets[i];
+			pObjs[i].m_X = (int)Position.x;
+			pObjs[i].m_Y = (int)Position.y;
+			pObjs[i].m_FromX = (int)Position.x;
+			pObjs[i].m_FromY = (int)Position.y;
+			pObjs[i].m_StartTick = m_ItemsTick;
 		}
-		XOffset += (Dot.m_Width + 1) * m_GapSize;
 	}
+	SnapItems(NETOBJTYPE_LASER, sizeof(CNetObj_Laser));
 }
 
 void CTextEntity::SnapProjectile()
 {
-	float XOffset = 0;
-	int DotIndex = 0;
 	float Delta = 2.0f / (float)Server()->TickSpeed();
 	int VelX = 0;
 	int VelY = 0;
@@ -426,70 +479,53 @@ void CTextEntity::SnapProjectile()
 			VelY = (int)(Direction.y * (m_PrevVelocity.y / ClientVel.y) * 100.0f);
 	}
 
-	for(int c = 0; c < m_TextLen; c++)
+	CNetObj_Projectile *pProjs = (CNetObj_Projectile *)m_pItems;
+	if(UpdateItems(m_PrevPrevPos))
 	{
-		SFontDot Dot = s_FontDotData[(unsigned char)m_pText[c]];
-		for(int d = 0; d < Dot.m_Dots; d++)
+		for(int i = 0; i < m_NumIDs; i++)
 		{
-			int X = (int)Dot.m_Data[d] % 7;
-			int Y = (int)Dot.m_Data[d] / 7;
-
-			vec2 Position = m_PrevPrevPos + m_Offset + vec2(XOffset + X * m_GapSize, Y * m_GapSize);
-
-			CNetObj_Projectile *pProj = static_cast<CNetObj_Projectile *>(Server()->SnapNewItem(NETOBJTYPE_PROJECTILE, m_pIDs[DotIndex], sizeof(CNetObj_Projectile)));
-			if(!pProj)
-				return;
-
-			pProj->m_StartTick = Server()->Tick() - 2;
-			pProj->m_Type = m_Type - (TYPE_GUN - WEAPON_GUN);
-
-			pProj->m_X = round_to_int(Position.x);
-			pProj->m_Y = round_to_int(Position.y);
-			pProj->m_VelX = VelX;
-			pProj->m_VelY = VelY;
-
-			DotIndex++;
+			vec2 Position = m_PrevPrevPos + m_pDotOffsets[i];
+			pProjs[i].m_X = round_to_int(Position.x);
+			pProjs[i].m_Y = round_to_int(Position.y);
+			pProjs[i].m_Type = m_Type - (TYPE_GUN - WEAPON_GUN);
 		}
-		XOffset += (Dot.m_Width + 1) * m_GapSize;
 	}
+
+	// the client moves projectiles along their curve from the start tick,
+	// so that has to follow the server tick even if the text stands still
+	for(int i = 0; i < m_NumIDs; i++)
+	{
+		pProjs[i].m_StartTick = Server()->Tick() - 2;
+		pProjs[i].m_VelX = VelX;
+		pProjs[i].m_VelY = VelY;
+	}
+	SnapItems(NETOBJTYPE_PROJECTILE, sizeof(CNetObj_Projectile));
 }
 
 void CTextEntity::SnapPickup(int SnappingClient)
 {
-	int PickupType = POWERUP_HEALTH;
-	if(m_Type == TYPE_HEART)
-		PickupType = POWERUP_HEALTH;
-	else if(m_Type == TYPE_ARMOR)
-		PickupType = POWERUP_ARMOR;
-
-	float XOffset = 0;
-	int DotIndex = 0;
-	int Size = Server()->IsSixup(SnappingClient) ? 3 * 4 : sizeof(CNetObj_Pickup);
-
-	for(int c = 0; c < m_TextLen; c++)
+	if(UpdateItems(m_Pos))
 	{
-		SFontDot Dot = s_FontDotData[(unsigned char)m_pText[c]];
-		for(int d = 0; d < Dot.m_Dots; d++)
-		{
-			int X = (int)Dot.m_Data[d] % 7;
-			int Y = (int)Dot.m_Data[d] / 7;
-
-			vec2 Position = m_Pos + m_Offset + vec2(XOffset + X * m_GapSize, Y * m_GapSize);
+		int PickupType = POWERUP_HEALTH;
+		if(m_Type == TYPE_HEART)
+			PickupType = POWERUP_HEALTH;
+		else if(m_Type == TYPE_ARMOR)
+			PickupType = POWERUP_ARMOR;
 
-			CNetObj_Pickup *pP = static_cast<CNetObj_Pickup *>(Server()->SnapNewItem(NETOBJTYPE_PICKUP, m_pIDs[DotIndex], Size));
-			if(!pP)
-				return;
-
-			pP->m_X = (int)Position.x;
-			pP->m_Y = (int)Position.y;
-			pP->m_Type = PickupType;
-
-			if(!Server()->IsSixup(SnappingClient))
-				pP->m_Subtype = -1;
-			DotIndex++;
+		CNetObj_Pickup *pPickups = (CNetObj_Pickup *)m_pItems;
+		for(int i = 0; i < m_NumIDs; i++)
+		{
+			vec2 Position = m_Pos + m_pDotOffsets[i];
+			pPickups[i].m_X = (int)Position.x;
+			pPickups[i].m_Y = (int)Position.y;
+			pPickups[i].m_Type = PickupType;
+			pPickups[i].m_Subtype = -1;
 		}
-		XOffset += (Dot.m_Width + 1) * m_GapSize;
 	}
+
+	// 0.7 pickups are the 0.6 ones without the subtype
+	int Size = SnappingClient >= 0 && Server()->IsSixup(SnappingClient) ? 3 * 4 : sizeof(CNetObj_Pickup);
+	SnapItems(NETOBJTYPE_PICKUP, Size);
 }
 
 void CTextEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int TuneZone)
@@ -500,8 +536,8 @@ void CTextEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_GRENADE:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GrenadeCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GrenadeSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GrenadeCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GrenadeSpeed;
 		}
 		else
 		{
@@ -514,8 +550,8 @@ void CTextEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_SHOTGUN:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_ShotgunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_ShotgunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_ShotgunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_ShotgunSpeed;
 		}
 		else
 		{
@@ -528,8 +564,8 @@ void CTextEntity::GetProjectileProperties(float *pCurvature, float *pSpeed, int
 	case WEAPON_GUN:
 		if(!TuneZone)
 		{
-			*pCurvature = GameServer()->Tuning()->m_GunCurvature;
-			*pSpeed = GameServer()->Tuning()->m_GunSpeed;
+			*pCurvature = GameWorld()->Tuning()->m_GunCurvature;
+			*pSpeed = GameWorld()->Tuning()->m_GunSpeed;
 		}
 		else
 		{
@@ -21,6 +21,17 @@ private:
 	vec2 m_Offset;
 	char *m_pText;
 
+	// dot positions relative to m_Pos
+	vec2 *m_pDotOffsets;
+	// ready to copy netobjects, rebuilt only when the text moved
+	int *m_pItems;
+	bool m_ItemsValid;
+	vec2 m_ItemsPos;
+	int m_ItemsTick;
+
+	int ItemSize() const;
+	bool UpdateItems(vec2 Pos);
+	void SnapItems(int Type, int Size);
 	void GetProjectileProperties(float *pCurvature, float *pSpeed, int TuneZone = 0);
 
 public:
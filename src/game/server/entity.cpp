@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
 #include "entity.h"
+#include "entities/character.h"
 #include "gamecontext.h"
 #include "player.h"
 
@@ -19,6 +20,8 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 
 	m_MarkedForDestroy = false;
 	m_OnSnap = nullptr;
+	m_SnapProtocolOnly = false;
+	m_pSnapCache = nullptr;
 
 	m_pPrevTypeEntity = 0;
 	m_pNextTypeEntity = 0;
@@ -27,6 +30,7 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 CEntity::~CEntity()
 {
 	GameWorld()->RemoveEntity(this);
+	delete m_pSnapCache;
 }
 
 bool CEntity::NetworkClipped(int SnappingClient)
@@ -188,15 +192,78 @@ bool NetworkRectClipped(CGameContext *pGameServer, int SnappingClient, vec2 TL,
 	return false;
 }
 
+int CEntity::SnapPriority(int SnappingClient, int OtherMode)
+{
+	int Class = SNAPPRIO_OBJECT;
+	if(m_ObjType == CGameWorld::ENTTYPE_CHARACTER || m_ObjType == CGameWorld::ENTTYPE_FLAG)
+		Class = SNAPPRIO_CHARACTER;
+	else if(m_ObjType == CGameWorld::ENTTYPE_CUSTOM)
+		Class = SNAPPRIO_DECORATION;
+
+	int Distance = 0;
+	if(SnappingClient >= 0)
+	{
+		CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
+		if(m_ObjType == CGameWorld::ENTTYPE_CHARACTER)
+		{
+			int ClientID = static_cast<CCharacter *>(this)->GetPlayer()->GetCID();
+			if(ClientID == SnappingClient || (pPlayer->IsSpectating() && ClientID == pPlayer->GetSpectatorID()))
+				Class = SNAPPRIO_OWN_CHARACTER;
+		}
+		Distance = minimum((int)(distance(m_Pos, pPlayer->m_ViewPos) / 32.0f), SNAPPRIO_CLASS_RANGE - 1);
+	}
+
+	// everything of the own room ranks above the other rooms
+	int Priority = Class * SNAPPRIO_CLASS_RANGE - Distance;
+	if(OtherMode)
+		Priority -= NUM_SNAPPRIOS * SNAPPRIO_CLASS_RANGE;
+	return Priority;
+}
+
 void CEntity::InternalSnap(int SnappingClient, int OtherMode)
 {
 	bool IsClipped = NetworkClipped(SnappingClient);
-
-	if(!OtherMode && m_OnSnap && m_OnSnap(Controller(), this, SnappingClient, IsClipped))
+	bool CustomSnap = !OtherMode && m_OnSnap;
+	if(IsClipped && !CustomSnap)
 		return;
 
-	if(IsClipped)
+	int OldPriority = Server()->SnapSetPriority(SnapPriority(SnappingClient, OtherMode));
+
+	if(!(CustomSnap && m_OnSnap(Controller(), this, SnappingClient, IsClipped)) && !IsClipped)
+	{
+		if(m_SnapProtocolOnly && !OtherMode)
+			SnapCached(SnappingClient);
+		else
+			Snap(SnappingClient, OtherMode);
+	}
+
+	Server()->SnapSetPriority(OldPriority);
+}
+
+void CEntity::SnapCached(int SnappingClient)
+{
+	if(!m_pSnapCache)
+	{
+		m_pSnapCache = new CSnapCache();
+		m_pSnapCache->m_aTick[0] = m_pSnapCache->m_aTick[1] = -1;
+	}
+
+	// the demo snapshot (-1) is built like a vanilla one
+	const int Protocol = SnappingClient >= 0 && Server()->IsSixup(SnappingClient);
+	if(m_pSnapCache->m_aTick[Protocol] == Server()->Tick())
+	{
+		Server()->SnapAddItems(m_pSnapCache->m_aItems[Protocol]);
 		return;
+	}
 
-	Snap(SnappingClient, OtherMode);
+	int FromItem = Server()->SnapNumItems();
+	int NumDropped = Server()->SnapNumDropped();
+	Snap(SnappingClient, 0);
+
+	// a snapshot over its budget may have left out some of the items, the
+	// other viewers must not get the incomplete set
+	if(Server()->SnapNumDropped() != NumDropped)
+		return;
+	Server()->SnapCopyItems(FromItem, &m_pSnapCache->m_aItems[Protocol]);
+	m_pSnapCache->m_aTick[Protocol] = Server()->Tick();
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define GAME_SERVER_ENTITY_H
 
 #include <base/vmath.h>
+#include <engine/shared/snapshot.h>
 
 #include "alloc.h"
 #include "gamecontext.h"
@@ -43,6 +44,16 @@ private:
 	*/
 	float m_ProximityRadius;
 
+	// items of the last snapshot round, for vanilla and sixup clients
+	struct CSnapCache
+	{
+		int m_aTick[2];
+		CSnapshotItemCache m_aItems[2];
+	};
+	CSnapCache *m_pSnapCache;
+
+	void SnapCached(int SnappingClient);
+
 protected:
 	/* State */
 	bool m_MarkedForDestroy;
@@ -50,6 +61,14 @@ protected:
 	/* Callback */
 	FCustomSnapCallback m_OnSnap;
 
+	/*
+		Variable: m_SnapProtocolOnly
+			Set by entities whose Snap() only depends on the protocol of
+			the snapping client. Their items are then built once per
+			snapshot and protocol and copied into the other snapshots.
+	*/
+	bool m_SnapProtocolOnly;
+
 public: // TODO: Maybe make protected
 	/*
 		Variable: m_Pos
@@ -58,6 +77,19 @@ public: // TODO: Maybe make protected
 	vec2 m_Pos;
 
 public:
+	// snapshot priority classes, nearer entities of a class rank higher
+	enum
+	{
+		SNAPPRIO_DECORATION = 1,
+		SNAPPRIO_OBJECT,
+		SNAPPRIO_CHARACTER,
+		SNAPPRIO_OWN_CHARACTER,
+		NUM_SNAPPRIOS,
+
+		// distance steps of one tile within a class
+		SNAPPRIO_CLASS_RANGE = 1024,
+	};
+
 	/* Constructor */
 	CEntity(CGameWorld *pGameWorld, int Objtype, vec2 Pos = vec2(0, 0), int ProximityRadius = 0);
 
@@ -167,6 +199,23 @@ public:
 	bool NetworkRectClipped(int SnappingClient, vec2 TL, vec2 BR, vec2 MinView = {0.0f, 0.0f});
 	bool GameLayerClipped(vec2 CheckPos);
 
+	/*
+		Function: SnapPriority
+			Ranks the items of the entity for the snapshot budget, the
+			least important items are dropped first once a snapshot
+			gets too large.
+
+		Arguments:
+			SnappingClient - ID of the client which snapshot is
+				being generated.
+			OtherMode - Set if the entity is in another room than
+				the snapping client.
+
+		Returns:
+			The priority, higher is more important.
+	*/
+	virtual int SnapPriority(int SnappingClient, int OtherMode);
+
 	void InternalSnap(int SnappingClient, int OtherMode);
 
 	// DDRace
@@ -42,83 +42,139 @@ void CEventHandler::Clear()
 {
 	m_NumEvents = 0;
 	m_CurrentOffset = 0;
+	m_ByPosition.Clear();
+	m_NumGlobal = 0;
+	m_NumPrepared = 0;
 }
 
-void CEventHandler::Snap(int SnappingClient)
+static void DamageIndToSixup(const CNetEvent_DamageInd *pEvent, protocol7::CNetEvent_Damage *pEvent7)
+{
+	pEvent7->m_X = pEvent->m_X;
+	pEvent7->m_Y = pEvent->m_Y;
+	pEvent7->m_ClientID = 0;
+	pEvent7->m_Angle = 0;
+
+	// This will need some work, perhaps an event wrapper for damageind,
+	// a scan of the event array to merge multiple damageinds
+	// or a separate array of "damage ind" events that's added in while snapping
+	pEvent7->m_HealthAmount = 1;
+	pEvent7->m_ArmorAmount = 0;
+	pEvent7->m_Self = 0;
+}
+
+void CEventHandler::Prepare()
 {
+	m_ByPosition.Clear();
+	m_NumGlobal = 0;
 	for(int i = 0; i < m_NumEvents; i++)
 	{
-		if(SnappingClient == -1 || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		if(m_aTypes[i] == NETEVENTTYPE_SOUNDGLOBAL)
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			int Type = m_aTypes[i];
-			int Size = m_aSizes[i];
-			const char *Data = &m_aData[m_aOffsets[i]];
-			if(OverrideEvent(SnappingClient, &Type, &Size, &Data))
-				return;
-
-			// larger clip for events (especially for sounds), to provides full spatial sounds
-			if(!NetworkPointClipped(GameServer(), SnappingClient, vec2(ev->m_X, ev->m_Y), vec2(1800.0f, 1800.0f)))
-			{
-				void *d = GameServer()->Server()->SnapNewItem(Type, i, Size);
-				if(d)
-					mem_copy(d, Data, Size);
-			}
+			m_aGlobal[m_NumGlobal++] = i;
+			continue;
 		}
+
+		if(m_aTypes[i] == NETEVENTTYPE_DAMAGEIND)
+			DamageIndToSixup((const CNetEvent_DamageInd *)&m_aData[m_aOffsets[i]], &m_aDamage7[i]);
+		m_ByPosition.Add(i, ((const CNetEvent_Common *)&m_aData[m_aOffsets[i]])->m_X);
 	}
+	m_ByPosition.Sort();
+	m_NumPrepared = m_NumEvents;
 }
 
-bool CEventHandler::OverrideEvent(int SnappingClient, int *Type, int *Size, const char **pData)
+void CEventHandler::Snap(int SnappingClient)
 {
-	static char s_aEventStore[128];
-	int Sixup = GameServer()->Server()->IsSixup(SnappingClient);
-
-	if(*Type == NETEVENTTYPE_DAMAGEIND && Sixup)
-	{
-		const CNetEvent_DamageInd *pEvent = (const CNetEvent_DamageInd *)(*pData);
-		protocol7::CNetEvent_Damage *pEvent7 = (protocol7::CNetEvent_Damage *)s_aEventStore;
-		*Type = -protocol7::NETEVENTTYPE_DAMAGE;
-		*Size = sizeof(*pEvent7);
+	bool Sixup = SnappingClient != -1 && GameServer()->Server()->IsSixup(SnappingClient);
 
-		pEvent7->m_X = pEvent->m_X;
-		pEvent7->m_Y = pEvent->m_Y;
+	for(int i = 0; i < m_NumGlobal; i++)
+		SnapSoundGlobal(SnappingClient, Sixup, m_aGlobal[i]);
 
-		// This will need some work, perhaps an event wrapper for damageind,
-		// a scan of the event array to merge multiple damageinds
-		// or a separate array of "damage ind" events that's added in while snapping
-		pEvent7->m_HealthAmount = 1;
-
-		*pData = s_aEventStore;
-		return false;
+	if(SnappingClient == -1)
+	{
+		for(int i = 0; i < m_ByPosition.Num(); i++)
+			SnapEvent(SnappingClient, Sixup, m_ByPosition.Event(i));
 	}
-	else if(*Type == NETEVENTTYPE_SOUNDGLOBAL) // Fake sound global event
+	else
 	{
-		const CNetEvent_SoundGlobal *pEvent = (const CNetEvent_SoundGlobal *)(*pData);
-		int SoundID = pEvent->m_SoundID;
+		// only visit the events within the widest range that SnapEvent accepts
+		CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
+		float Range = maximum(pPlayer->IsSpectating() ? pPlayer->m_ShowDistance.x : (float)SHOW_DISTANCE_DEFAULT_X, 1800.0f);
+		int MinX = (int)(pPlayer->m_ViewPos.x - Range) - 1;
+		int MaxX = (int)(pPlayer->m_ViewPos.x + Range) + 1;
+
+		int First;
+		int End = m_ByPosition.Find(MinX, MaxX, &First);
+		for(int i = First; i < End; i++)
+			SnapEvent(SnappingClient, Sixup, m_ByPosition.Event(i));
+	}
 
-		if(Sixup)
-		{
-			CPlayer *pPlayer = Controller()->GetPlayerIfInRoom(SnappingClient);
-			if(!pPlayer)
-				return true;
-
-			protocol7::CNetEvent_SoundWorld *pEvent7 = (protocol7::CNetEvent_SoundWorld *)s_aEventStore;
-			*Type = -protocol7::NETEVENTTYPE_SOUNDWORLD;
-			*Size = sizeof(*pEvent7);
-
-			pEvent7->m_X = round_to_int(pPlayer->m_ViewPos.x);
-			pEvent7->m_Y = round_to_int(pPlayer->m_ViewPos.y);
-			pEvent7->m_SoundID = SoundID;
-			*pData = s_aEventStore;
-			return false;
-		}
+	// events created after Prepare()
+	for(int i = m_NumPrepared; i < m_NumEvents; i++)
+	{
+		if(m_aTypes[i] == NETEVENTTYPE_SOUNDGLOBAL)
+			SnapSoundGlobal(SnappingClient, Sixup, i);
+		else
+			SnapEvent(SnappingClient, Sixup, i);
+	}
+}
+
+void CEventHandler::SnapEvent(int SnappingClient, bool Sixup, int Event)
+{
+	if(SnappingClient != -1 && !CmaskIsSet(m_aClientMasks[Event], SnappingClient))
+		return;
+
+	// larger clip for events (especially for sounds), to provides full spatial sounds
+	const CNetEvent_Common *pEvent = (const CNetEvent_Common *)&m_aData[m_aOffsets[Event]];
+	if(NetworkPointClipped(GameServer(), SnappingClient, vec2(pEvent->m_X, pEvent->m_Y), vec2(1800.0f, 1800.0f)))
+		return;
+
+	int Type = m_aTypes[Event];
+	int Size = m_aSizes[Event];
+	const void *pData = pEvent;
+	protocol7::CNetEvent_Damage Damage7;
+	if(Sixup && Type == NETEVENTTYPE_DAMAGEIND)
+	{
+		if(Event < m_NumPrepared)
+			pData = &m_aDamage7[Event];
 		else
 		{
-			CNetMsg_Sv_SoundGlobal Msg;
-			Msg.m_SoundID = SoundID;
-			GameServer()->Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, SnappingClient);
-			return true;
+			DamageIndToSixup((const CNetEvent_DamageInd *)pEvent, &Damage7);
+			pData = &Damage7;
 		}
+		Type = -protocol7::NETEVENTTYPE_DAMAGE;
+		Size = sizeof(Damage7);
+	}
+
+	void *d = GameServer()->Server()->SnapNewItem(Type, Event, Size);
+	if(d)
+		mem_copy(d, pData, Size);
+}
+
+// fake sound global event
+void CEventHandler::SnapSoundGlobal(int SnappingClient, bool Sixup, int Event)
+{
+	if(SnappingClient == -1 || !CmaskIsSet(m_aClientMasks[Event], SnappingClient))
+		return;
+
+	const CNetEvent_SoundGlobal *pEvent = (const CNetEvent_SoundGlobal *)&m_aData[m_aOffsets[Event]];
+	if(Sixup)
+	{
+		CPlayer *pPlayer = Controller()->GetPlayerIfInRoom(SnappingClient);
+		if(!pPlayer)
+			return;
+
+		protocol7::CNetEvent_SoundWorld *pEvent7 = static_cast<protocol7::CNetEvent_SoundWorld *>(GameServer()->Server()->SnapNewItem(-protocol7::NETEVENTTYPE_SOUNDWORLD, Event, sizeof(protocol7::CNetEvent_SoundWorld)));
+		if(!pEvent7)
+			return;
+
+		pEvent7->m_X = round_to_int(pPlayer->m_ViewPos.x);
+		pEvent7->m_Y = round_to_int(pPlayer->m_ViewPos.y);
+		pEvent7->m_SoundID = pEvent->m_SoundID;
+	}
+	else
+	{
+		CNetMsg_Sv_SoundGlobal Msg;
+		Msg.m_SoundID = pEvent->m_SoundID;
+		GameServer()->Server()->SendPackMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_NORECORD, SnappingClient);
 	}
-	return false;
 }
@@ -5,10 +5,57 @@
 
 #include <base/system.h>
 #include <base/vmath.h>
+#include <game/generated/protocol7.h>
 
-class CEventHandler
+#include <algorithm>
+
+// events sorted by x, so a viewer only visits the events in its range
+class CEventPositionIndex
 {
+public:
 	static const int MAX_EVENTS = 128;
+
+private:
+	struct CEntry
+	{
+		int m_X;
+		int m_Event;
+		bool operator<(const CEntry &Other) const { return m_X < Other.m_X; }
+	};
+	CEntry m_aEntries[MAX_EVENTS];
+	int m_Num;
+
+public:
+	CEventPositionIndex() :
+		m_Num(0) {}
+
+	void Clear() { m_Num = 0; }
+	void Add(int Event, int X)
+	{
+		m_aEntries[m_Num].m_X = X;
+		m_aEntries[m_Num].m_Event = Event;
+		m_Num++;
+	}
+	// call once all events are added, equal positions keep their order
+	void Sort() { std::stable_sort(m_aEntries, m_aEntries + m_Num); }
+
+	int Num() const { return m_Num; }
+	int Event(int Index) const { return m_aEntries[Index].m_Event; }
+
+	// the events from MinX to MaxX are the ones at [*pFirst, return value)
+	int Find(int MinX, int MaxX, int *pFirst) const
+	{
+		CEntry Min, Max;
+		Min.m_X = MinX;
+		Max.m_X = MaxX;
+		*pFirst = std::lower_bound(m_aEntries, m_aEntries + m_Num, Min) - m_aEntries;
+		return std::upper_bound(m_aEntries + *pFirst, m_aEntries + m_Num, Max) - m_aEntries;
+	}
+};
+
+class CEventHandler
+{
+	static const int MAX_EVENTS = CEventPositionIndex::MAX_EVENTS;
 	static const int MAX_DATASIZE = 128 * 64;
 
 	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
@@ -17,12 +64,22 @@ class CEventHandler
 	int64 m_aClientMasks[MAX_EVENTS];
 	char m_aData[MAX_DATASIZE];
 
+	// filled by Prepare() once the events of the tick are complete
+	protocol7::CNetEvent_Damage m_aDamage7[MAX_EVENTS];
+	CEventPositionIndex m_ByPosition;
+	int m_aGlobal[MAX_EVENTS];
+	int m_NumGlobal;
+	int m_NumPrepared;
+
 	class CGameContext *m_pGameServer;
 	class IGameController *m_pController;
 
 	int m_CurrentOffset;
 	int m_NumEvents;
 
+	void SnapEvent(int SnappingClient, bool Sixup, int Event);
+	void SnapSoundGlobal(int SnappingClient, bool Sixup, int Event);
+
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	IGameController *Controller() const { return m_pController; }
@@ -31,9 +88,9 @@ public:
 	CEventHandler();
 	void *Create(int Type, int Size, int64 Mask = -1LL);
 	void Clear();
+	// indexes the events by position and converts them for sixup, call before snapping
+	void Prepare();
 	void Snap(int SnappingClient);
-
-	bool OverrideEvent(int SnappingClient, int *Type, int *Size, const char **Data);
 };
 
 #endif
@@ -9,11 +9,13 @@
 #include <engine/console.h>
 #include <engine/engine.h>
 #include <engine/map.h>
+#include <engine/server/databases/pvp_stats.h>
 #include <engine/server/server.h>
 #include <engine/shared/config.h>
 #include <engine/shared/datafile.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/profiler.h>
 #include <engine/storage.h>
 #include <game/collision.h>
 #include <game/gamecore.h>
@@ -43,6 +45,7 @@ void CGameContext::Construct(int Resetting)
 {
 	m_Resetting = 0;
 	m_pServer = 0;
+	m_pPvpStats = nullptr;
 
 	for(auto &pPlayer : m_apPlayers)
 		pPlayer = 0;
@@ -62,6 +65,7 @@ void CGameContext::Construct(int Resetting)
 	}
 	m_ChatResponseTargetID = -1;
 	m_aDeleteTempfile[0] = 0;
+	m_TuningVersion = 0;
 }
 
 CGameContext::CGameContext(int Resetting)
@@ -80,6 +84,7 @@ CGameContext::~CGameContext()
 		delete pPlayer;
 	if(!m_Resetting)
 		delete m_pVoteOptionHeap;
+	delete m_pPvpStats;
 }
 
 void CGameContext::Clear()
@@ -89,6 +94,7 @@ void CGameContext::Clear()
 	CVoteOptionServer *pVoteOptionLast = m_pVoteOptionLast;
 	int NumVoteOptions = m_NumVoteOptions;
 	CTuningParams Tuning = m_Tuning;
+	int TuningVersion = m_TuningVersion;
 
 	m_Resetting = true;
 	this->~CGameContext();
@@ -100,6 +106,7 @@ void CGameContext::Clear()
 	m_pVoteOptionLast = pVoteOptionLast;
 	m_NumVoteOptions = NumVoteOptions;
 	m_Tuning = Tuning;
+	m_TuningVersion = TuningVersion + 1;
 }
 
 class CCharacter *CGameContext::GetPlayerChar(int ClientID)
@@ -625,11 +632,15 @@ void CGameContext::SendTuningParams(int ClientID, int Zone)
 	}
 
 	CMsgPacker Msg(NETMSGTYPE_SV_TUNEPARAMS);
-	int *pParams = 0;
+	const int *pParams = 0;
 	if(Zone == 0)
-		pParams = (int *)&m_Tuning;
+	{
+		// players see the tuning of the room they are in
+		SGameInstance Instance = PlayerGameInstance(ClientID);
+		pParams = (const int *)(Instance.m_IsCreated ? Instance.m_pController->Tuning() : &m_Tuning);
+	}
 	else
-		pParams = (int *)&(m_aTuningList[Zone]);
+		pParams = (const int *)&(m_aTuningList[Zone]);
 
 	unsigned int Last = sizeof(m_Tuning) / sizeof(int);
 	if(m_apPlayers[ClientID])
@@ -694,6 +705,9 @@ void CGameContext::OnTick()
 	UpdatePlayerMaps(); // MYTODO: check if this need to be ticked before controller
 	DoActivityCheck();
 
+	if(Server()->Tick() % (g_Config.m_SvPvpStatsInterval * Server()->TickSpeed()) == 0)
+		m_pPvpStats->Flush();
+
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(m_apPlayers[i])
@@ -969,6 +983,8 @@ void CGameContext::ProgressVoteOptions(int ClientID)
 	if(pPl->m_SendVoteIndex > TotalVotes)
 		return; // shouldn't happen / fail silently
 
+	PROFILE_SCOPE("ProgressVoteOptions", ClientID);
+
 	int VotesLeft = TotalVotes - pPl->m_SendVoteIndex;
 	int NumRoomTitleToSend = clamp(NumRoomTitleVote - pPl->m_SendVoteIndex, 0, NumRoomTitleVote);
 	int NumRoomVotesToSend = clamp(NumRoomVotes - (pPl->m_SendVoteIndex - NumRoomTitleVote), 0, NumRoomVotes);
@@ -1398,6 +1414,7 @@ void *CGameContext::PreProcessMsg(int *MsgID, CUnpacker *pUnpacker, int ClientID
 			CTeeInfo Info(pMsg->m_apSkinPartNames, pMsg->m_aUseCustomColors, pMsg->m_aSkinPartColors);
 			Info.FromSixup();
 			pPlayer->m_TeeInfos = Info;
+			pPlayer->InvalidateClientInfo();
 
 			SendSkinInfo(ClientID);
 
@@ -2157,6 +2174,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			pPlayer->m_TeeInfos.m_ColorFeet = pMsg->m_ColorFeet;
 			if(!Server()->IsSixup(ClientID))
 				pPlayer->m_TeeInfos.ToSixup();
+			pPlayer->InvalidateClientInfo();
 
 			if(SixupNeedsUpdate)
 				SendClientInfo(ClientID);
@@ -2262,6 +2280,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 		pPlayer->m_TeeInfos.m_ColorFeet = pMsg->m_ColorFeet;
 		if(!Server()->IsSixup(ClientID))
 			pPlayer->m_TeeInfos.ToSixup();
+		pPlayer->InvalidateClientInfo();
 
 		// send clear vote options
 		CNetMsg_Sv_VoteClearOptions ClearMsg;
@@ -2297,6 +2316,7 @@ void CGameContext::ConTuneParam(IConsole::IResult *pResult, void *pUserData)
 
 	if(pSelf->Tuning()->Set(pParamName, NewValue))
 	{
+		pSelf->OnTuningChanged();
 		char aBuf[256];
 		str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
@@ -2321,6 +2341,7 @@ void CGameContext::ConToggleTuneParam(IConsole::IResult *pResult, void *pUserDat
 	float NewValue = fabs(OldValue - pResult->GetFloat(1)) < 0.0001f ? pResult->GetFloat(2) : pResult->GetFloat(1);
 
 	pSelf->Tuning()->Set(pParamName, NewValue);
+	pSelf->OnTuningChanged();
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
@@ -2890,6 +2911,7 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 	m_Prng.Seed(aSeed);
 
 	DeleteTempfile();
+	m_pPvpStats = new CPvpStatsWriter(((CServer *)Server())->DbPool());
 
 	for(int i = 0; i < NUM_NETOBJTYPES; i++)
 		Server()->SnapSetStaticsize(i, m_NetObjHandler.GetObjSize(i));
@@ -3084,6 +3106,9 @@ void CGameContext::OnInit(/*class IKernel *pKernel*/)
 		}
 	}
 
+	// the game layer may have disabled player collision or hooking
+	OnTuningChanged();
+
 #ifdef CONF_DEBUG
 	if(g_Config.m_DbgDummies)
 	{
@@ -3113,6 +3138,13 @@ void CGameContext::OnShutdown(bool FullShutdown)
 	DeleteTempfile();
 	Console()->ResetServerGameSettings();
 	Collision()->Dest();
+	if(m_pPvpStats)
+	{
+		// the database pool shuts down after the game
+		m_pPvpStats->Flush(true);
+		delete m_pPvpStats;
+		m_pPvpStats = nullptr;
+	}
 	Clear();
 
 	if(FullShutdown)
@@ -3160,13 +3192,17 @@ void CGameContext::LoadMapSettings()
 
 void CGameContext::OnSnap(int ClientID)
 {
-	// add tuning to demo
+	// add tuning to demo, the server demo shows the main room
 	CTuningParams StandardTuning;
-	if(ClientID == -1 && Server()->DemoRecorder_IsRecording() && mem_comp(&StandardTuning, &m_Tuning, sizeof(CTuningParams)) != 0)
+	const CTuningParams *pTuning = &m_Tuning;
+	SGameInstance Instance = GameInstance(0);
+	if(Instance.m_IsCreated)
+		pTuning = Instance.m_pController->Tuning();
+	if(ClientID == -1 && Server()->DemoRecorder_IsRecording() && mem_comp(&StandardTuning, pTuning, sizeof(CTuningParams)) != 0)
 	{
 		CMsgPacker Msg(NETMSGTYPE_SV_TUNEPARAMS);
-		int *pParams = (int *)&m_Tuning;
-		for(unsigned i = 0; i < sizeof(m_Tuning) / sizeof(int); i++)
+		const int *pParams = (const int *)pTuning;
+		for(unsigned i = 0; i < sizeof(CTuningParams) / sizeof(int); i++)
 			Msg.AddInt(pParams[i]);
 		Server()->SendMsg(&Msg, MSGFLAG_RECORD | MSGFLAG_NOSEND, ClientID);
 	}
@@ -3182,7 +3218,22 @@ void CGameContext::OnSnap(int ClientID)
 	if(ClientID > -1)
 		m_apPlayers[ClientID]->FakeSnap();
 }
-void CGameContext::OnPreSnap() {}
+void CGameContext::OnSnapRoom(int Room)
+{
+	// no viewer, so nothing gets clipped and no player is the local one
+	Teams()->OnSnapRoom(Room);
+
+	for(int i : Teams()->m_Core.Members(Room))
+	{
+		if(m_apPlayers[i])
+			m_apPlayers[i]->Snap(-1);
+	}
+}
+
+void CGameContext::OnPreSnap()
+{
+	Teams()->OnPreSnap();
+}
 void CGameContext::OnPostSnap()
 {
 	Teams()->OnPostSnap();
@@ -3371,6 +3422,7 @@ void CGameContext::ResetTuning()
 	Tuning()->Set("shotgun_speed", 2750);
 	Tuning()->Set("shotgun_speeddiff", 0.80);
 	Tuning()->Set("shotgun_curvature", 1.25);
+	OnTuningChanged();
 	SendTuningParams(-1);
 }
 
@@ -3759,10 +3811,12 @@ void CGameContext::UpdatePlayerMaps()
 	if(Server()->Tick() % g_Config.m_SvMapUpdateRate != 0)
 		return;
 
+	PROFILE_SCOPE("UpdatePlayerMaps");
+
 	std::pair<float, int> Dist[MAX_CLIENTS];
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(!Server()->ClientIngame(i))
+		if(!Server()->ClientIngame(i) || !Server()->NeedsIdTranslation(i))
 			continue;
 		int *pMap = Server()->GetIdMap(i);
 
@@ -3839,6 +3893,7 @@ void CGameContext::UpdatePlayerMaps()
 				pMap[rMap[k]] = -1;
 		}
 		pMap[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+		Server()->UpdateReverseIdMap(i);
 	}
 }
 
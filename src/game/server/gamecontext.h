@@ -65,6 +65,7 @@ enum
 class CConfig;
 class CHeap;
 class CPlayer;
+class CPvpStatsWriter;
 class IConsole;
 class IGameController;
 class IEngine;
@@ -88,6 +89,7 @@ class CGameContext : public IGameServer
 	CNetObjHandler m_NetObjHandler;
 	CTuningParams m_Tuning;
 	CTuningParams m_aTuningList[NUM_TUNEZONES];
+	int m_TuningVersion;
 	array<string> m_aCensorlist;
 
 	CUuid m_GameUuid;
@@ -150,7 +152,11 @@ public:
 	CGameTeams *Teams() { return &m_Teams; }
 	CTuningParams *Tuning() { return &m_Tuning; }
 	CTuningParams *TuningList() { return &m_aTuningList[0]; }
+	// bumped whenever the global tuning changes, rooms with overrides rebuild from it lazily
+	int TuningVersion() const { return m_TuningVersion; }
+	void OnTuningChanged() { m_TuningVersion++; }
 	IAntibot *Antibot() { return m_pAntibot; }
+	CPvpStatsWriter *PvpStats() { return m_pPvpStats; }
 
 	CGameContext();
 	~CGameContext();
@@ -190,6 +196,8 @@ public:
 	char m_aDeleteTempfile[128];
 	void DeleteTempfile();
 
+	CPvpStatsWriter *m_pPvpStats;
+
 	CHeap *m_pVoteOptionHeap;
 	CVoteOptionServer *m_pVoteOptionFirst;
 	CVoteOptionServer *m_pVoteOptionLast;
@@ -237,6 +245,7 @@ public:
 	virtual void OnTick();
 	virtual void OnPreSnap();
 	virtual void OnSnap(int ClientID);
+	virtual void OnSnapRoom(int Room);
 	virtual void OnPostSnap();
 
 	void *PreProcessMsg(int *MsgID, CUnpacker *pUnpacker, int ClientID);
@@ -259,6 +268,8 @@ public:
 	virtual bool IsClientActivePlayer(int ClientID) const;
 
 	virtual bool CheckDisruptiveLeave(int ClientID);
+	virtual int GetClientRoom(int ClientID) const { return m_Teams.m_Core.Team(ClientID); }
+	virtual const char *NetObjName(int Type, bool Sixup) const { return Sixup ? m_NetObjHandler7.GetObjName(Type) : m_NetObjHandler.GetObjName(Type); }
 	virtual int PersistentClientDataSize() const { return sizeof(CPersistentClientData); }
 
 	virtual CUuid GameUuid() const;
@@ -22,8 +22,12 @@
 #include "weapons.h"
 #include <game/layers.h>
 
+#include <engine/server/databases/pvp_stats.h>
 #include <engine/server/server.h>
 
+// the commands of the instance consoles so far, new rooms start from it
+static std::shared_ptr<const CConsole::CCommandTable> s_pInstanceCommands;
+
 // MYTODO: clean up these static methods
 static void ConchainUpdateCountdown(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
@@ -117,7 +121,7 @@ static void ConSetTeamAll(IConsole::IResult *pResult, void *pUserData)
 	str_format(aBuf, sizeof(aBuf), "All players were moved to the %s", pSelf->GetTeamName(Team));
 	pSelf->SendChatTarget(-1, aBuf);
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : pSelf->RoomMembers())
 	{
 		CPlayer *pPlayer = pSelf->GetPlayerIfInRoom(i);
 		if(pPlayer)
@@ -338,6 +342,45 @@ static void ConChangeGameType(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+static void ConTuneParam(IConsole::IResult *pResult, void *pUserData)
+{
+	IGameController *pSelf = (IGameController *)pUserData;
+	const char *pParamName = pResult->GetString(0);
+	float NewValue = pResult->GetFloat(1);
+
+	if(pSelf->SetTuningOverride(pParamName, NewValue))
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
+		pSelf->InstanceConsole()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
+		pSelf->SendTuningParams();
+	}
+	else
+		pSelf->InstanceConsole()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", "No such tuning parameter");
+}
+
+static void ConTuneReset(IConsole::IResult *pResult, void *pUserData)
+{
+	IGameController *pSelf = (IGameController *)pUserData;
+	pSelf->ResetTuningOverrides();
+	pSelf->SendTuningParams();
+	pSelf->InstanceConsole()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", "Tuning reset");
+}
+
+static void ConTuneDump(IConsole::IResult *pResult, void *pUserData)
+{
+	IGameController *pSelf = (IGameController *)pUserData;
+	const CTuningParams *pTuning = pSelf->Tuning();
+	char aBuf[256];
+	for(int i = 0; i < pTuning->Num(); i++)
+	{
+		float v;
+		pTuning->Get(i, &v);
+		str_format(aBuf, sizeof(aBuf), "%s %.2f", pTuning->ms_apNames[i], v);
+		pSelf->InstanceConsole()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
+	}
+}
+
 int IGameController::MakeGameFlag(int GameFlag)
 {
 	int Flags = 0;
@@ -368,8 +411,9 @@ IGameController::IGameController()
 	m_pConfig = nullptr;
 	m_pServer = nullptr;
 	m_pWorld = nullptr;
-	m_pInstanceConsole = new CConsole(CFGFLAG_INSTANCE);
+	m_pInstanceConsole = new CConsole(CFGFLAG_INSTANCE, s_pInstanceCommands);
 	m_MapIndex = 0;
+	m_RoomTuningVersion = -1;
 
 	// balancing
 	m_aTeamSize[TEAM_RED] = 0;
@@ -452,6 +496,9 @@ IGameController::IGameController()
 	m_pInstanceConsole->Register("pause", "?i[seconds]", CFGFLAG_CHAT | CFGFLAG_INSTANCE, ConPause, this, "Pause/unpause game");
 	m_pInstanceConsole->Register("restart", "?i[seconds]", CFGFLAG_CHAT | CFGFLAG_INSTANCE, ConRestart, this, "Restart in x seconds (0 = abort)");
 	m_pInstanceConsole->Register("set_team_all", "i[team-id]", CFGFLAG_INSTANCE, ConSetTeamAll, this, "Set team of all players to team");
+	m_pInstanceConsole->Register("tune", "s[tuning] i[value]", CFGFLAG_INSTANCE, ConTuneParam, this, "Tune variable to value in this room");
+	m_pInstanceConsole->Register("tune_reset", "", CFGFLAG_INSTANCE, ConTuneReset, this, "Reset the tuning of this room to the server tuning");
+	m_pInstanceConsole->Register("tune_dump", "", CFGFLAG_INSTANCE, ConTuneDump, this, "Dump the tuning of this room");
 	m_pInstanceConsole->Register("help", "?r[command]", CFGFLAG_CHAT | CFGFLAG_INSTANCE | CFGFLAG_NO_CONSENT, ConHelp, this, "Shows help to command, general help if left blank");
 	m_pInstanceConsole->Register("info", "", CFGFLAG_CHAT | CFGFLAG_INSTANCE | CFGFLAG_NO_CONSENT, ConHelp, this, "Shows help to command, general help if left blank");
 
@@ -514,7 +561,7 @@ bool IGameController::GetPlayersReadyState(int WithoutID)
 
 void IGameController::SetPlayersReadyState(bool ReadyState)
 {
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && GameServer()->IsClientPlayer(i) && (ReadyState || !pPlayer->m_DeadSpecMode))
@@ -587,7 +634,7 @@ void IGameController::DoTeamBalance()
 	float aPlayerScore[MAX_CLIENTS] = {0.0f};
 
 	// gather stats
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS)
@@ -606,7 +653,7 @@ void IGameController::DoTeamBalance()
 	{
 		CPlayer *pPlayer = 0;
 		float ScoreDiff = aTeamScore[BiggerTeam];
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pRoomPlayer = GetPlayerIfInRoom(i);
 			if(!pRoomPlayer || !CanBeMovedOnBalance(pRoomPlayer))
@@ -645,6 +692,13 @@ int IGameController::OnInternalCharacterDeath(CCharacter *pVictim, CPlayer *pKil
 	if(!(DeathFlag & DEATH_KEEP_SOLO))
 		GameServer()->Teams()->m_Core.SetSolo(pVictim->GetPlayer()->GetCID(), false);
 
+	if(Weapon != WEAPON_GAME && IsGameRunning())
+	{
+		AddPvpStat(pVictim->GetPlayer(), PVPSTAT_DEATHS);
+		if(pKiller && pKiller != pVictim->GetPlayer() && !(IsTeamplay() && pVictim->GetPlayer()->GetTeam() == pKiller->GetTeam()))
+			AddPvpStat(pKiller, PVPSTAT_KILLS);
+	}
+
 	if(!(DeathFlag & DEATH_SKIP_SCORE))
 	{
 		// do scoreing
@@ -665,7 +719,7 @@ int IGameController::OnInternalCharacterDeath(CCharacter *pVictim, CPlayer *pKil
 		pVictim->GetPlayer()->m_RespawnTick = Server()->Tick() + Server()->TickSpeed() * 3.0f;
 
 	// update spectator modes for dead players
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->m_DeadSpecMode)
@@ -1143,7 +1197,7 @@ void IGameController::OnInternalPlayerLeave(CPlayer *pPlayer, int Type)
 		{
 			char aBuf[128];
 			str_format(aBuf, sizeof(aBuf), "'%s' has left the room", Server()->ClientName(ClientID));
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int i : RoomMembers())
 				if(GetPlayerIfInRoom(i) && i != pPlayer->GetCID())
 					GameServer()->SendChatTarget(i, aBuf);
 		}
@@ -1151,7 +1205,7 @@ void IGameController::OnInternalPlayerLeave(CPlayer *pPlayer, int Type)
 		{
 			char aBuf[128];
 			str_format(aBuf, sizeof(aBuf), "'%s' has left the room (kicked)", Server()->ClientName(ClientID));
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int i : RoomMembers())
 				if(GetPlayerIfInRoom(i) && i != pPlayer->GetCID())
 					GameServer()->SendChatTarget(i, aBuf);
 		}
@@ -1177,7 +1231,7 @@ void IGameController::OnInternalPlayerLeave(CPlayer *pPlayer, int Type)
 
 void IGameController::OnReset()
 {
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer)
@@ -1218,7 +1272,7 @@ void IGameController::DoWincheckMatch()
 		// gather some stats
 		int Topscore = 0;
 		int TopscoreCount = 0;
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer)
@@ -1269,6 +1323,7 @@ void IGameController::SetGameState(EGameState GameState, int Timer)
 			if(Timer == TIMER_INFINITE)
 			{
 				// run warmup till there're enough players
+				StopRoomDemo();
 				m_GameState = GameState;
 				m_GameStateTimer = TIMER_INFINITE;
 				m_SuddenDeath = 0;
@@ -1276,7 +1331,7 @@ void IGameController::SetGameState(EGameState GameState, int Timer)
 				// enable respawning in survival when activating warmup
 				if(IsSurvival())
 				{
-					for(int i = 0; i < MAX_CLIENTS; ++i)
+					for(int i : RoomMembers())
 					{
 						CPlayer *pPlayer = GetPlayerIfInRoom(i);
 						if(pPlayer)
@@ -1320,7 +1375,7 @@ void IGameController::SetGameState(EGameState GameState, int Timer)
 				// enable respawning in survival when activating warmup
 				if(IsSurvival())
 				{
-					for(int i = 0; i < MAX_CLIENTS; ++i)
+					for(int i : RoomMembers())
 					{
 						CPlayer *pPlayer = GetPlayerIfInRoom(i);
 						if(pPlayer)
@@ -1407,6 +1462,8 @@ void IGameController::SetGameState(EGameState GameState, int Timer)
 		// only possible when game is running or over
 		if(m_GameState == IGS_GAME_RUNNING || m_GameState == IGS_END_MATCH || m_GameState == IGS_END_ROUND || m_GameState == IGS_GAME_PAUSED)
 		{
+			if(GameState == IGS_END_MATCH && m_GameState != IGS_END_MATCH)
+				RecordMatchStats();
 			m_GameState = GameState;
 			m_GameStateTimer = Timer * Server()->TickSpeed();
 			if(m_GameState != IGS_END_ROUND)
@@ -1416,6 +1473,76 @@ void IGameController::SetGameState(EGameState GameState, int Timer)
 	}
 }
 
+void IGameController::StartRoomDemo()
+{
+	if(!Config()->m_SvRoomDemoRecord)
+		return;
+
+	// the demo starts out with the standard tuning
+	m_DemoTuning = CTuningParams();
+	Server()->StartRoomRecord(GameWorld()->Team());
+}
+
+void IGameController::StopRoomDemo()
+{
+	// demos started with record_room run until they are stopped
+	if(Config()->m_SvRoomDemoRecord)
+		Server()->StopRoomRecord(GameWorld()->Team());
+}
+
+void IGameController::SnapDemo()
+{
+	// the tuning isn't part of the snapshot, record it whenever it changes
+	const CTuningParams *pTuning = Tuning();
+	if(mem_comp(&m_DemoTuning, pTuning, sizeof(CTuningParams)) == 0)
+		return;
+	m_DemoTuning = *pTuning;
+
+	CMsgPacker Msg(NETMSGTYPE_SV_TUNEPARAMS);
+	const int *pParams = (const int *)pTuning;
+	for(unsigned i = 0; i < sizeof(CTuningParams) / sizeof(int); i++)
+		Msg.AddInt(pParams[i]);
+	Server()->RecordRoomMsg(&Msg, GameWorld()->Team());
+}
+
+void IGameController::AddPvpStat(CPlayer *pPlayer, int Stat, int Amount)
+{
+	if(!g_Config.m_SvPvpStats || !pPlayer)
+		return;
+	GameServer()->PvpStats()->Add(GameWorld()->Team(), Server()->ClientName(pPlayer->GetCID()), m_pGameType, Stat, Amount);
+}
+
+void IGameController::RecordMatchStats()
+{
+	if(!g_Config.m_SvPvpStats)
+		return;
+
+	// without teams everyone with the top score wins
+	int TopScore = 0;
+	bool HasPlayers = false;
+	for(int i : RoomMembers())
+	{
+		CPlayer *pPlayer = GetPlayerIfInRoom(i);
+		if(!pPlayer || pPlayer->GetTeam() == TEAM_SPECTATORS)
+			continue;
+		if(!HasPlayers || pPlayer->m_Score > TopScore)
+			TopScore = pPlayer->m_Score;
+		HasPlayers = true;
+	}
+
+	for(int i : RoomMembers())
+	{
+		CPlayer *pPlayer = GetPlayerIfInRoom(i);
+		if(!pPlayer || pPlayer->GetTeam() == TEAM_SPECTATORS)
+			continue;
+		AddPvpStat(pPlayer, PVPSTAT_MATCHES);
+		int Team = pPlayer->GetTeam();
+		if(IsTeamplay() ? m_aTeamscore[Team] > m_aTeamscore[Team ^ 1] : pPlayer->m_Score == TopScore)
+			AddPvpStat(pPlayer, PVPSTAT_WINS);
+	}
+	GameServer()->PvpStats()->FlushRoom(GameWorld()->Team());
+}
+
 void IGameController::TryStartWarmup(bool FallbackToWarmup)
 {
 	// no player is playing. reset the entire match
@@ -1447,6 +1574,9 @@ void IGameController::TryStartWarmup(bool FallbackToWarmup)
 
 void IGameController::StartMatch()
 {
+	// the demo of the previous match ends with its scoreboard
+	StopRoomDemo();
+
 	// If we passed warmup and still not enough player, do infinite timer
 	if(IsWarmup() && !HasEnoughPlayers())
 	{
@@ -1474,6 +1604,7 @@ void IGameController::StartMatch()
 
 	if(HasEnoughPlayers())
 	{
+		StartRoomDemo();
 		SetGameState(IGS_START_COUNTDOWN);
 		OnGameStart(false);
 
@@ -1593,7 +1724,7 @@ void IGameController::SwapTeams()
 
 	SendGameMsg(GAMEMSG_TEAM_SWAP, -1);
 
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS)
@@ -1612,7 +1743,7 @@ void IGameController::ShuffleTeams()
 	int PlayerTeam = 0;
 	CPlayer *aPlayer[MAX_CLIENTS];
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS)
@@ -1646,7 +1777,7 @@ void IGameController::FakeGameMsgSound(int SnappingClient, int SoundID)
 // for compatibility of 0.7's round ends and infinite warmup
 void IGameController::FakeClientBroadcast(int SnappingClient)
 {
-	if(Server()->IsSixup(SnappingClient))
+	if(SnappingClient < 0 || Server()->IsSixup(SnappingClient))
 		return;
 
 	CPlayer *pPlayer = GetPlayerIfInRoom(SnappingClient);
@@ -1921,7 +2052,7 @@ void IGameController::Tick()
 	{
 		// reset sending of vote options
 		// only reset for player in room
-		for(int i = 0; i < MAX_CLIENTS; ++i)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer)
@@ -1952,7 +2083,7 @@ void IGameController::Tick()
 				// count votes
 				char aaBuf[MAX_CLIENTS][NETADDR_MAXSTRSIZE] = {{0}}, *pIP = NULL;
 				bool SinglePlayer = true;
-				for(int i = 0; i < MAX_CLIENTS; i++)
+				for(int i : RoomMembers())
 				{
 					CPlayer *pPlayer = GetPlayerIfInRoom(i);
 					if(pPlayer)
@@ -1968,7 +2099,7 @@ void IGameController::Tick()
 				// remember checked players, only the first player with a specific ip will be handled
 				bool aVoteChecked[MAX_CLIENTS] = {false};
 				int64 Now = Server()->Tick();
-				for(int i = 0; i < MAX_CLIENTS; i++)
+				for(int i : RoomMembers())
 				{
 					CPlayer *pPlayer = GetPlayerIfInRoom(i);
 					if(!pPlayer || aVoteChecked[i])
@@ -2421,7 +2552,7 @@ void IGameController::EvaluateSpawnType(CSpawnEval *pEval, int Type) const
 		for(int Index = 0; Index < 5 && Result == -1; ++Index)
 		{
 			Result = Index;
-			if(!GameWorld()->m_Core.m_Tuning.m_PlayerCollision)
+			if(!GameWorld()->m_Core.m_pTuning->m_PlayerCollision)
 				break;
 			for(int c = 0; c < Num; ++c)
 			{
@@ -2634,6 +2765,66 @@ CPlayer *IGameController::GetPlayerIfInRoom(int ClientID) const
 	return nullptr;
 }
 
+CClientMask IGameController::RoomMembers() const
+{
+	return GameServer()->Teams()->m_Core.Members(GameWorld()->Team());
+}
+
+const CTuningParams *IGameController::Tuning()
+{
+	// rooms without overrides share the global tuning
+	if(m_TuningOverrides.empty())
+		return GameServer()->Tuning();
+
+	if(m_RoomTuningVersion != GameServer()->TuningVersion())
+	{
+		m_RoomTuning = *GameServer()->Tuning();
+		for(const auto &Override : m_TuningOverrides)
+			m_RoomTuning.Set(Override.m_Index, Override.m_Value);
+		m_RoomTuningVersion = GameServer()->TuningVersion();
+	}
+	return &m_RoomTuning;
+}
+
+bool IGameController::SetTuningOverride(const char *pParamName, float Value)
+{
+	int Index = CTuningParams::Index(pParamName);
+	if(Index < 0)
+		return false;
+
+	m_RoomTuningVersion = -1;
+	for(auto &Override : m_TuningOverrides)
+	{
+		if(Override.m_Index == Index)
+		{
+			Override.m_Value = Value;
+			return true;
+		}
+	}
+	m_TuningOverrides.push_back({Index, Value});
+	return true;
+}
+
+void IGameController::ResetTuningOverrides()
+{
+	m_TuningOverrides.clear();
+	m_RoomTuningVersion = -1;
+}
+
+void IGameController::SendTuningParams()
+{
+	for(int i : RoomMembers())
+	{
+		CPlayer *pPlayer = GetPlayerIfInRoom(i);
+		if(!pPlayer)
+			continue;
+
+		int TuneZone = pPlayer->GetCharacter() ? pPlayer->GetCharacter()->m_TuneZone : pPlayer->m_TuneZone;
+		if(TuneZone == 0)
+			GameServer()->SendTuningParams(i, 0);
+	}
+}
+
 void IGameController::InitController(class CGameContext *pGameServer, class CGameWorld *pWorld)
 {
 	m_Started = false;
@@ -2643,6 +2834,8 @@ void IGameController::InitController(class CGameContext *pGameServer, class CGam
 	m_pWorld = pWorld;
 	m_GameStartTick = m_pServer->Tick();
 	m_pInstanceConsole->InitNoConfig(m_pGameServer->Storage());
+	// all commands of this gametype are registered by now
+	s_pInstanceCommands = static_cast<CConsole *>(m_pInstanceConsole)->CommandTable();
 	m_PauseRequested = false;
 
 	// game
@@ -2684,7 +2877,7 @@ void IGameController::StartVote(const char *pDesc, const char *pCommand, const c
 	// reset votes
 	m_VoteEnforce = VOTE_ENFORCE_UNKNOWN;
 	m_VoteEnforcer = -1;
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer)
@@ -2791,7 +2984,7 @@ void IGameController::SendVoteSet(int ClientID) const
 
 	if(ClientID == -1)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer)
@@ -2855,6 +3048,15 @@ void IGameController::SendChatTarget(int To, const char *pText, int Flags) const
 	for(int i = Start; i < Limit; i++)
 		if(GetPlayerIfInRoom(i))
 			GameServer()->SendChatTarget(i, pText, Flags);
+
+	if(To < 0 && Config()->m_SvDemoChat && (Flags & CGameContext::CHAT_SIX))
+	{
+		CNetMsg_Sv_Chat Msg;
+		Msg.m_Team = 0;
+		Msg.m_ClientID = -1;
+		Msg.m_pMessage = pText;
+		Server()->RecordRoomPackMsg(&Msg, GameWorld()->Team());
+	}
 }
 
 void IGameController::SendBroadcast(const char *pText, int ClientID, bool IsImportant) const
@@ -2881,11 +3083,12 @@ void IGameController::SendKillMsg(int Killer, int Victim, int Weapon, int ModeSp
 	Msg.m_Weapon = Weapon;
 	Msg.m_ModeSpecial = ModeSpecial;
 
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		if(GetPlayerIfInRoom(i))
 			Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, i);
 	}
+	Server()->RecordRoomPackMsg(&Msg, GameWorld()->Team());
 }
 
 void IGameController::InstanceConsolePrint(const char *pStr, void *pUser)
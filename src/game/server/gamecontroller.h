@@ -7,6 +7,7 @@
 #include <engine/console.h>
 #include <engine/map.h>
 #include <engine/shared/config.h>
+#include <game/gamecore.h>
 #include <game/generated/protocol.h>
 #include <game/voting.h>
 
@@ -119,6 +120,24 @@ class IGameController
 	void FakeClientBroadcast(int SnappingClient);
 	void FakeGameMsgSound(int SnappingClient, int SoundID);
 
+	// room tuning, overrides applied on top of the global tuning
+	struct STuningOverride
+	{
+		int m_Index;
+		float m_Value;
+	};
+	std::vector<STuningOverride> m_TuningOverrides;
+	CTuningParams m_RoomTuning;
+	int m_RoomTuningVersion;
+
+	// wins and played matches of the room, handed to the database right away
+	void RecordMatchStats();
+
+	// demo of the current match, see sv_room_demo_record
+	CTuningParams m_DemoTuning;
+	void StartRoomDemo();
+	void StopRoomDemo();
+
 protected:
 	bool m_Started;
 
@@ -269,6 +288,9 @@ protected:
 	// default to: 0
 	int m_DDNetInfoFlag2;
 
+	// pvp statistics, see PVPSTAT_* in engine/server/databases/connection.h
+	void AddPvpStat(class CPlayer *pPlayer, int Stat, int Amount = 1);
+
 public:
 	IGameController();
 	virtual ~IGameController();
@@ -337,6 +359,8 @@ public:
 
 	// general
 	void Snap(int SnappingClient);
+	// called before the room is snapped for its demo
+	void SnapDemo();
 	void Tick();
 	void UpdateGameInfo(int ClientID);
 
@@ -381,9 +405,17 @@ public:
 	int GetRealPlayerNum() const { return m_aTeamSize[TEAM_RED] + m_aTeamSize[TEAM_BLUE]; }
 	int GetStartTeam();
 
+	// tuning
+	const CTuningParams *Tuning();
+	bool SetTuningOverride(const char *pParamName, float Value);
+	void ResetTuningOverrides();
+	void SendTuningParams();
+
 	// DDRace
 	int GetPlayerTeam(int ClientID) const;
 	class CPlayer *GetPlayerIfInRoom(int ClientID) const;
+	// clients whose room is this one, they may not have a player yet
+	CClientMask RoomMembers() const;
 	void InitController(class CGameContext *pGameServer, class CGameWorld *pWorld);
 
 	// vote
@@ -18,7 +18,7 @@ CGameControllerCatch::CGameControllerCatch()
 void CGameControllerCatch::Catch(CPlayer *pVictim)
 {
 	CPlayer *TopPlayer = nullptr;
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetCharacter() && pPlayer->GetCharacter()->IsAlive() && (!TopPlayer || pPlayer->m_Score > TopPlayer->m_Score))
@@ -117,7 +117,7 @@ void CGameControllerCatch::OnKill(CPlayer *pPlayer)
 
 	if(m_aNumCaught[ClientID] > 0)
 	{
-		for(int i = 0; i < MAX_CLIENTS; ++i)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == ClientID)
@@ -137,7 +137,7 @@ void CGameControllerCatch::OnPreTick()
 
 	float PointDist = 50.0f;
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetCharacter() && pPlayer->GetCharacter()->IsAlive())
@@ -279,7 +279,7 @@ int CGameControllerCatch::OnCharacterDeath(CCharacter *pVictim, CPlayer *pKiller
 	if(IsWarmup())
 		return DEATH_NORMAL;
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == pVictim->GetPlayer()->GetCID())
@@ -314,7 +314,7 @@ void CGameControllerCatch::DoWincheckMatch()
 	CPlayer *pAlivePlayer = 0;
 	int AlivePlayerCount = 0;
 	int TotalPlayerCount = 0;
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS)
@@ -338,7 +338,7 @@ void CGameControllerCatch::DoWincheckMatch()
 		}
 		else
 		{
-			for(int i = 0; i < MAX_CLIENTS; ++i)
+			for(int i : RoomMembers())
 			{
 				CPlayer *pPlayer = GetPlayerIfInRoom(i);
 				if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == pAlivePlayer->GetCID())
@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <engine/server/databases/connection.h>
 #include <engine/shared/config.h>
 
 #include <game/mapitems.h>
@@ -177,6 +178,7 @@ void CGameControllerCTF::OnPostTick()
 					// CAPTURE! \o/
 					m_aTeamscore[fi ^ 1] += 100;
 					F->GetCarrier()->GetPlayer()->m_Score += 5;
+					AddPvpStat(F->GetCarrier()->GetPlayer(), PVPSTAT_CAPTURES);
 					float Diff = Server()->Tick() - F->GetGrabTick();
 
 					char aBuf[64];
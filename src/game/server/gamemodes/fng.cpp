@@ -45,7 +45,7 @@ CGameControllerFNG::CGameControllerFNG()
 void CGameControllerSoloFNG::OnPreTick()
 {
 	// first pass, check unhook
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	for(int i : RoomMembers())
 	{
 		if(GetPlayerIfInRoom(i))
 		{
@@ -32,7 +32,7 @@ public:
 		if(pResult->NumArguments() >= 1)
 		{
 			IGameController *pThis = static_cast<IGameController *>(pUserData);
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int i : pThis->RoomMembers())
 			{
 				CPlayer *pPlayer = pThis->GetPlayerIfInRoom(i);
 				if(pPlayer && pPlayer->GetCharacter())
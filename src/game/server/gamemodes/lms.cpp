@@ -24,7 +24,7 @@ void CGameControllerLMS::OnWorldReset()
 	if(m_SuddenDeath)
 	{
 		int Topscore = 0;
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer)
@@ -32,7 +32,7 @@ void CGameControllerLMS::OnWorldReset()
 					Topscore = pPlayer->m_Score;
 		}
 
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer && pPlayer->m_Score != Topscore)
@@ -68,7 +68,7 @@ void CGameControllerLMS::DoWincheckRound()
 	// check for time based win
 	if(!m_SuddenDeath && m_GameInfo.m_TimeLimit > 0 && (Server()->Tick() - m_GameStartTick) >= m_GameInfo.m_TimeLimit * Server()->TickSpeed() * 60)
 	{
-		for(int i = 0; i < MAX_CLIENTS; ++i)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS &&
@@ -84,7 +84,7 @@ void CGameControllerLMS::DoWincheckRound()
 		// check for survival win
 		CPlayer *pAlivePlayer = 0;
 		int AlivePlayerCount = 0;
-		for(int i = 0; i < MAX_CLIENTS; ++i)
+		for(int i : RoomMembers())
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS &&
@@ -43,7 +43,7 @@ bool CGameControllerLTS::OnEntity(int Index, vec2 Pos, int Layer, int Flags, int
 void CGameControllerLTS::DoWincheckRound()
 {
 	int Count[2] = {0};
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	for(int i : RoomMembers())
 	{
 		CPlayer *pPlayer = GetPlayerIfInRoom(i);
 		if(pPlayer && pPlayer->GetTeam() != TEAM_SPECTATORS &&
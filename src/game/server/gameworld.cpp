@@ -25,6 +25,7 @@ CGameWorld::CGameWorld(int Team, CGameContext *pGameServer, IGameController *pCo
 
 	m_Paused = false;
 	m_ResetRequested = false;
+	m_Core.m_pTuning = pGameServer->Tuning();
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		pFirstEntityType = 0;
 }
@@ -40,11 +41,25 @@ CGameWorld::~CGameWorld()
 			delete pFirstEntityType;
 }
 
+const CTuningParams *CGameWorld::Tuning()
+{
+	return m_pController->Tuning();
+}
+
 CEntity *CGameWorld::FindFirst(int Type)
 {
 	return Type < 0 || Type >= NUM_ENTTYPES ? 0 : m_apFirstEntityTypes[Type];
 }
 
+int CGameWorld::NumEntities() const
+{
+	int Num = 0;
+	for(const CEntity *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			Num++;
+	return Num;
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
@@ -144,6 +159,11 @@ void CGameWorld::Snap(int SnappingClient, int OtherMode)
 		m_Events.Snap(SnappingClient);
 }
 
+void CGameWorld::OnPreSnap()
+{
+	m_Events.Prepare();
+}
+
 void CGameWorld::OnPostSnap()
 {
 	m_Events.Clear();
@@ -407,7 +427,7 @@ void CGameWorld::CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponID,
 		l = 1 - clamp((l - InnerRadius) / (Radius - InnerRadius), 0.0f, 1.0f);
 		float Strength;
 		if(Owner < 0 || !GameServer()->m_apPlayers[Owner] || !GameServer()->m_apPlayers[Owner]->m_TuneZone)
-			Strength = GameServer()->Tuning()->m_ExplosionStrength;
+			Strength = Tuning()->m_ExplosionStrength;
 		else
 			Strength = GameServer()->TuningList()[GameServer()->m_apPlayers[Owner]->m_TuneZone].m_ExplosionStrength;
 
@@ -56,6 +56,7 @@ public:
 	class IServer *Server() { return m_pServer; }
 
 	int Team() { return m_ResponsibleTeam; }
+	const CTuningParams *Tuning();
 
 	bool m_ResetRequested;
 	bool m_Paused;
@@ -65,6 +66,7 @@ public:
 	~CGameWorld();
 
 	CEntity *FindFirst(int Type);
+	int NumEntities() const;
 
 	/*
 		Function: find_entities
@@ -165,6 +167,7 @@ public:
 	*/
 	void Tick();
 
+	void OnPreSnap();
 	void OnPostSnap();
 
 	// DDRace
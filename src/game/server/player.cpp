@@ -51,6 +51,9 @@ void CPlayer::Reset()
 		pIdMap[i] = -1;
 	}
 	pIdMap[0] = m_ClientID;
+	Server()->UpdateReverseIdMap(m_ClientID);
+
+	m_ClientInfo.Invalidate();
 
 	// DDRace
 
@@ -455,9 +458,9 @@ void CPlayer::Snap(int SnappingClient)
 	if(SnappingClient > -1 && !Server()->Translate(MappedID, SnappingClient))
 		return;
 
-	CPlayer *pSnappingPlayer = GameServer()->m_apPlayers[SnappingClient];
+	CPlayer *pSnappingPlayer = SnappingClient >= 0 ? GameServer()->m_apPlayers[SnappingClient] : nullptr;
 	int SnapAs = SnappingClient;
-	if(pSnappingPlayer->IsSpectating() && pSnappingPlayer->GetSpectatorID() > SPEC_FREEVIEW)
+	if(pSnappingPlayer && pSnappingPlayer->IsSpectating() && pSnappingPlayer->GetSpectatorID() > SPEC_FREEVIEW)
 		SnapAs = pSnappingPlayer->m_SpectatorID; // Snap as spectating player.
 
 	bool IsEndRound = false;
@@ -477,22 +480,8 @@ void CPlayer::Snap(int SnappingClient)
 	if(!pClientInfo)
 		return;
 
-	StrToInts(&pClientInfo->m_Name0, 4, Server()->ClientName(m_ClientID));
-	if(IsReadyMode)
-	{
-		if(m_IsReadyToPlay)
-			StrToInts(&pClientInfo->m_Clan0, 3, "READY");
-		else
-			StrToInts(&pClientInfo->m_Clan0, 3, "");
-	}
-	else
-		StrToInts(&pClientInfo->m_Clan0, 3, Server()->ClientClan(m_ClientID));
-	pClientInfo->m_Country = Server()->ClientCountry(m_ClientID);
-
-	StrToInts(&pClientInfo->m_Skin0, 6, m_TeeInfos.m_SkinName);
-	pClientInfo->m_UseCustomColor = m_TeeInfos.m_UseCustomColor;
-	pClientInfo->m_ColorBody = m_TeeInfos.m_ColorBody;
-	pClientInfo->m_ColorFeet = m_TeeInfos.m_ColorFeet;
+	int Clan = !IsReadyMode ? CClientInfoCache::CLAN : m_IsReadyToPlay ? CClientInfoCache::READY : CClientInfoCache::NOT_READY;
+	mem_copy(pClientInfo, m_ClientInfo.Get(Clan, Server()->ClientName(m_ClientID), Server()->ClientClan(m_ClientID), Server()->ClientCountry(m_ClientID), m_TeeInfos), sizeof(CNetObj_ClientInfo));
 
 	int SnappingClientVersion = SnappingClient >= 0 ? GameServer()->GetClientVersion(SnappingClient) : CLIENT_VERSIONNR;
 	int Latency = SnappingClient == -1 ? m_Latency.m_Min : GameServer()->m_apPlayers[SnappingClient]->m_aActLatency[m_ClientID];
@@ -511,7 +500,7 @@ void CPlayer::Snap(int SnappingClient)
 
 		bool DeadAndNoRespawn = m_RespawnDisabled && (!m_pCharacter || !m_pCharacter->IsAlive());
 		bool FakeSpectator = m_ClientID == SnappingClient && (m_Paused || (m_DeadSpecMode && !IsEndMatch) || ((!m_pCharacter || !m_pCharacter->IsAlive()) && IsEndRound));
-		FakeSpectator |= GameServer()->GetDDRaceTeam(SnapAs) != GameServer()->GetDDRaceTeam(m_ClientID) && !GameServer()->m_apPlayers[SnappingClient]->ShowOthersMode();
+		FakeSpectator |= pSnappingPlayer && GameServer()->GetDDRaceTeam(SnapAs) != GameServer()->GetDDRaceTeam(m_ClientID) && !pSnappingPlayer->ShowOthersMode();
 		FakeSpectator |= !IsEndMatch && ((m_ClientID != SnappingClient || IsEndRound) && DeadAndNoRespawn);
 
 		if(FakeSpectator)
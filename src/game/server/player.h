@@ -4,6 +4,7 @@
 #define GAME_SERVER_PLAYER_H
 
 #include "alloc.h"
+#include "clientinfo.h"
 
 // this include should perhaps be removed
 // #include "score.h"
@@ -53,6 +54,8 @@ public:
 
 	void Snap(int SnappingClient);
 	void FakeSnap();
+	// call after changing name, clan, country or skin
+	void InvalidateClientInfo() { m_ClientInfo.Invalidate(); }
 
 	void OnDirectInput(CNetObj_PlayerInput *NewInput);
 	void OnPredictedInput(CNetObj_PlayerInput *NewInput);
@@ -188,6 +191,8 @@ private:
 	int m_SpectatorID;
 	void SetSpectatorID(int ClientID);
 
+	CClientInfoCache m_ClientInfo;
+
 public:
 	enum
 	{
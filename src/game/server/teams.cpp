@@ -1,6 +1,8 @@
 /* (c) Shereef Marzouk. See "licence DDRace.txt" and the readme.txt in the root of the distribution for more information. */
 #include "teams.h"
 #include <engine/shared/config.h>
+#include <engine/shared/metrics.h>
+#include <engine/shared/profiler.h>
 #include <game/version.h>
 
 #include "entities/character.h"
@@ -25,6 +27,7 @@ CGameTeams::CGameTeams()
 
 CGameTeams::~CGameTeams()
 {
+	CMetrics::RemoveCollector(CollectMetrics, this);
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 		DestroyGameInstance(i);
 }
@@ -33,6 +36,8 @@ void CGameTeams::Init(CGameContext *pGameServer)
 {
 	m_pGameContext = pGameServer;
 	CreateGameInstance(0, nullptr, -1);
+	CMetrics::RemoveCollector(CollectMetrics, this);
+	CMetrics::AddCollector(CollectMetrics, this);
 }
 
 void CGameTeams::Reset()
@@ -328,8 +333,8 @@ bool CGameTeams::CreateGameInstance(int Team, const char *pGameName, int Asker)
 	str_format(aBuf, sizeof(aBuf), "game controller %d is created", Team);
 	GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "team", aBuf);
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(GameServer()->PlayerExists(i) && m_Core.Team(i) == Team)
+	for(int i : m_Core.Members(Team))
+		if(GameServer()->PlayerExists(i))
 			m_aTeamInstances[Team].m_pController->OnInternalPlayerJoin(GameServer()->m_apPlayers[i], INSTANCE_CONNECTION_RELOAD);
 
 	UpdateGameTypeName();
@@ -375,10 +380,11 @@ void CGameTeams::DestroyGameInstance(int Team)
 	if(!m_aTeamInstances[Team].m_IsCreated)
 		return;
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(GameServer()->PlayerExists(i) && m_Core.Team(i) == Team)
+	for(int i : m_Core.Members(Team))
+		if(GameServer()->PlayerExists(i))
 			GameServer()->m_apPlayers[i]->KillCharacter();
 
+	GameServer()->Server()->StopRoomRecord(Team);
 	delete m_aTeamInstances[Team].m_pController;
 	delete m_aTeamInstances[Team].m_pWorld;
 	m_aTeamInstances[Team].m_Init = false;
@@ -459,8 +465,8 @@ void CGameTeams::OnTick()
 			{
 				m_aTeamReload[i] = RELOAD_TYPE_NO;
 
-				for(int p = 0; p < MAX_CLIENTS; p++)
-					if(GameServer()->PlayerExists(p) && m_Core.Team(p) == i)
+				for(int p : m_Core.Members(i))
+					if(GameServer()->PlayerExists(p))
 						GameServer()->m_apPlayers[p]->KillCharacter();
 
 				delete m_aTeamInstances[i].m_pWorld;
@@ -471,8 +477,12 @@ void CGameTeams::OnTick()
 			}
 			else
 			{
-				m_aTeamInstances[i].m_pWorld->m_Core.m_Tuning = *GameServer()->Tuning();
-				m_aTeamInstances[i].m_pController->Tick();
+				m_aTeamInstances[i].m_pWorld->m_Core.m_pTuning = m_aTeamInstances[i].m_pController->Tuning();
+				{
+					PROFILE_SCOPE("controller tick", i);
+					m_aTeamInstances[i].m_pController->Tick();
+				}
+				PROFILE_SCOPE("world tick", i);
 				m_aTeamInstances[i].m_pWorld->Tick();
 			}
 		}
@@ -533,14 +543,19 @@ void CGameTeams::OnEntity(int Index, vec2 Pos, int Layer, int Flags, int MegaMap
 
 void CGameTeams::OnSnap(int SnappingClient)
 {
-	CPlayer *pPlayer = GameServer()->m_apPlayers[SnappingClient];
-	int ShowOthers = pPlayer->ShowOthersMode();
-
-	int SnapAs = SnappingClient;
-	if(pPlayer->IsSpectating() && pPlayer->GetSpectatorID() >= 0)
-		SnapAs = pPlayer->GetSpectatorID();
+	// the server demo shows the main room and the others faded
+	int ShowOthers = 1;
+	int SnapAsTeam = 0;
+	CPlayer *pPlayer = SnappingClient >= 0 ? GameServer()->m_apPlayers[SnappingClient] : nullptr;
+	if(pPlayer)
+	{
+		ShowOthers = pPlayer->ShowOthersMode();
 
-	int SnapAsTeam = m_Core.Team(SnapAs);
+		int SnapAs = SnappingClient;
+		if(pPlayer->IsSpectating() && pPlayer->GetSpectatorID() >= 0)
+			SnapAs = pPlayer->GetSpectatorID();
+		SnapAsTeam = m_Core.Team(SnapAs);
+	}
 
 	// Spectator
 	if(ShowOthers)
@@ -563,6 +578,24 @@ void CGameTeams::OnSnap(int SnappingClient)
 	}
 }
 
+void CGameTeams::OnSnapRoom(int Team)
+{
+	SGameInstance Instance = GetGameInstance(Team);
+	if(Instance.m_IsCreated)
+		Instance.m_pController->SnapDemo();
+	if(Instance.m_Init)
+		Instance.m_pWorld->Snap(-1, 0);
+	if(Instance.m_IsCreated)
+		Instance.m_pController->Snap(-1);
+}
+
+void CGameTeams::OnPreSnap()
+{
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+		if(m_aTeamInstances[i].m_Init)
+			m_aTeamInstances[i].m_pWorld->OnPreSnap();
+}
+
 void CGameTeams::OnPostSnap()
 {
 	for(int i = 0; i < MAX_CLIENTS; ++i)
@@ -570,6 +603,28 @@ void CGameTeams::OnPostSnap()
 			m_aTeamInstances[i].m_pWorld->OnPostSnap();
 }
 
+void CGameTeams::CollectMetrics(CMetricsWriter *pWriter, void *pUser)
+{
+	CGameTeams *pThis = (CGameTeams *)pUser;
+
+	int NumRooms = 0;
+	for(const auto &Instance : pThis->m_aTeamInstances)
+		if(Instance.m_Init)
+			NumRooms++;
+	pWriter->Header("ddnet_rooms", "Rooms with a running game", "gauge");
+	pWriter->Sample("ddnet_rooms", nullptr, (int64)NumRooms);
+
+	pWriter->Header("ddnet_room_entities", "Entities in the game world of a room", "gauge");
+	char aLabels[32];
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(!pThis->m_aTeamInstances[i].m_Init)
+			continue;
+		str_format(aLabels, sizeof(aLabels), "room=\"%d\"", i);
+		pWriter->Sample("ddnet_room_entities", aLabels, (int64)pThis->m_aTeamInstances[i].m_pWorld->NumEntities());
+	}
+}
+
 int CGameTeams::GetTeamState(int Team)
 {
 	return m_aTeamState[Team];
@@ -677,7 +732,8 @@ void CGameTeams::UpdateVotes()
 		PlayerCount += GameServer()->PlayerExists(i) ? 1 : 0;
 	int RemainingSlots = g_Config.m_SvMaxClients - g_Config.m_SvReservedSlots - PlayerCount;
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	// room 0 is listed even when nobody is in it
+	for(int i : CClientMask(m_Core.OccupiedRooms().Mask() | 1))
 	{
 		int NumPlayersInRoom = m_Core.Count(i);
 		IGameController *pController = m_aTeamInstances[i].m_pController;
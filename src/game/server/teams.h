@@ -130,7 +130,10 @@ public:
 	void OnTick();
 	void OnEntity(int Index, vec2 Pos, int Layer, int Flags, int MegaMapIndex, int Number = 0);
 	void OnSnap(int SnappingClient);
+	void OnSnapRoom(int Team);
+	void OnPreSnap();
 	void OnPostSnap();
+	static void CollectMetrics(class CMetricsWriter *pWriter, void *pUser);
 
 	void UpdateVotes();
 	char m_aRoomVotes[MAX_CLIENTS][VOTE_DESC_LENGTH];
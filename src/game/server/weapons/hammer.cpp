@@ -67,7 +67,7 @@ void CHammer::Fire(vec2 Direction)
 		float FireDelay;
 		int TuneZone = Character()->m_TuneZone;
 		if(!TuneZone)
-			FireDelay = GameServer()->Tuning()->m_HammerHitFireDelay;
+			FireDelay = GameWorld()->Tuning()->m_HammerHitFireDelay;
 		else
 			FireDelay = GameServer()->TuningList()[TuneZone].m_HammerHitFireDelay;
 		m_ReloadTimer = FireDelay * Server()->TickSpeed() / 1000;
@@ -41,7 +41,7 @@ void CShotgun::Fire(vec2 Direction)
 		float a = angle(Direction);
 		a += Spreading[i + 2];
 		float v = 1 - (absolute(i) / (float)ShotSpread);
-		float Speed = mix((float)GameServer()->Tuning()->m_ShotgunSpeeddiff, 1.0f, v);
+		float Speed = mix((float)GameWorld()->Tuning()->m_ShotgunSpeeddiff, 1.0f, v);
 		CProjectile *pProj = new CProjectile(
 			GameWorld(),
 			WEAPON_SHOTGUN, // Type
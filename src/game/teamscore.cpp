@@ -19,23 +19,41 @@ int CTeamsCore::Team(int ClientID) const
 
 void CTeamsCore::Team(int ClientID, int Team)
 {
-	m_TeamSize[m_Team[ClientID]]--;
-	m_TeamSize[Team]++;
+	RemoveMember(ClientID);
 	m_Team[ClientID] = Team;
+	AddMember(ClientID);
 }
 
 void CTeamsCore::Join(int ClientID, int Team)
 {
 	m_Team[ClientID] = Team;
-	m_TeamSize[Team]++;
+	AddMember(ClientID);
 }
 
 void CTeamsCore::Leave(int ClientID)
 {
-	m_TeamSize[m_Team[ClientID]]--;
+	RemoveMember(ClientID);
 	m_Team[ClientID] = TEAM_FLOCK;
 }
 
+void CTeamsCore::AddMember(int ClientID)
+{
+	int Team = m_Team[ClientID];
+	m_aMembers[Team] |= (uint64)1 << ClientID;
+	m_TeamSize[Team] = bitcount64(m_aMembers[Team]);
+	if(Team < MAX_CLIENTS)
+		m_OccupiedRooms |= (uint64)1 << Team;
+}
+
+void CTeamsCore::RemoveMember(int ClientID)
+{
+	int Team = m_Team[ClientID];
+	m_aMembers[Team] &= ~((uint64)1 << ClientID);
+	m_TeamSize[Team] = bitcount64(m_aMembers[Team]);
+	if(Team < MAX_CLIENTS && !m_aMembers[Team])
+		m_OccupiedRooms &= ~((uint64)1 << Team);
+}
+
 bool CTeamsCore::CanKeepHook(int ClientID1, int ClientID2) const
 {
 	if(m_Team[ClientID1] == (m_IsDDRace16 ? VANILLA_TEAM_SUPER : TEAM_SUPER) || m_Team[ClientID2] == (m_IsDDRace16 ? VANILLA_TEAM_SUPER : TEAM_SUPER) || ClientID1 == ClientID2)
@@ -60,6 +78,11 @@ void CTeamsCore::Reset()
 	{
 		m_Team[i] = TEAM_FLOCK;
 		m_IsSolo[i] = false;
+	}
+	for(int i = 0; i < MAX_CLIENTS + 1; ++i)
+	{
 		m_TeamSize[i] = 0;
+		m_aMembers[i] = 0;
 	}
+	m_OccupiedRooms = 0;
 }
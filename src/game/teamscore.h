@@ -2,6 +2,8 @@
 #ifndef GAME_TEAMSCORE_H
 #define GAME_TEAMSCORE_H
 
+#include <base/math.h>
+#include <base/system.h>
 #include <engine/shared/protocol.h>
 
 enum
@@ -11,11 +13,46 @@ enum
 	VANILLA_TEAM_SUPER = VANILLA_MAX_CLIENTS
 };
 
+static_assert(MAX_CLIENTS <= 64, "client masks are 64 bits wide");
+
+// a set of client ids, iterating over it walks the set bits in ascending order
+class CClientMask
+{
+	uint64 m_Mask;
+
+public:
+	class CIterator
+	{
+		uint64 m_Mask;
+
+	public:
+		CIterator(uint64 Mask) :
+			m_Mask(Mask) {}
+		int operator*() const { return lowest_bit64(m_Mask); }
+		CIterator &operator++()
+		{
+			m_Mask &= m_Mask - 1;
+			return *this;
+		}
+		bool operator!=(const CIterator &Other) const { return m_Mask != Other.m_Mask; }
+	};
+
+	CClientMask(uint64 Mask) :
+		m_Mask(Mask) {}
+	uint64 Mask() const { return m_Mask; }
+	int Count() const { return bitcount64(m_Mask); }
+	CIterator begin() const { return CIterator(m_Mask); }
+	CIterator end() const { return CIterator(0); }
+};
+
 class CTeamsCore
 {
 	int m_Team[MAX_CLIENTS];
 	bool m_IsSolo[MAX_CLIENTS];
-	int m_TeamSize[MAX_CLIENTS];
+	// rooms go up to TEAM_SUPER
+	int m_TeamSize[MAX_CLIENTS + 1];
+	uint64 m_aMembers[MAX_CLIENTS + 1];
+	uint64 m_OccupiedRooms;
 
 public:
 	bool m_IsDDRace16;
@@ -32,6 +69,10 @@ public:
 	void Join(int ClientID, int Team);
 	void Leave(int ClientID);
 	int Count(int Team) const { return m_TeamSize[Team]; }
+	// clients that joined the room
+	CClientMask Members(int Team) const { return CClientMask(m_aMembers[Team]); }
+	// rooms below TEAM_SUPER with at least one member
+	CClientMask OccupiedRooms() const { return CClientMask(m_OccupiedRooms); }
 
 	void Reset();
 	void SetSolo(int ClientID, bool Value)
@@ -45,6 +86,10 @@ public:
 			return false;
 		return m_IsSolo[ClientID];
 	}
+
+private:
+	void AddMember(int ClientID);
+	void RemoveMember(int ClientID);
 };
 
 #endif
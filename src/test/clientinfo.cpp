@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/clientinfo.h>
+
+static void Decode(const CNetObj_ClientInfo *pInfo, char *pName, char *pClan, char *pSkin)
+{
+	IntsToStr(&pInfo->m_Name0, 4, pName);
+	IntsToStr(&pInfo->m_Clan0, 3, pClan);
+	IntsToStr(&pInfo->m_Skin0, 6, pSkin);
+}
+
+TEST(ClientInfo, Encode)
+{
+	CClientInfoCache Cache;
+	CTeeInfo TeeInfo;
+	str_copy(TeeInfo.m_SkinName, "pinky", sizeof(TeeInfo.m_SkinName));
+	TeeInfo.m_UseCustomColor = 1;
+	TeeInfo.m_ColorBody = 0x123456;
+	TeeInfo.m_ColorFeet = 0x654321;
+	char aName[16], aClan[12], aSkin[24];
+
+	const CNetObj_ClientInfo *pInfo = Cache.Get(CClientInfoCache::CLAN, "nameless tee", "clan", 276, TeeInfo);
+	Decode(pInfo, aName, aClan, aSkin);
+	EXPECT_STREQ(aName, "nameless tee");
+	EXPECT_STREQ(aClan, "clan");
+	EXPECT_STREQ(aSkin, "pinky");
+	EXPECT_EQ(pInfo->m_Country, 276);
+	EXPECT_EQ(pInfo->m_UseCustomColor, 1);
+	EXPECT_EQ(pInfo->m_ColorBody, 0x123456);
+	EXPECT_EQ(pInfo->m_ColorFeet, 0x654321);
+
+	// ready mode replaces the clan
+	Decode(Cache.Get(CClientInfoCache::READY, "nameless tee", "clan", 276, TeeInfo), aName, aClan, aSkin);
+	EXPECT_STREQ(aClan, "READY");
+	Decode(Cache.Get(CClientInfoCache::NOT_READY, "nameless tee", "clan", 276, TeeInfo), aName, aClan, aSkin);
+	EXPECT_STREQ(aClan, "");
+	Decode(Cache.Get(CClientInfoCache::CLAN, "nameless tee", "clan", 276, TeeInfo), aName, aClan, aSkin);
+	EXPECT_STREQ(aClan, "clan");
+}
+
+TEST(ClientInfo, Invalidate)
+{
+	CClientInfoCache Cache;
+	CTeeInfo TeeInfo;
+	char aName[16], aClan[12], aSkin[24];
+
+	Cache.Get(CClientInfoCache::CLAN, "old", "", -1, TeeInfo);
+
+	// nothing is encoded again until the cache is invalidated
+	Decode(Cache.Get(CClientInfoCache::CLAN, "new", "", -1, TeeInfo), aName, aClan, aSkin);
+	EXPECT_STREQ(aName, "old");
+
+	Cache.Invalidate();
+	str_copy(TeeInfo.m_SkinName, "bluekitty", sizeof(TeeInfo.m_SkinName));
+	Decode(Cache.Get(CClientInfoCache::CLAN, "new", "", -1, TeeInfo), aName, aClan, aSkin);
+	EXPECT_STREQ(aName, "new");
+	EXPECT_STREQ(aSkin, "bluekitty");
+}
@@ -0,0 +1,77 @@
+#include "gamecore_replay.h"
+#include <gtest/gtest.h>
+
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+static const char *TEST_MAP = "data/maps/mega_std_collection.map";
+
+static int Intersect(CCollision *pCollision, int Type, vec2 From, vec2 To)
+{
+	switch(Type)
+	{
+	case CLineOfSight::LOS_LINE: return pCollision->IntersectLine(From, To, 0, 0);
+	case CLineOfSight::LOS_NOLASER: return pCollision->IntersectNoLaser(From, To, 0, 0);
+	default: return pCollision->IntersectNoLaserNW(From, To, 0, 0);
+	}
+}
+
+TEST(Collision, LineOfSight)
+{
+	CGamecoreReplay Replay;
+	ASSERT_TRUE(Replay.Load(TEST_MAP));
+	CCollision *pCollision = Replay.Collision();
+
+	const float Range = 700.0f;
+	const float Width = pCollision->GetWidth() * 32.0f;
+	const float Height = pCollision->GetHeight() * 32.0f;
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	for(int Type = CLineOfSight::LOS_LINE; Type <= CLineOfSight::LOS_NOLASER_NW; Type++)
+	{
+		for(int i = 0; i < 100; i++)
+		{
+			CLineOfSight LineOfSight(Type);
+			vec2 From = vec2(Prng.RandomBits() % 32768 / 32768.0f * Width, Prng.RandomBits() % 32768 / 32768.0f * Height);
+			for(int j = 0; j < 500; j++)
+			{
+				// ask twice for most tiles, once to fill the cache and once to use it
+				vec2 To = From + vec2((int)(Prng.RandomBits() % 1601) - 800, (int)(Prng.RandomBits() % 1601) - 800) * (j % 2 ? 0.5f : 1.0f);
+				ASSERT_EQ(LineOfSight.Blocked(pCollision, From, To, Range), Intersect(pCollision, Type, From, To) != 0)
+					<< "type=" << Type << " from=" << From.x << "," << From.y << " to=" << To.x << "," << To.y;
+			}
+		}
+	}
+}
+
+TEST(Collision, LineOfSightInvalidation)
+{
+	CGamecoreReplay Replay;
+	ASSERT_TRUE(Replay.Load(TEST_MAP));
+	CCollision *pCollision = Replay.Collision();
+
+	// find a free view along a few tiles of air
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	vec2 From, To;
+	bool Found = false;
+	for(int i = 0; i < 100000 && !Found; i++)
+	{
+		From = vec2(Prng.RandomBits() % (pCollision->GetWidth() - 8) * 32 + 16, Prng.RandomBits() % pCollision->GetHeight() * 32 + 16);
+		To = From + vec2(6 * 32, 0);
+		Found = !pCollision->IntersectLine(From, To, 0, 0);
+	}
+	ASSERT_TRUE(Found);
+
+	CLineOfSight LineOfSight(CLineOfSight::LOS_LINE);
+	EXPECT_FALSE(LineOfSight.Blocked(pCollision, From, To, 700.0f));
+
+	vec2 Middle = (From + To) / 2.0f;
+	int OldIndex = pCollision->GetTile(round_to_int(Middle.x), round_to_int(Middle.y));
+	pCollision->SetCollisionAt(Middle.x, Middle.y, TILE_SOLID);
+	EXPECT_TRUE(LineOfSight.Blocked(pCollision, From, To, 700.0f));
+	pCollision->SetCollisionAt(Middle.x, Middle.y, OldIndex);
+	EXPECT_FALSE(LineOfSight.Blocked(pCollision, From, To, 700.0f));
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+
+#include <atomic>
+
+struct CTestResult : ISqlResult
+{
+	int m_Value = -1;
+};
+
+struct CTestData : ISqlData
+{
+	CTestData(std::shared_ptr<ISqlResult> pResult, int Value) :
+		ISqlData(std::move(pResult)),
+		m_Value(Value)
+	{
+	}
+	int m_Value;
+};
+
+static std::atomic_bool s_Blocked(false);
+
+static bool TestRead(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const CTestData *pData = dynamic_cast<const CTestData *>(pGameData);
+	CTestResult *pResult = dynamic_cast<CTestResult *>(pGameData->m_pResult.get());
+	while(s_Blocked.load())
+		thread_sleep(1000);
+
+	if(pSqlServer->PrepareStatement("SELECT ? * 2", pError, ErrorSize))
+		return true;
+	pSqlServer->BindInt(1, pData->m_Value);
+	bool End;
+	if(pSqlServer->Step(&End, pError, ErrorSize) || End)
+		return true;
+	pResult->m_Value = pSqlServer->GetInt(1);
+	return false;
+}
+
+static bool TestWrite(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	const CTestData *pData = dynamic_cast<const CTestData *>(pGameData);
+	CTestResult *pResult = dynamic_cast<CTestResult *>(pGameData->m_pResult.get());
+	int NumUpdated;
+	if(pSqlServer->PrepareStatement("CREATE TABLE IF NOT EXISTS test (Value INTEGER)", pError, ErrorSize) ||
+		pSqlServer->ExecuteUpdate(&NumUpdated, pError, ErrorSize))
+		return true;
+	if(pSqlServer->PrepareStatement("INSERT INTO test (Value) VALUES (?)", pError, ErrorSize))
+		return true;
+	pSqlServer->BindInt(1, pData->m_Value);
+	if(pSqlServer->ExecuteUpdate(&NumUpdated, pError, ErrorSize))
+		return true;
+	if(pSqlServer->PrepareStatement("SELECT COUNT(*) FROM test", pError, ErrorSize))
+		return true;
+	bool End;
+	if(pSqlServer->Step(&End, pError, ErrorSize) || End)
+		return true;
+	pResult->m_Value = pSqlServer->GetInt(1);
+	return false;
+}
+
+static void WaitForCompletion(const std::vector<std::shared_ptr<CTestResult>> &vpResults)
+{
+	for(const auto &pResult : vpResults)
+		while(!pResult->m_Completed.load())
+			thread_sleep(1000);
+}
+
+TEST(ConnectionPool, Flood)
+{
+	CDbConnectionPool Pool;
+	Pool.RegisterDatabase(std::unique_ptr<IDbConnection>(CreateSqliteConnection(":memory:", false)), CDbConnectionPool::READ);
+	Pool.RegisterDatabase(std::unique_ptr<IDbConnection>(CreateSqliteConnection(":memory:", false)), CDbConnectionPool::WRITE);
+	Pool.Start(4, 1, 64);
+
+	std::vector<std::shared_ptr<CTestResult>> vpReads;
+	std::vector<std::shared_ptr<CTestResult>> vpWrites;
+	for(int i = 0; i < 2000; i++)
+	{
+		// back off while saturated, the only producer can't overflow the queue then
+		while(Pool.IsSaturated(CDbConnectionPool::READ) || Pool.IsSaturated(CDbConnectionPool::WRITE))
+			thread_yield();
+
+		vpReads.emplace_back(new CTestResult());
+		ASSERT_TRUE(Pool.Execute(TestRead, std::unique_ptr<const ISqlData>(new CTestData(vpReads.back(), i)), "test read"));
+		if(i % 4 == 0)
+		{
+			vpWrites.emplace_back(new CTestResult());
+			ASSERT_TRUE(Pool.ExecuteWrite(TestWrite, std::unique_ptr<const ISqlData>(new CTestData(vpWrites.back(), i)), "test write"));
+		}
+	}
+	WaitForCompletion(vpReads);
+	WaitForCompletion(vpWrites);
+	Pool.OnShutdown();
+
+	for(int i = 0; i < (int)vpReads.size(); i++)
+	{
+		EXPECT_TRUE(vpReads[i]->m_Success);
+		EXPECT_EQ(vpReads[i]->m_Value, i * 2);
+	}
+	// a single write worker keeps the order of the writes
+	for(int i = 0; i < (int)vpWrites.size(); i++)
+	{
+		EXPECT_TRUE(vpWrites[i]->m_Success);
+		EXPECT_EQ(vpWrites[i]->m_Value, i + 1);
+	}
+	EXPECT_EQ(Pool.QueueLength(CDbConnectionPool::READ), 0);
+}
+
+TEST(ConnectionPool, Backpressure)
+{
+	CDbConnectionPool Pool;
+	Pool.RegisterDatabase(std::unique_ptr<IDbConnection>(CreateSqliteConnection(":memory:", false)), CDbConnectionPool::READ);
+	Pool.Start(1, 1, 16);
+
+	// keep the only read worker busy with the first task
+	s_Blocked.store(true);
+	std::vector<std::shared_ptr<CTestResult>> vpResults;
+	vpResults.emplace_back(new CTestResult());
+	ASSERT_TRUE(Pool.Execute(TestRead, std::unique_ptr<const ISqlData>(new CTestData(vpResults.back(), 0)), "test read"));
+	while(Pool.QueueLength(CDbConnectionPool::READ) > 0)
+		thread_yield();
+
+	for(int i = 1; i <= 16; i++)
+	{
+		EXPECT_EQ(Pool.IsSaturated(CDbConnectionPool::READ), i > 13);
+		vpResults.emplace_back(new CTestResult());
+		EXPECT_TRUE(Pool.Execute(TestRead, std::unique_ptr<const ISqlData>(new CTestData(vpResults.back(), i)), "test read"));
+	}
+	EXPECT_EQ(Pool.QueueLength(CDbConnectionPool::READ), 16);
+	EXPECT_TRUE(Pool.IsSaturated(CDbConnectionPool::READ));
+
+	// a full queue drops the task instead of overwriting queued ones, its
+	// result completes as failed right away
+	std::shared_ptr<CTestResult> pDropped(new CTestResult());
+	EXPECT_FALSE(Pool.Execute(TestRead, std::unique_ptr<const ISqlData>(new CTestData(pDropped, 17)), "test read"));
+	EXPECT_TRUE(pDropped->m_Completed.load());
+	EXPECT_FALSE(pDropped->m_Success);
+	// the write queue is independent
+	EXPECT_EQ(Pool.QueueLength(CDbConnectionPool::WRITE), 0);
+
+	s_Blocked.store(false);
+	WaitForCompletion(vpResults);
+	Pool.OnShutdown();
+	for(int i = 0; i < (int)vpResults.size(); i++)
+	{
+		EXPECT_TRUE(vpResults[i]->m_Success);
+		EXPECT_EQ(vpResults[i]->m_Value, i * 2);
+	}
+	EXPECT_EQ(pDropped->m_Value, -1);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/console.h>
+
+#include <deque>
+#include <string>
+
+static void StoreInteger(IConsole::IResult *pResult, void *pUserData)
+{
+	*(int *)pUserData = pResult->NumArguments() ? pResult->GetInteger(0) : -1;
+}
+
+TEST(Console, FindCommand)
+{
+	CConsole Console(CFGFLAG_SERVER);
+	int Value = 0;
+	Console.Register("sv_test", "?i", CFGFLAG_SERVER, StoreInteger, &Value, "");
+
+	Console.ExecuteLine("SV_Test 5");
+	EXPECT_EQ(Value, 5);
+	EXPECT_TRUE(Console.GetCommandInfo("sv_TEST", CFGFLAG_SERVER, false));
+	EXPECT_FALSE(Console.GetCommandInfo("sv_test", CFGFLAG_CHAT, false));
+	EXPECT_FALSE(Console.GetCommandInfo("sv_test", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(Console.GetCommandInfo("sv_tes", CFGFLAG_SERVER, false));
+
+	// many more commands than hash buckets
+	std::deque<std::string> vNames;
+	std::deque<int> vValues;
+	for(int i = 0; i < 2000; i++)
+	{
+		vNames.push_back("cmd_" + std::to_string(i));
+		vValues.push_back(0);
+		Console.Register(vNames.back().c_str(), "?i", CFGFLAG_SERVER, StoreInteger, &vValues.back(), "");
+	}
+	for(int i = 0; i < 2000; i++)
+	{
+		Console.ExecuteLine((vNames[i] + " " + std::to_string(i + 1)).c_str());
+		EXPECT_EQ(vValues[i], i + 1);
+	}
+
+	// registering again replaces the command
+	int Other = 0;
+	Console.Register("SV_TEST", "?i", CFGFLAG_SERVER, StoreInteger, &Other, "");
+	Console.ExecuteLine("sv_test 7");
+	EXPECT_EQ(Value, 5);
+	EXPECT_EQ(Other, 7);
+}
+
+TEST(Console, TempCommands)
+{
+	CConsole Console(CFGFLAG_SERVER);
+	Console.RegisterTemp("temp_a", "", CFGFLAG_SERVER, "");
+	Console.RegisterTemp("temp_b", "", CFGFLAG_SERVER, "");
+	EXPECT_TRUE(Console.GetCommandInfo("TEMP_A", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(Console.GetCommandInfo("temp_a", CFGFLAG_SERVER, false));
+
+	Console.DeregisterTemp("temp_a");
+	EXPECT_FALSE(Console.GetCommandInfo("temp_a", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(Console.GetCommandInfo("temp_b", CFGFLAG_SERVER, true));
+
+	// the recycled command gets the new name
+	Console.RegisterTemp("temp_c", "", CFGFLAG_SERVER, "");
+	EXPECT_TRUE(Console.GetCommandInfo("temp_c", CFGFLAG_SERVER, true));
+
+	Console.DeregisterTempAll();
+	EXPECT_FALSE(Console.GetCommandInfo("temp_b", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(Console.GetCommandInfo("temp_c", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(Console.GetCommandInfo("echo", CFGFLAG_SERVER, false));
+}
+
+static int CountCommands(CConsole *pConsole, int FlagMask)
+{
+	int Count = 0;
+	for(const IConsole::CCommandInfo *pInfo = pConsole->FirstCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask); pInfo; pInfo = pInfo->NextCommandInfo(IConsole::ACCESS_LEVEL_ADMIN, FlagMask))
+		Count++;
+	return Count;
+}
+
+TEST(Console, CommandTable)
+{
+	CConsole First(CFGFLAG_INSTANCE);
+	int FirstValue = 0;
+	First.Register("warmup", "?i", CFGFLAG_CHAT | CFGFLAG_INSTANCE, StoreInteger, &FirstValue, "");
+	First.Register("laser_jump", "?i", CFGFLAG_CHAT | CFGFLAG_INSTANCE, StoreInteger, &FirstValue, "");
+	std::shared_ptr<const CConsole::CCommandTable> pTable = First.CommandTable();
+	EXPECT_EQ(First.CommandTable(), pTable);
+
+	// the commands of the table are there once registered
+	CConsole Second(CFGFLAG_INSTANCE, pTable);
+	int SecondValue = 0;
+	EXPECT_FALSE(Second.GetCommandInfo("warmup", CFGFLAG_INSTANCE, false));
+	EXPECT_EQ(CountCommands(&Second, CFGFLAG_INSTANCE), CountCommands(&First, CFGFLAG_INSTANCE) - 2);
+	Second.Register("warmup", "?i", CFGFLAG_CHAT | CFGFLAG_INSTANCE, StoreInteger, &SecondValue, "");
+	EXPECT_EQ(Second.CommandTable(), pTable);
+	Second.ExecuteLine("warmup 3");
+	Second.ExecuteLine("laser_jump 1");
+	EXPECT_EQ(FirstValue, 0);
+	EXPECT_EQ(SecondValue, 3);
+	EXPECT_EQ(Second.GetCommandInfo("warmup", CFGFLAG_CHAT, false)->GetAccessLevel(), (int)IConsole::ACCESS_LEVEL_USER);
+
+	// new commands make a new table with all of them
+	Second.Register("say", "?r", CFGFLAG_INSTANCE, StoreInteger, &SecondValue, "");
+	std::shared_ptr<const CConsole::CCommandTable> pNewTable = Second.CommandTable();
+	EXPECT_NE(pNewTable, pTable);
+	EXPECT_EQ(pNewTable->m_vEntries.size(), pTable->m_vEntries.size() + 1);
+
+	CConsole Third(CFGFLAG_INSTANCE, pNewTable);
+	int ThirdValue = 0;
+	Third.Register("laser_jump", "?i", CFGFLAG_CHAT | CFGFLAG_INSTANCE, StoreInteger, &ThirdValue, "");
+	Third.ExecuteLine("laser_jump 1; say");
+	EXPECT_EQ(ThirdValue, 1);
+	EXPECT_EQ(CountCommands(&Third, CFGFLAG_INSTANCE), CountCommands(&First, CFGFLAG_INSTANCE) - 1);
+	Third.ExecuteLine("echo hello");
+}
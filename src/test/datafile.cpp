@@ -5,6 +5,8 @@
 #include <engine/storage.h>
 #include <game/mapitems_ex.h>
 
+#include <vector>
+
 TEST(Datafile, ExtendedType)
 {
 	IStorage *pStorage = CreateLocalStorage();
@@ -59,3 +61,72 @@ TEST(Datafile, ExtendedType)
 
 	delete pStorage;
 }
+
+TEST(Datafile, Data)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	// small ones share the decompression arena, the large one gets its own
+	// allocation
+	const int aSizes[] = {16, 1000, 4 * 1024, 1024 * 1024, 3};
+	const int NumData = sizeof(aSizes) / sizeof(aSizes[0]);
+	std::vector<std::vector<unsigned char>> vvData(NumData);
+	for(int i = 0; i < NumData; i++)
+	{
+		vvData[i].resize(aSizes[i]);
+		for(int j = 0; j < aSizes[i]; j++)
+			vvData[i][j] = (i * 31 + j * 7) ^ (j >> 8);
+	}
+
+	{
+		CDataFileWriter Writer;
+		Writer.Open(pStorage, Info.m_aFilename);
+		for(auto &vData : vvData)
+			Writer.AddData(vData.size(), vData.data());
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage, Info.m_aFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), NumData);
+		for(int Round = 0; Round < 2; Round++)
+		{
+			for(int i = 0; i < NumData; i++)
+			{
+				ASSERT_EQ(Reader.GetDataSize(i), aSizes[i]);
+				const unsigned char *pData = (const unsigned char *)Reader.GetData(i);
+				ASSERT_TRUE(pData);
+				EXPECT_EQ(mem_comp(pData, vvData[i].data(), aSizes[i]), 0) << "index=" << i;
+				// decompressed once only
+				EXPECT_EQ(Reader.GetData(i), pData);
+			}
+
+			// unloaded data is loaded again on the next access
+			for(int i = 0; i < NumData; i++)
+				Reader.UnloadData(i);
+		}
+		EXPECT_EQ(Reader.GetData(NumData), nullptr);
+		EXPECT_EQ(Reader.GetData(-1), nullptr);
+
+		// the file contents stay untouched by modifications of the data
+		unsigned char *pData = (unsigned char *)Reader.GetData(0);
+		ASSERT_TRUE(pData);
+		IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+		ASSERT_TRUE(File);
+		std::vector<unsigned char> vFile(io_length(File));
+		io_read(File, vFile.data(), vFile.size());
+		io_close(File);
+		mem_zero(pData, aSizes[0]);
+		ASSERT_EQ(Reader.FileSize(), vFile.size());
+		EXPECT_EQ(mem_comp(Reader.FileData(), vFile.data(), vFile.size()), 0);
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+
+	delete pStorage;
+}
@@ -0,0 +1,214 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+#include <game/generated/protocol.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+static const int NUM_TICKS = SERVER_TICK_SPEED * 20;
+
+class CDemoTest
+{
+public:
+	std::unique_ptr<CSnapshotDelta> m_pDelta;
+	CDemoRecorder m_Recorder;
+	int m_NumItems;
+
+	CDemoTest(CDemoWriter *pWriter, int NumItems) :
+		m_pDelta(new CSnapshotDelta()),
+		m_Recorder(m_pDelta.get(), false, pWriter),
+		m_NumItems(NumItems)
+	{
+	}
+
+	bool Start(IStorage *pStorage, const char *pFilename)
+	{
+		SHA256_DIGEST Sha256 = SHA256_ZEROED;
+		unsigned char aMapData[64] = {0};
+		return m_Recorder.Start(pStorage, nullptr, pFilename, "0.6 626fce9a778df4d4", "test", &Sha256, 0, "server", sizeof(aMapData), aMapData) == 0;
+	}
+
+	void Record(int FromTick, int ToTick)
+	{
+		alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+		CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+		std::unique_ptr<CSnapshotBuilder> pBuilder(new CSnapshotBuilder());
+		for(int Tick = FromTick; Tick < ToTick; Tick++)
+		{
+			pBuilder->Init();
+			for(int i = 0; i < m_NumItems; i++)
+			{
+				// most characters move every tick, some stand still
+				CNetObj_Character *pChar = (CNetObj_Character *)pBuilder->NewItem(NETOBJTYPE_CHARACTER, i, sizeof(CNetObj_Character));
+				mem_zero(pChar, sizeof(*pChar));
+				pChar->m_X = i % 4 == 0 ? i * 32 : i * 32 + Tick * 3;
+				pChar->m_Y = (Tick * 7 + i * 13) % 1000;
+				pChar->m_Tick = Tick;
+				pChar->m_Health = i % 10;
+			}
+			int Size = pBuilder->Finish(pSnap);
+			m_Recorder.RecordSnapshot(Tick, pSnap, Size);
+
+			if(Tick % 7 == 0)
+			{
+				char aMsg[32];
+				str_format(aMsg, sizeof(aMsg), "message %d", Tick);
+				m_Recorder.RecordMessage(aMsg, str_length(aMsg) + 1);
+			}
+			if(Tick % (SERVER_TICK_SPEED * 3) == 0)
+				m_Recorder.AddDemoMarker();
+		}
+	}
+};
+
+static std::string ReadFile(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	EXPECT_TRUE(File);
+	if(!File)
+		return "";
+	std::string Content(io_length(File), '\0');
+	io_read(File, &Content[0], Content.size());
+	io_close(File);
+	return Content;
+}
+
+TEST(Demo, AsyncIdentical)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+	char aSyncFilename[128];
+	char aAsyncFilename[128];
+	str_format(aSyncFilename, sizeof(aSyncFilename), "%s.sync", Info.m_aFilename);
+	str_format(aAsyncFilename, sizeof(aAsyncFilename), "%s.async", Info.m_aFilename);
+
+	CDemoTest Sync(nullptr, 32);
+	ASSERT_TRUE(Sync.Start(pStorage, aSyncFilename));
+	Sync.Record(100, 100 + NUM_TICKS);
+	EXPECT_EQ(Sync.m_Recorder.Stop(), 0);
+
+	{
+		CDemoWriter Writer;
+		Writer.Init();
+		CDemoTest Async(&Writer, 32);
+		ASSERT_TRUE(Async.Start(pStorage, aAsyncFilename));
+		Async.Record(100, 100 + NUM_TICKS);
+		EXPECT_EQ(Async.m_Recorder.Stop(), 0);
+		EXPECT_FALSE(Async.m_Recorder.IsRecording());
+		Writer.Flush();
+		EXPECT_EQ(Writer.QueuedBytes(), 0);
+		EXPECT_EQ(Async.m_Recorder.NumDropped(), 0);
+	}
+
+	std::string SyncDemo = ReadFile(pStorage, aSyncFilename);
+	std::string AsyncDemo = ReadFile(pStorage, aAsyncFilename);
+	ASSERT_GT(SyncDemo.size(), sizeof(CDemoHeader));
+	ASSERT_EQ(SyncDemo.size(), AsyncDemo.size());
+	// the recording time can differ between both
+	const size_t TimestampOffset = offsetof(CDemoHeader, m_aTimestamp);
+	SyncDemo.replace(TimestampOffset, sizeof(CDemoHeader::m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp), '\0');
+	AsyncDemo.replace(TimestampOffset, sizeof(CDemoHeader::m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp), '\0');
+	EXPECT_TRUE(SyncDemo == AsyncDemo);
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(aSyncFilename, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(aAsyncFilename, IStorage::TYPE_SAVE);
+	}
+	delete pStorage;
+}
+
+TEST(Demo, AsyncOverflow)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	{
+		// nothing drains the queue without the thread until it's flushed
+		CDemoWriter Writer(16 * 1024);
+		CDemoTest Test(&Writer, 64);
+		ASSERT_TRUE(Test.Start(pStorage, Info.m_aFilename));
+		Test.Record(100, 100 + NUM_TICKS / 2);
+		EXPECT_TRUE(Test.m_Recorder.IsKeyframesOnly());
+		int NumDropped = Test.m_Recorder.NumDropped();
+		EXPECT_GT(NumDropped, 0);
+		EXPECT_LE(Writer.QueuedBytes(), 16 * 1024);
+
+		// recording goes back to deltas with the next keyframe once the
+		// writer caught up
+		for(int Tick = 100 + NUM_TICKS / 2; Tick < 100 + NUM_TICKS; Tick += 5)
+		{
+			Writer.Flush();
+			Test.Record(Tick, Tick + 5);
+		}
+		EXPECT_FALSE(Test.m_Recorder.IsKeyframesOnly());
+		EXPECT_EQ(Test.m_Recorder.NumDropped(), NumDropped);
+		EXPECT_EQ(Test.m_Recorder.Stop(), 0);
+	}
+
+	// the dropped chunks leave a demo that still parses to the end
+	CSnapshotDelta Delta;
+	CDemoPlayer Player(&Delta);
+	ASSERT_EQ(Player.Load(pStorage, nullptr, Info.m_aFilename, IStorage::TYPE_SAVE), 0);
+	EXPECT_GT(Player.Info()->m_SeekablePoints, 1);
+	EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 100);
+	EXPECT_EQ(Player.BaseInfo()->m_LastTick, 100 + NUM_TICKS - 1);
+	Player.Stop();
+
+	if(!HasFailure())
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	delete pStorage;
+}
+
+TEST(Demo, AsyncRestartQueued)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+	char aSyncFilename[128];
+	str_format(aSyncFilename, sizeof(aSyncFilename), "%s.sync", Info.m_aFilename);
+
+	CDemoTest Sync(nullptr, 16);
+	ASSERT_TRUE(Sync.Start(pStorage, aSyncFilename));
+	Sync.Record(100, 100 + NUM_TICKS / 4);
+	EXPECT_EQ(Sync.m_Recorder.Stop(), 0);
+
+	{
+		// nothing is written until the flush, the second recording starts
+		// while the first one is still queued
+		CDemoWriter Writer;
+		CDemoTest Async(&Writer, 16);
+		ASSERT_TRUE(Async.Start(pStorage, Info.m_aFilename));
+		Async.Record(100, 100 + NUM_TICKS);
+		EXPECT_EQ(Async.m_Recorder.Stop(), 0);
+		int QueuedBytes = Writer.QueuedBytes();
+		EXPECT_GT(QueuedBytes, 0);
+
+		ASSERT_TRUE(Async.Start(pStorage, Info.m_aFilename));
+		EXPECT_EQ(Writer.QueuedBytes(), QueuedBytes);
+		Async.Record(100, 100 + NUM_TICKS / 4);
+		EXPECT_EQ(Async.m_Recorder.Stop(), 0);
+		Writer.Flush();
+		EXPECT_EQ(Writer.QueuedBytes(), 0);
+	}
+
+	std::string SyncDemo = ReadFile(pStorage, aSyncFilename);
+	std::string AsyncDemo = ReadFile(pStorage, Info.m_aFilename);
+	ASSERT_EQ(SyncDemo.size(), AsyncDemo.size());
+	const size_t TimestampOffset = offsetof(CDemoHeader, m_aTimestamp);
+	SyncDemo.replace(TimestampOffset, sizeof(CDemoHeader::m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp), '\0');
+	AsyncDemo.replace(TimestampOffset, sizeof(CDemoHeader::m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp), '\0');
+	EXPECT_TRUE(SyncDemo == AsyncDemo);
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(aSyncFilename, IStorage::TYPE_SAVE);
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+	delete pStorage;
+}
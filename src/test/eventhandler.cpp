@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <game/prng.h>
+#include <game/server/eventhandler.h>
+
+#include <vector>
+
+TEST(EventHandler, PositionIndex)
+{
+	CEventPositionIndex Index;
+	int aX[] = {500, -20, 1800, 500, 3000, 0};
+	for(int i = 0; i < 6; i++)
+		Index.Add(i, aX[i]);
+	Index.Sort();
+
+	// both ends of the range are included, events at the same x keep their order
+	int First;
+	int End = Index.Find(0, 1800, &First);
+	std::vector<int> vEvents;
+	for(int i = First; i < End; i++)
+		vEvents.push_back(Index.Event(i));
+	EXPECT_EQ(vEvents, std::vector<int>({5, 0, 3, 2}));
+
+	End = Index.Find(501, 1799, &First);
+	EXPECT_EQ(First, End);
+	End = Index.Find(-5000, 5000, &First);
+	EXPECT_EQ(First, 0);
+	EXPECT_EQ(End, 6);
+
+	Index.Clear();
+	EXPECT_EQ(Index.Num(), 0);
+	End = Index.Find(-5000, 5000, &First);
+	EXPECT_EQ(First, End);
+}
+
+TEST(EventHandler, PositionIndexRanges)
+{
+	// the same events as clipping every event of the world
+	CEventPositionIndex Index;
+	std::vector<int> vX;
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	for(int i = 0; i < CEventPositionIndex::MAX_EVENTS; i++)
+	{
+		vX.push_back((int)(Prng.RandomBits() % 10000) - 2000);
+		Index.Add(i, vX.back());
+	}
+	Index.Sort();
+
+	for(int MinX = -3000; MinX < 9000; MinX += 700)
+	{
+		int MaxX = MinX + 3600;
+		int First;
+		int End = Index.Find(MinX, MaxX, &First);
+		std::vector<bool> vFound(vX.size(), false);
+		for(int i = First; i < End; i++)
+			vFound[Index.Event(i)] = true;
+		for(unsigned i = 0; i < vX.size(); i++)
+			EXPECT_EQ(vFound[i], vX[i] >= MinX && vX[i] <= MaxX) << "event " << i << " at " << vX[i];
+	}
+}
@@ -0,0 +1,70 @@
+#include "gamecore_replay.h"
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/storage.h>
+
+static const char *TEST_MAP = "data/maps/mega_std_collection.map";
+
+// the broad phase must not change the physics, compare against the full loops
+static void ExpectSameAsFullLoops(int NumCharacters, int PerSpawn, int NumTicks)
+{
+	CGamecoreReplay Replay;
+	ASSERT_TRUE(Replay.Load(TEST_MAP));
+
+	SHA256_DIGEST Culled = Replay.Run(NumCharacters, PerSpawn, NumTicks);
+	EXPECT_TRUE(Replay.Run(NumCharacters, PerSpawn, NumTicks) == Culled);
+	Replay.SetCulling(false);
+	EXPECT_TRUE(Replay.Run(NumCharacters, PerSpawn, NumTicks) == Culled);
+}
+
+TEST(Gamecore, ReplayDeterminism)
+{
+	ExpectSameAsFullLoops(32, 8, 1000);
+}
+
+TEST(Gamecore, ReplayDeterminismFull)
+{
+	ExpectSameAsFullLoops(MAX_CLIENTS, 2, 1000);
+}
+
+TEST(Gamecore, RecordedInput)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	CGamecoreReplay Replay;
+	ASSERT_TRUE(Replay.Load(TEST_MAP));
+
+	CInputStream Recorded;
+	SHA256_DIGEST Live = Replay.Run(16, 4, 500, &Recorded);
+	ASSERT_TRUE(Recorded.Save(pStorage, Info.m_aFilename));
+
+	CInputStream Loaded;
+	ASSERT_TRUE(Loaded.Load(pStorage, Info.m_aFilename));
+	EXPECT_EQ(Loaded.m_NumCharacters, 16);
+	EXPECT_EQ(Loaded.NumTicks(), 500);
+	EXPECT_TRUE(Replay.Replay(Loaded, 4) == Live);
+	EXPECT_TRUE(Replay.Replay(Loaded, 4) == Live);
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+
+	delete pStorage;
+}
+
+TEST(Gamecore, CollisionRays)
+{
+	CGamecoreReplay Replay;
+	ASSERT_TRUE(Replay.Load(TEST_MAP));
+	CGamecoreReplay Other;
+	ASSERT_TRUE(Other.Load(TEST_MAP));
+
+	// nothing carries over from earlier queries
+	SHA256_DIGEST Rays = Replay.CollisionRays(10000);
+	EXPECT_TRUE(Replay.CollisionRays(10000) == Rays);
+	EXPECT_TRUE(Other.CollisionRays(10000) == Rays);
+	EXPECT_FALSE(Other.CollisionRays(5000) == Rays);
+}
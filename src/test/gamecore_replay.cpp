@@ -0,0 +1,219 @@
+#include "gamecore_replay.h"
+
+#include <base/hash_ctxt.h>
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+static const char INPUT_STREAM_MAGIC[4] = {'I', 'N', 'P', '1'};
+
+bool CInputStream::Save(IStorage *pStorage, const char *pFilename) const
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	int aHeader[2] = {m_NumCharacters, NumTicks()};
+	io_write(File, INPUT_STREAM_MAGIC, sizeof(INPUT_STREAM_MAGIC));
+	io_write(File, aHeader, sizeof(aHeader));
+	if(!m_vInputs.empty())
+		io_write(File, m_vInputs.data(), m_vInputs.size() * sizeof(CNetObj_PlayerInput));
+	io_close(File);
+	return true;
+}
+
+bool CInputStream::Load(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+		return false;
+
+	char aMagic[sizeof(INPUT_STREAM_MAGIC)];
+	int aHeader[2];
+	bool Valid = io_read(File, aMagic, sizeof(aMagic)) == sizeof(aMagic) &&
+		     mem_comp(aMagic, INPUT_STREAM_MAGIC, sizeof(aMagic)) == 0 &&
+		     io_read(File, aHeader, sizeof(aHeader)) == sizeof(aHeader) &&
+		     aHeader[0] > 0 && aHeader[0] <= MAX_CLIENTS && aHeader[1] >= 0;
+	if(Valid)
+	{
+		m_NumCharacters = aHeader[0];
+		m_vInputs.resize((size_t)aHeader[0] * aHeader[1]);
+		unsigned Size = m_vInputs.size() * sizeof(CNetObj_PlayerInput);
+		Valid = io_read(File, m_vInputs.data(), Size) == Size;
+	}
+	io_close(File);
+	return Valid;
+}
+
+CGamecoreReplay::CGamecoreReplay()
+{
+	m_pKernel = IKernel::Create();
+	m_pMap = CreateEngineMap();
+	m_pKernel->RegisterInterface(CreateLocalStorage());
+	m_pKernel->RegisterInterface(m_pMap);
+	m_pKernel->RegisterInterface(static_cast<IMap *>(m_pMap), false);
+}
+
+CGamecoreReplay::~CGamecoreReplay()
+{
+	delete m_pKernel;
+}
+
+bool CGamecoreReplay::Load(const char *pMapName)
+{
+	if(!m_pMap->Load(pMapName))
+		return false;
+	m_Layers.Init(m_pKernel);
+	m_Collision.Init(&m_Layers, nullptr);
+
+	CMapItemLayerTilemap *pGameLayer = m_Layers.GameLayer();
+	const CTile *pTiles = (const CTile *)m_pMap->GetData(pGameLayer->m_Data);
+	for(int y = 0; y < pGameLayer->m_Height; y++)
+		for(int x = 0; x < pGameLayer->m_Width; x++)
+			if(pTiles[y * pGameLayer->m_Width + x].m_Index - ENTITY_OFFSET == ENTITY_SPAWN)
+				m_vSpawns.push_back(vec2(x * 32.0f + 16.0f, y * 32.0f + 16.0f));
+	return !m_vSpawns.empty();
+}
+
+void CGamecoreReplay::Spawn(int NumCharacters, int PerSpawn)
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_World.SetCharacter(i, 0);
+
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		// Init() leaves some members alone, start from a clean core so runs are repeatable
+		CCharacterCore *pCore = &m_aCores[i];
+		*pCore = CCharacterCore();
+		pCore->Init(&m_World, &m_Collision, &m_Teams);
+		pCore->m_Id = i;
+		pCore->m_Pos = m_vSpawns[(i / PerSpawn) % m_vSpawns.size()] + vec2((i % PerSpawn) * 6.0f - 12.0f, 0.0f);
+		m_World.SetCharacter(i, pCore);
+	}
+}
+
+// deterministic pseudo random input, aiming at other characters to provoke hooks
+void CGamecoreReplay::GenerateInput(int Tick, int NumCharacters, CPrng *pPrng)
+{
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		CNetObj_PlayerInput *pInput = &m_aCores[i].m_Input;
+		if(Tick % 10 == 0)
+			pInput->m_Direction = (int)(pPrng->RandomBits() % 3) - 1;
+		pInput->m_Jump = pPrng->RandomBits() % 8 == 0;
+		if(Tick % 15 == 0)
+			pInput->m_Hook = pPrng->RandomBits() % 2;
+		const CCharacterCore *pTarget = &m_aCores[pPrng->RandomBits() % NumCharacters];
+		pInput->m_TargetX = (int)(pTarget->m_Pos.x - m_aCores[i].m_Pos.x) + (int)(pPrng->RandomBits() % 64) - 32;
+		pInput->m_TargetY = (int)(pTarget->m_Pos.y - m_aCores[i].m_Pos.y) + (int)(pPrng->RandomBits() % 64) - 32;
+		if(pInput->m_TargetX == 0 && pInput->m_TargetY == 0)
+			pInput->m_TargetY = -1;
+	}
+}
+
+// same order as the server: all cores tick, then all of them move
+void CGamecoreReplay::DoTick(int NumCharacters)
+{
+	for(int i = 0; i < NumCharacters; i++)
+		m_aCores[i].Tick(true);
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		m_aCores[i].AddDragVelocity();
+		m_aCores[i].ResetDragVelocity();
+		m_aCores[i].Move();
+		m_aCores[i].Quantize();
+	}
+}
+
+static void HashCores(SHA256_CTX *pCtxt, CCharacterCore *pCores, int NumCharacters)
+{
+	for(int i = 0; i < NumCharacters; i++)
+	{
+		// Write() leaves the tick alone
+		CNetObj_CharacterCore Core;
+		mem_zero(&Core, sizeof(Core));
+		pCores[i].Write(&Core);
+		sha256_update(pCtxt, &Core, sizeof(Core));
+	}
+}
+
+SHA256_DIGEST CGamecoreReplay::Run(int NumCharacters, int PerSpawn, int NumTicks, CInputStream *pRecord)
+{
+	Spawn(NumCharacters, PerSpawn);
+	if(pRecord)
+	{
+		pRecord->m_NumCharacters = NumCharacters;
+		pRecord->m_vInputs.clear();
+		pRecord->m_vInputs.reserve((size_t)NumCharacters * NumTicks);
+	}
+
+	SHA256_CTX Sha256Ctxt;
+	sha256_init(&Sha256Ctxt);
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		GenerateInput(Tick, NumCharacters, &Prng);
+		if(pRecord)
+			for(int i = 0; i < NumCharacters; i++)
+				pRecord->m_vInputs.push_back(m_aCores[i].m_Input);
+		DoTick(NumCharacters);
+		HashCores(&Sha256Ctxt, m_aCores, NumCharacters);
+	}
+	return sha256_finish(&Sha256Ctxt);
+}
+
+SHA256_DIGEST CGamecoreReplay::Replay(const CInputStream &Stream, int PerSpawn)
+{
+	Spawn(Stream.m_NumCharacters, PerSpawn);
+
+	SHA256_CTX Sha256Ctxt;
+	sha256_init(&Sha256Ctxt);
+	for(int Tick = 0; Tick < Stream.NumTicks(); Tick++)
+	{
+		const CNetObj_PlayerInput *pInputs = Stream.Tick(Tick);
+		for(int i = 0; i < Stream.m_NumCharacters; i++)
+			m_aCores[i].m_Input = pInputs[i];
+		DoTick(Stream.m_NumCharacters);
+		HashCores(&Sha256Ctxt, m_aCores, Stream.m_NumCharacters);
+	}
+	return sha256_finish(&Sha256Ctxt);
+}
+
+SHA256_DIGEST CGamecoreReplay::CollisionRays(int NumRays)
+{
+	SHA256_CTX Sha256Ctxt;
+	sha256_init(&Sha256Ctxt);
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	const float Width = m_Collision.GetWidth() * 32.0f;
+	const float Height = m_Collision.GetHeight() * 32.0f;
+	for(int i = 0; i < NumRays; i++)
+	{
+		vec2 From = vec2(Prng.RandomBits() % 32768 / 32768.0f * Width, Prng.RandomBits() % 32768 / 32768.0f * Height);
+		vec2 To = From + vec2((int)(Prng.RandomBits() % 1601) - 800, (int)(Prng.RandomBits() % 1601) - 800);
+
+		vec2 aOut[2];
+		int TeleNr = 0;
+		int aResults[4];
+		aResults[0] = m_Collision.IntersectLine(From, To, &aOut[0], &aOut[1]);
+		sha256_update(&Sha256Ctxt, aOut, sizeof(aOut));
+		aResults[1] = m_Collision.IntersectLineTeleHook(From, To, &aOut[0], &aOut[1], &TeleNr);
+		sha256_update(&Sha256Ctxt, aOut, sizeof(aOut));
+		aResults[2] = TeleNr;
+		aResults[3] = m_Collision.TestBox(From, vec2(28.0f, 28.0f));
+
+		vec2 Pos = From;
+		vec2 Vel = (To - From) / 16.0f;
+		m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), 0.0f);
+		sha256_update(&Sha256Ctxt, aResults, sizeof(aResults));
+		sha256_update(&Sha256Ctxt, &Pos, sizeof(Pos));
+		sha256_update(&Sha256Ctxt, &Vel, sizeof(Vel));
+	}
+	return sha256_finish(&Sha256Ctxt);
+}
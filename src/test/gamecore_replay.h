@@ -0,0 +1,66 @@
+#ifndef TEST_GAMECORE_REPLAY_H
+#define TEST_GAMECORE_REPLAY_H
+
+#include <base/hash.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+
+#include <vector>
+
+class CPrng;
+class IEngineMap;
+class IKernel;
+class IStorage;
+
+// player inputs of a number of characters, one per character and tick
+class CInputStream
+{
+public:
+	int m_NumCharacters;
+	std::vector<CNetObj_PlayerInput> m_vInputs;
+
+	CInputStream() :
+		m_NumCharacters(0) {}
+
+	int NumTicks() const { return m_NumCharacters ? m_vInputs.size() / m_NumCharacters : 0; }
+	const CNetObj_PlayerInput *Tick(int Tick) const { return &m_vInputs[Tick * m_NumCharacters]; }
+
+	bool Save(IStorage *pStorage, const char *pFilename) const;
+	bool Load(IStorage *pStorage, const char *pFilename);
+};
+
+// runs characters on a map without a server, hashing every state on the way
+class CGamecoreReplay
+{
+	IKernel *m_pKernel;
+	IEngineMap *m_pMap;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CTeamsCore m_Teams;
+	CWorldCore m_World;
+	CCharacterCore m_aCores[MAX_CLIENTS];
+	std::vector<vec2> m_vSpawns;
+
+	void Spawn(int NumCharacters, int PerSpawn);
+	void GenerateInput(int Tick, int NumCharacters, CPrng *pPrng);
+	void DoTick(int NumCharacters);
+
+public:
+	CGamecoreReplay();
+	~CGamecoreReplay();
+
+	bool Load(const char *pMapName);
+	const CCharacterCore *Core(int ClientID) const { return &m_aCores[ClientID]; }
+	CCollision *Collision() { return &m_Collision; }
+	void SetCulling(bool Cull) { m_World.m_Cull = Cull; }
+
+	// drives the characters with seeded input aiming at each other, optionally recording it
+	SHA256_DIGEST Run(int NumCharacters, int PerSpawn, int NumTicks, CInputStream *pRecord = nullptr);
+	SHA256_DIGEST Replay(const CInputStream &Stream, int PerSpawn);
+
+	// casts seeded rays over the whole map through the collision queries
+	SHA256_DIGEST CollisionRays(int NumRays);
+};
+
+#endif // TEST_GAMECORE_REPLAY_H
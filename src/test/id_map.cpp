@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <engine/server/id_map.h>
+
+TEST(IdMap, Translate)
+{
+	CIdMap Map;
+	int Target = 3;
+	EXPECT_FALSE(Map.Translate(Target));
+
+	Map.Map()[0] = 40;
+	Map.Map()[5] = 3;
+	Map.UpdateReverse();
+
+	Target = 3;
+	EXPECT_TRUE(Map.Translate(Target));
+	EXPECT_EQ(Target, 5);
+	Target = 40;
+	EXPECT_TRUE(Map.Translate(Target));
+	EXPECT_EQ(Target, 0);
+	Target = 7;
+	EXPECT_FALSE(Map.Translate(Target));
+	Target = -1;
+	EXPECT_FALSE(Map.Translate(Target));
+	Target = MAX_CLIENTS;
+	EXPECT_FALSE(Map.Translate(Target));
+
+	Target = 5;
+	EXPECT_TRUE(Map.ReverseTranslate(Target));
+	EXPECT_EQ(Target, 3);
+	Target = 1;
+	EXPECT_FALSE(Map.ReverseTranslate(Target));
+	// out of range slots are clamped
+	Target = -10;
+	EXPECT_TRUE(Map.ReverseTranslate(Target));
+	EXPECT_EQ(Target, 40);
+
+	// a client that moved to another slot is only found there
+	Map.Map()[5] = -1;
+	Map.Map()[9] = 3;
+	Map.UpdateReverse();
+	Target = 3;
+	EXPECT_TRUE(Map.Translate(Target));
+	EXPECT_EQ(Target, 9);
+}
+
+TEST(IdMap, NoTranslation)
+{
+	CIdMap Map;
+	EXPECT_TRUE(Map.NeedsTranslation());
+	Map.SetNoTranslation(true);
+	EXPECT_FALSE(Map.NeedsTranslation());
+
+	int Target = 50;
+	EXPECT_TRUE(Map.Translate(Target));
+	EXPECT_EQ(Target, 50);
+	EXPECT_TRUE(Map.ReverseTranslate(Target));
+	EXPECT_EQ(Target, 50);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+
+#include <csignal>
+#include <string>
+#include <vector>
+
+// collects the lines of these tests, the logger stays registered for the
+// rest of the test run
+static struct CCapture
+{
+	LOCK m_Lock;
+	std::vector<std::string> m_vLines;
+	SEMAPHORE m_Blocked;
+	SEMAPHORE m_Release;
+} *s_pCapture = nullptr;
+
+static void CaptureLine(const char *pLine, void *pUser)
+{
+	CCapture *pCapture = (CCapture *)pUser;
+	if(str_find(pLine, "[logger_block]"))
+	{
+		sphore_signal(&pCapture->m_Blocked);
+		sphore_wait(&pCapture->m_Release);
+		return;
+	}
+	if(!str_find(pLine, "[logger_test]") && !str_find(pLine, "[dbg/logger]"))
+		return;
+	lock_wait(pCapture->m_Lock);
+	pCapture->m_vLines.push_back(pLine);
+	lock_unlock(pCapture->m_Lock);
+}
+
+static CCapture *Capture()
+{
+	if(!s_pCapture)
+	{
+		s_pCapture = new CCapture;
+		s_pCapture->m_Lock = lock_create();
+		sphore_init(&s_pCapture->m_Blocked);
+		sphore_init(&s_pCapture->m_Release);
+		dbg_logger(CaptureLine, 0, s_pCapture);
+	}
+	lock_wait(s_pCapture->m_Lock);
+	s_pCapture->m_vLines.clear();
+	lock_unlock(s_pCapture->m_Lock);
+	return s_pCapture;
+}
+
+static void LogThread(void *pUser)
+{
+	int Thread = *(int *)pUser;
+	for(int i = 0; i < 300; i++)
+		dbg_msg("logger_test", "thread=%d msg=%d", Thread, i);
+}
+
+TEST(Logger, Order)
+{
+	CCapture *pCapture = Capture();
+	int aThreads[4];
+	void *apThreads[4];
+	for(int i = 0; i < 4; i++)
+	{
+		aThreads[i] = i;
+		apThreads[i] = thread_init(LogThread, &aThreads[i], "logger test");
+	}
+	for(auto *pThread : apThreads)
+		thread_wait(pThread);
+	dbg_logger_flush();
+
+	int aNext[4] = {0};
+	for(const std::string &Line : pCapture->m_vLines)
+	{
+		int Thread, Msg;
+		const char *pMsg = str_find(Line.c_str(), "thread=");
+		ASSERT_TRUE(pMsg) << Line;
+		ASSERT_EQ(sscanf(pMsg, "thread=%d msg=%d", &Thread, &Msg), 2);
+		ASSERT_TRUE(Thread >= 0 && Thread < 4);
+		EXPECT_EQ(Msg, aNext[Thread]);
+		aNext[Thread] = Msg + 1;
+	}
+	for(int Next : aNext)
+		EXPECT_EQ(Next, 300);
+}
+
+TEST(Logger, DropOldest)
+{
+	CCapture *pCapture = Capture();
+
+	// keep the logger thread busy while the queue overflows
+	dbg_msg("logger_block", "block");
+	sphore_wait(&pCapture->m_Blocked);
+	char aText[101];
+	mem_zero(aText, sizeof(aText));
+	for(int i = 0; i < 100; i++)
+		aText[i] = 'a' + i % 26;
+	int64 Start = time_get_impl();
+	const int NUM_MESSAGES = 2000;
+	for(int i = 0; i < NUM_MESSAGES; i++)
+		dbg_msg("logger_test", "msg=%d %s", i, aText);
+	int64 Time = time_get_impl() - Start;
+	sphore_signal(&pCapture->m_Release);
+	dbg_logger_flush();
+
+	// the newest messages survive, the notice tells how many went missing
+	ASSERT_GE(pCapture->m_vLines.size(), 2u);
+	int Dropped;
+	const char *pNotice = str_find(pCapture->m_vLines[0].c_str(), "dropped ");
+	ASSERT_TRUE(pNotice) << pCapture->m_vLines[0];
+	ASSERT_EQ(sscanf(pNotice, "dropped %d messages", &Dropped), 1);
+	EXPECT_GT(Dropped, 0);
+	EXPECT_EQ(Dropped + (int)pCapture->m_vLines.size() - 1, NUM_MESSAGES);
+	for(unsigned i = 1; i < pCapture->m_vLines.size(); i++)
+	{
+		int Msg;
+		const char *pMsg = str_find(pCapture->m_vLines[i].c_str(), "msg=");
+		ASSERT_TRUE(pMsg);
+		ASSERT_EQ(sscanf(pMsg, "msg=%d", &Msg), 1);
+		EXPECT_EQ(Msg, Dropped + (int)i - 1);
+	}
+
+	// a full queue doesn't make the caller wait
+	EXPECT_LT(Time, time_freq());
+}
+
+#if defined(CONF_FAMILY_UNIX) && GTEST_HAS_DEATH_TEST
+static void StderrLine(const char *pLine, void *pUser)
+{
+	if(str_find(pLine, "[logger_crash]"))
+		fprintf(stderr, "%s\n", pLine);
+}
+
+TEST(LoggerDeathTest, FlushOnCrash)
+{
+	static bool s_Registered = false;
+	if(!s_Registered)
+	{
+		dbg_logger(StderrLine, 0, 0);
+		s_Registered = true;
+	}
+	dbg_logger_flush();
+
+	// the forked child has no logger thread, only the crash handler can
+	// write the line
+	EXPECT_DEATH(
+		{
+			dbg_msg("logger_crash", "last words");
+			raise(SIGSEGV);
+		},
+		"\\[logger_crash\\]: last words");
+}
+#endif
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/server/map_download.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/storage.h>
+
+#include <memory>
+#include <queue>
+#include <vector>
+
+static std::vector<unsigned char> TestData(int Size)
+{
+	std::vector<unsigned char> vData(Size);
+	for(int i = 0; i < Size; i++)
+		vData[i] = (i * 7) ^ (i >> 9);
+	return vData;
+}
+
+TEST(MapDownload, Chunks)
+{
+	for(int Size : {1, 1000, CMapChunks::CHUNK_SIZE * 3, 100000})
+	{
+		std::vector<unsigned char> vMap = TestData(Size);
+		for(int Sixup = 0; Sixup < 2; Sixup++)
+		{
+			CMapChunks Chunks;
+			Chunks.Init(vMap.data(), vMap.size(), 0x12345678, Sixup);
+			ASSERT_EQ(Chunks.NumChunks(), (Size + CMapChunks::CHUNK_SIZE - 1) / CMapChunks::CHUNK_SIZE);
+
+			std::vector<unsigned char> vReceived;
+			for(int Chunk = 0; Chunk < Chunks.NumChunks(); Chunk++)
+			{
+				// packing a single chunk gives the same message
+				CPacker Packer;
+				CMapChunks::Pack(&Packer, vMap.data(), vMap.size(), 0x12345678, Chunk, Sixup);
+				ASSERT_EQ(Packer.Size(), Chunks.Size(Chunk));
+				EXPECT_EQ(mem_comp(Packer.Data(), Chunks.Data(Chunk), Packer.Size()), 0);
+
+				CUnpacker Unpacker;
+				Unpacker.Reset(Chunks.Data(Chunk), Chunks.Size(Chunk));
+				EXPECT_EQ(Unpacker.GetInt(), (NETMSG_MAP_DATA << 1) | 1);
+				int ChunkSize = minimum((int)CMapChunks::CHUNK_SIZE, Size - Chunk * CMapChunks::CHUNK_SIZE);
+				if(!Sixup)
+				{
+					EXPECT_EQ(Unpacker.GetInt(), Chunk == Chunks.NumChunks() - 1);
+					EXPECT_EQ((unsigned)Unpacker.GetInt(), 0x12345678u);
+					EXPECT_EQ(Unpacker.GetInt(), Chunk);
+					EXPECT_EQ(Unpacker.GetInt(), ChunkSize);
+				}
+				const unsigned char *pData = Unpacker.GetRaw(ChunkSize);
+				ASSERT_FALSE(Unpacker.Error());
+				vReceived.insert(vReceived.end(), pData, pData + ChunkSize);
+			}
+			EXPECT_EQ(vReceived, vMap);
+		}
+	}
+}
+
+// a link with a fixed round trip time that can deliver a number of chunks
+// per second, the chunks queue up in front of it
+struct CLinkEvent
+{
+	int64 m_Time;
+	int m_Chunk;
+	// earliest first, the link keeps the order
+	bool operator<(const CLinkEvent &Other) const { return m_Time > Other.m_Time || (m_Time == Other.m_Time && m_Chunk > Other.m_Chunk); }
+};
+
+static void Simulate(CMapDownload *pDownload, int NumChunks, int64 BaseRtt, int64 ChunkTime, int64 *pMaxRtt, int *pMaxWindow)
+{
+	std::priority_queue<CLinkEvent> Arrivals; // chunks arriving at the client
+	std::priority_queue<CLinkEvent> Requests; // requests arriving at the server
+	int64 LinkFree = 0;
+	int Received = 0;
+	*pMaxRtt = 0;
+	*pMaxWindow = 0;
+	Requests.push({0, 0});
+	while(!Requests.empty() || !Arrivals.empty())
+	{
+		if(Arrivals.empty() || (!Requests.empty() && Requests.top().m_Time <= Arrivals.top().m_Time))
+		{
+			CLinkEvent Request = Requests.top();
+			Requests.pop();
+			int End = pDownload->OnRequest(Request.m_Chunk, NumChunks, Request.m_Time);
+			for(int Chunk = pDownload->Sent(); Chunk < End; Chunk++)
+			{
+				pDownload->OnSent(Chunk, Request.m_Time);
+				LinkFree = maximum(LinkFree, Request.m_Time) + ChunkTime;
+				Arrivals.push({LinkFree + BaseRtt / 2, Chunk});
+			}
+			*pMaxRtt = maximum(*pMaxRtt, pDownload->Rtt());
+			*pMaxWindow = maximum(*pMaxWindow, pDownload->Window());
+		}
+		else
+		{
+			CLinkEvent Arrival = Arrivals.top();
+			Arrivals.pop();
+			EXPECT_EQ(Arrival.m_Chunk, Received);
+			Received++;
+			if(Received < NumChunks)
+				Requests.push({Arrival.m_Time + BaseRtt / 2, Received});
+		}
+	}
+	EXPECT_EQ(Received, NumChunks);
+}
+
+TEST(MapDownload, Window)
+{
+	const int64 Freq = time_freq();
+	const int64 BaseRtt = Freq / 20;
+	CMapDownload Download;
+
+	// nothing queues up, the window opens all the way
+	int64 MaxRtt;
+	int MaxWindow;
+	Download.Reset(5);
+	Simulate(&Download, 1000, BaseRtt, 0, &MaxRtt, &MaxWindow);
+	EXPECT_EQ(Download.Window(), (int)CMapDownload::MAX_WINDOW);
+	EXPECT_EQ(Download.Rtt(), BaseRtt);
+
+	// a link that can take 10 chunks per round trip, the window stays
+	// around that instead of filling the queue
+	Download.Reset(5);
+	Simulate(&Download, 1000, BaseRtt, BaseRtt / 10, &MaxRtt, &MaxWindow);
+	EXPECT_LT(Download.Window(), (int)CMapDownload::MAX_WINDOW);
+	EXPECT_GT(Download.Window(), 5);
+	EXPECT_LT(MaxRtt, BaseRtt * 3);
+
+	// the fixed window of sixup clients is the lower bound
+	Download.Reset(8, 8);
+	Simulate(&Download, 1000, BaseRtt, BaseRtt / 2, &MaxRtt, &MaxWindow);
+	EXPECT_GE(Download.Window(), 8);
+}
+
+TEST(MapDownload, Concurrent)
+{
+	std::unique_ptr<IStorage> pStorage(CreateTempStorage("data"));
+	IOHANDLE File = pStorage->OpenFile("maps/mega_std_collection.map", IOFLAG_READ, IStorage::TYPE_ALL);
+	ASSERT_TRUE(File);
+	std::vector<unsigned char> vMap(io_length(File));
+	io_read(File, vMap.data(), vMap.size());
+	io_close(File);
+
+	const int NumClients = 64;
+	const unsigned Crc = 0xabcdef;
+	CMapChunks Chunks;
+	Chunks.Init(vMap.data(), vMap.size(), Crc, false);
+	int NumChunks = Chunks.NumChunks();
+	int64 MapBytes = 0;
+	for(int Chunk = 0; Chunk < NumChunks; Chunk++)
+		MapBytes += Chunks.Size(Chunk);
+
+	// every client gets every chunk exactly once, the windows are refilled
+	// on every request like with fast download
+	std::vector<CMapDownload> vDownloads(NumClients);
+	for(auto &Download : vDownloads)
+		Download.Reset(15);
+	std::vector<int64> vSentBytes(NumClients, 0);
+	int64 Now = 0;
+	for(bool Done = false; !Done; Now += time_freq() / 1000)
+	{
+		Done = true;
+		for(int i = 0; i < NumClients; i++)
+		{
+			CMapDownload &Download = vDownloads[i];
+			if(Download.Received() >= NumChunks)
+				continue;
+			Done = false;
+			int End = Download.OnRequest(Download.Sent() ? Download.Received() + 1 : 0, NumChunks, Now);
+			ASSERT_LE(End, NumChunks);
+			for(int Chunk = Download.Sent(); Chunk < End; Chunk++)
+			{
+				vSentBytes[i] += Chunks.Size(Chunk);
+				Download.OnSent(Chunk, Now);
+			}
+			if(Download.Sent() == NumChunks && Download.Received() == NumChunks - 1)
+				Download.OnRequest(NumChunks, NumChunks, Now);
+		}
+	}
+
+	for(int i = 0; i < NumClients; i++)
+	{
+		EXPECT_EQ(vDownloads[i].Received(), NumChunks);
+		EXPECT_EQ(vSentBytes[i], MapBytes);
+	}
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/engine.h>
+#include <engine/map.h>
+#include <engine/server/map_loader.h>
+#include <engine/storage.h>
+#include <game/layers.h>
+
+#include <memory>
+#include <vector>
+#include <zlib.h>
+
+static const char *TEST_MAP = "mega_std_collection";
+
+TEST(MapLoader, Load)
+{
+	std::unique_ptr<IStorage> pStorage(CreateTempStorage("data"));
+	CMapLoadJob Job(pStorage.get(), TEST_MAP, true);
+	IEngine::RunJobBlocking(&Job);
+	ASSERT_TRUE(Job.Success());
+	ASSERT_TRUE(Job.SixupLoaded());
+	EXPECT_GT(Job.SixupSize(), 0u);
+
+	// the single pass over the file hashes the same bytes that are read
+	IOHANDLE File = pStorage->OpenFile("maps/mega_std_collection.map", IOFLAG_READ, IStorage::TYPE_ALL);
+	ASSERT_TRUE(File);
+	unsigned Size = io_length(File);
+	std::unique_ptr<unsigned char[]> pData(new unsigned char[Size]);
+	ASSERT_EQ(io_read(File, pData.get(), Size), Size);
+	io_close(File);
+
+	IEngineMap *pMap = Job.Map();
+	ASSERT_EQ(pMap->FileSize(), Size);
+	EXPECT_EQ(mem_comp(pMap->FileData(), pData.get(), Size), 0);
+	EXPECT_TRUE(pMap->Sha256() == sha256(pData.get(), Size));
+	EXPECT_EQ(pMap->Crc(), crc32(0, pData.get(), Size));
+	EXPECT_EQ(pMap->MapSize(), (int)Size);
+
+	// downloads get their own copy of the file
+	unsigned char *pDownload = Job.ReleaseData();
+	ASSERT_TRUE(pDownload);
+	EXPECT_NE(pDownload, pMap->FileData());
+	EXPECT_EQ(mem_comp(pDownload, pData.get(), Size), 0);
+	free(pDownload);
+
+	CLayers Layers;
+	Layers.Init(pMap);
+	ASSERT_TRUE(Layers.GameLayer());
+	const CTile *pTiles = (const CTile *)pMap->GetData(Layers.GameLayer()->m_Data);
+	ASSERT_TRUE(pTiles);
+	EXPECT_EQ(pMap->GetDataSize(Layers.GameLayer()->m_Data), Layers.GameLayer()->m_Width * Layers.GameLayer()->m_Height * (int)sizeof(CTile));
+}
+
+TEST(MapLoader, Missing)
+{
+	std::unique_ptr<IStorage> pStorage(CreateTempStorage("data"));
+	CMapLoadJob Job(pStorage.get(), "does_not_exist", false);
+	IEngine::RunJobBlocking(&Job);
+	EXPECT_FALSE(Job.Success());
+	EXPECT_FALSE(Job.Map()->IsLoaded());
+}
+
+TEST(MapLoader, Swap)
+{
+	std::unique_ptr<IStorage> pStorage(CreateTempStorage("data"));
+	std::unique_ptr<IEngineMap> pCurrent(CreateEngineMap());
+	ASSERT_TRUE(pCurrent->Load(pStorage.get(), "maps7/mega_std_collection.map"));
+	SHA256_DIGEST OldSha256 = pCurrent->Sha256();
+	CLayers OldLayers;
+	OldLayers.Init(pCurrent.get());
+	ASSERT_TRUE(OldLayers.GameLayer());
+	int OldDataSize = pCurrent->GetDataSize(OldLayers.GameLayer()->m_Data);
+	const unsigned char *pOldTiles = (const unsigned char *)pCurrent->GetData(OldLayers.GameLayer()->m_Data);
+	ASSERT_TRUE(pOldTiles);
+	std::vector<unsigned char> vOldTiles(pOldTiles, pOldTiles + OldDataSize);
+
+	CMapLoadJob Job(pStorage.get(), TEST_MAP, false);
+	IEngine::RunJobBlocking(&Job);
+	ASSERT_TRUE(Job.Success());
+	SHA256_DIGEST NewSha256 = Job.Map()->Sha256();
+	ASSERT_FALSE(NewSha256 == OldSha256);
+
+	// the finished job doesn't touch the current map until the swap
+	EXPECT_TRUE(pCurrent->IsLoaded());
+	EXPECT_TRUE(pCurrent->Sha256() == OldSha256);
+	EXPECT_EQ(mem_comp(pOldTiles, vOldTiles.data(), OldDataSize), 0);
+
+	pCurrent->Swap(Job.Map());
+	EXPECT_TRUE(pCurrent->Sha256() == NewSha256);
+	CLayers Layers;
+	Layers.Init(pCurrent.get());
+	ASSERT_TRUE(Layers.GameLayer());
+	EXPECT_TRUE(pCurrent->GetData(Layers.GameLayer()->m_Data));
+
+	// the old map lives on in the job until it's destroyed
+	EXPECT_TRUE(Job.Map()->IsLoaded());
+	EXPECT_TRUE(Job.Map()->Sha256() == OldSha256);
+	EXPECT_EQ(mem_comp(pOldTiles, vOldTiles.data(), OldDataSize), 0);
+}
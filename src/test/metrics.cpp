@@ -0,0 +1,121 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/metrics.h>
+#include <engine/storage.h>
+
+#include <string>
+
+static CMetricCounter s_TestCounter("test_counter_total", "Counter of the metrics test");
+static CMetricGauge s_TestGauge("test_gauge", "Gauge of the metrics test");
+static const int64 s_aTestBounds[] = {10, 100, 1000};
+static CMetricHistogram s_TestHistogram("test_duration_seconds", "Histogram of the metrics test", s_aTestBounds, 3, 1000.0);
+
+static void AppendLine(const char *pLine, void *pUser)
+{
+	std::string *pOutput = (std::string *)pUser;
+	*pOutput += pLine;
+	*pOutput += "\n";
+}
+
+static std::string Exposition()
+{
+	std::string Output;
+	CMetricsWriter Writer(AppendLine, &Output);
+	CMetrics::Write(&Writer);
+	return Output;
+}
+
+static void CountThread(void *pUser)
+{
+	for(int i = 0; i < 10000; i++)
+		s_TestCounter.Add();
+}
+
+TEST(Metrics, CounterShards)
+{
+	uint64 Before = s_TestCounter.Value();
+	void *apThreads[4];
+	for(auto &pThread : apThreads)
+		pThread = thread_init(CountThread, nullptr, "metrics test");
+	for(auto &pThread : apThreads)
+		thread_wait(pThread);
+	s_TestCounter.Add(5);
+	EXPECT_EQ(s_TestCounter.Value() - Before, 40005u);
+}
+
+TEST(Metrics, Gauge)
+{
+	s_TestGauge.Set(7);
+	s_TestGauge.Add(-3);
+	EXPECT_EQ(s_TestGauge.Value(), 4);
+	EXPECT_NE(Exposition().find("# TYPE test_gauge gauge\ntest_gauge 4\n"), std::string::npos);
+}
+
+TEST(Metrics, Histogram)
+{
+	uint64 Before = s_TestHistogram.Count();
+	s_TestHistogram.Observe(5);
+	s_TestHistogram.Observe(10);
+	s_TestHistogram.Observe(500);
+	s_TestHistogram.Observe(5000);
+	EXPECT_EQ(s_TestHistogram.Count() - Before, 4u);
+
+	if(Before == 0)
+	{
+		std::string Output = Exposition();
+		EXPECT_NE(Output.find(
+				  "# TYPE test_duration_seconds histogram\n"
+				  "test_duration_seconds_bucket{le=\"0.01\"} 2\n"
+				  "test_duration_seconds_bucket{le=\"0.1\"} 2\n"
+				  "test_duration_seconds_bucket{le=\"1\"} 3\n"
+				  "test_duration_seconds_bucket{le=\"+Inf\"} 4\n"
+				  "test_duration_seconds_sum 5.515\n"
+				  "test_duration_seconds_count 4\n"),
+			std::string::npos);
+	}
+}
+
+static void CollectTest(CMetricsWriter *pWriter, void *pUser)
+{
+	pWriter->Header("test_collected", "Collected by the metrics test", "gauge");
+	pWriter->Sample("test_collected", "room=\"3\"", (int64)*(int *)pUser);
+}
+
+TEST(Metrics, Collector)
+{
+	int Value = 42;
+	CMetrics::AddCollector(CollectTest, &Value);
+	EXPECT_NE(Exposition().find("test_collected{room=\"3\"} 42\n"), std::string::npos);
+	CMetrics::RemoveCollector(CollectTest, &Value);
+	EXPECT_EQ(Exposition().find("test_collected"), std::string::npos);
+}
+
+TEST(Metrics, Dump)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	s_TestGauge.Set(123);
+	ASSERT_TRUE(CMetrics::Dump(pStorage, Info.m_aFilename));
+	// a second dump has to replace the first one
+	s_TestGauge.Set(456);
+	ASSERT_TRUE(CMetrics::Dump(pStorage, Info.m_aFilename));
+
+	IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	std::string Content(io_length(File), '\0');
+	io_read(File, &Content[0], Content.size());
+	io_close(File);
+	EXPECT_NE(Content.find("test_gauge 456\n"), std::string::npos);
+	EXPECT_EQ(Content.find("test_gauge 123\n"), std::string::npos);
+	EXPECT_NE(Content.find("# TYPE ddnet_packets_in_total counter\n"), std::string::npos);
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+
+	delete pStorage;
+}
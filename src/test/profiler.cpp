@@ -0,0 +1,82 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/json.h>
+#include <engine/shared/profiler.h>
+#include <engine/storage.h>
+
+#include <vector>
+
+static void ProfileThread(void *pUser)
+{
+	PROFILE_SCOPE("thread");
+}
+
+TEST(Profiler, ChromeTrace)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	{
+		PROFILE_SCOPE("disabled");
+	}
+
+	CProfiler::Start();
+	{
+		PROFILE_SCOPE("outer");
+		for(int i = 0; i < 3; i++)
+		{
+			PROFILE_SCOPE("inner \"quoted\"", i);
+		}
+	}
+	void *pThread = thread_init(ProfileThread, nullptr, "profiler test");
+	thread_wait(pThread);
+	CProfiler::Stop();
+	{
+		PROFILE_SCOPE("stopped");
+	}
+
+	ASSERT_EQ(CProfiler::Dump(pStorage, Info.m_aFilename), 5);
+
+	IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	std::vector<char> vData(io_length(File));
+	io_read(File, vData.data(), vData.size());
+	io_close(File);
+
+	json_value *pJson = json_parse(vData.data(), vData.size());
+	ASSERT_TRUE(pJson);
+	const json_value &Events = (*pJson)["traceEvents"];
+	ASSERT_EQ(json_array_length(&Events), 5);
+
+	int NumInner = 0;
+	int64 OuterTid = -1;
+	int64 ThreadTid = -1;
+	for(int i = 0; i < json_array_length(&Events); i++)
+	{
+		const json_value &Event = Events[i];
+		EXPECT_STREQ(json_string_get(&Event["ph"]), "X");
+		const char *pName = json_string_get(&Event["name"]);
+		if(str_comp(pName, "inner \"quoted\"") == 0)
+		{
+			EXPECT_EQ(json_int_get(&Event["args"]["arg"]), NumInner);
+			NumInner++;
+		}
+		else if(str_comp(pName, "outer") == 0)
+			OuterTid = json_int_get(&Event["tid"]);
+		else if(str_comp(pName, "thread") == 0)
+			ThreadTid = json_int_get(&Event["tid"]);
+		else
+			ADD_FAILURE() << "unexpected event " << pName;
+	}
+	EXPECT_EQ(NumInner, 3);
+	EXPECT_NE(OuterTid, -1);
+	EXPECT_NE(ThreadTid, -1);
+	EXPECT_NE(OuterTid, ThreadTid);
+	json_value_free(pJson);
+
+	if(!HasFailure())
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	delete pStorage;
+}
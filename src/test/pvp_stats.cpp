@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+#include <engine/server/databases/pvp_stats.h>
+
+#include <string>
+#include <vector>
+
+struct CStatsResult : ISqlResult
+{
+	std::vector<std::string> m_vRows;
+};
+
+struct CStatsQuery : ISqlData
+{
+	CStatsQuery(std::shared_ptr<ISqlResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+};
+
+// runs on the write worker, its in-memory database is the one holding the stats
+static bool ReadStats(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	CStatsResult *pResult = dynamic_cast<CStatsResult *>(pGameData->m_pResult.get());
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, Mode, Kills, Deaths, Captures, Wins, Matches FROM %s_pvp_stats ORDER BY Name, Mode",
+		pSqlServer->GetPrefix());
+	if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+		return true;
+
+	bool End;
+	while(!pSqlServer->Step(&End, pError, ErrorSize) && !End)
+	{
+		char aName[MAX_NAME_LENGTH];
+		char aMode[32];
+		pSqlServer->GetString(1, aName, sizeof(aName));
+		pSqlServer->GetString(2, aMode, sizeof(aMode));
+		str_format(aBuf, sizeof(aBuf), "%s %s %d %d %d %d %d", aName, aMode,
+			pSqlServer->GetInt(3), pSqlServer->GetInt(4), pSqlServer->GetInt(5), pSqlServer->GetInt(6), pSqlServer->GetInt(7));
+		pResult->m_vRows.push_back(aBuf);
+	}
+	return !End;
+}
+
+static std::vector<std::string> QueryStats(CDbConnectionPool *pPool)
+{
+	std::shared_ptr<CStatsResult> pResult(new CStatsResult());
+	EXPECT_TRUE(pPool->ExecuteWrite(ReadStats, std::unique_ptr<const ISqlData>(new CStatsQuery(pResult)), "read pvp stats"));
+	while(!pResult->m_Completed.load())
+		thread_sleep(1000);
+	EXPECT_TRUE(pResult->m_Success);
+	return pResult->m_vRows;
+}
+
+TEST(PvpStats, Coalesce)
+{
+	CDbConnectionPool Pool;
+	Pool.RegisterDatabase(std::unique_ptr<IDbConnection>(CreateSqliteConnection(":memory:", true)), CDbConnectionPool::WRITE);
+	Pool.Start(1, 1, 64);
+
+	CPvpStatsWriter Writer(&Pool);
+	for(int i = 0; i < 3; i++)
+		Writer.Add(0, "nameless tee", "CTF", PVPSTAT_KILLS);
+	Writer.Add(1, "nameless tee", "CTF", PVPSTAT_DEATHS, 2);
+	Writer.Add(1, "nameless tee", "DM", PVPSTAT_KILLS);
+	Writer.Add(0, "brainless tee", "CTF", PVPSTAT_CAPTURES);
+	// out of range stats and rooms are ignored
+	Writer.Add(0, "brainless tee", "CTF", NUM_PVPSTATS);
+	Writer.Add(-1, "brainless tee", "CTF", PVPSTAT_KILLS);
+
+	// the end of a match in one room only writes that room
+	Writer.FlushRoom(0);
+	EXPECT_EQ(Writer.NumPendingRows(), 0);
+	std::vector<std::string> vExpected = {
+		"brainless tee CTF 0 0 1 0 0",
+		"nameless tee CTF 3 0 0 0 0",
+	};
+	EXPECT_EQ(QueryStats(&Pool), vExpected);
+
+	Writer.Add(0, "nameless tee", "CTF", PVPSTAT_WINS);
+	Writer.Add(0, "nameless tee", "CTF", PVPSTAT_MATCHES);
+	Writer.Flush();
+	vExpected = {
+		"brainless tee CTF 0 0 1 0 0",
+		"nameless tee CTF 3 2 0 1 1",
+		"nameless tee DM 1 0 0 0 0",
+	};
+	EXPECT_EQ(QueryStats(&Pool), vExpected);
+
+	// nothing left to write
+	Writer.Flush(true);
+	EXPECT_EQ(QueryStats(&Pool), vExpected);
+	Pool.OnShutdown();
+
+	// rows the pool doesn't take are kept for later, except on shutdown
+	Writer.Add(0, "nameless tee", "CTF", PVPSTAT_KILLS);
+	Writer.Flush();
+	EXPECT_EQ(Writer.NumPendingRows(), 1);
+	Writer.Flush(true);
+	EXPECT_EQ(Writer.NumPendingRows(), 0);
+}
+
+TEST(PvpStats, Chunks)
+{
+	std::unique_ptr<IDbConnection> pConnection(CreateSqliteConnection(":memory:", true));
+	char aError[256] = "";
+	ASSERT_FALSE(pConnection->Connect(aError, sizeof(aError))) << aError;
+
+	// more rows than fit into a single statement
+	const int NumRows = PVPSTATS_ROWS_PER_STATEMENT * 2 + 3;
+	std::vector<CPvpStatsRow> vRows(NumRows);
+	for(int i = 0; i < NumRows; i++)
+	{
+		str_format(vRows[i].m_aName, sizeof(vRows[i].m_aName), "player %d", i);
+		str_copy(vRows[i].m_aMode, "TDM", sizeof(vRows[i].m_aMode));
+		for(int Stat = 0; Stat < NUM_PVPSTATS; Stat++)
+			vRows[i].m_aValues[Stat] = i + Stat;
+	}
+	ASSERT_FALSE(pConnection->AddPvpStats(vRows.data(), NumRows, aError, sizeof(aError))) << aError;
+	ASSERT_FALSE(pConnection->AddPvpStats(vRows.data(), NumRows, aError, sizeof(aError))) << aError;
+
+	ASSERT_FALSE(pConnection->PrepareStatement("SELECT COUNT(*), SUM(Kills), SUM(Matches) FROM record_pvp_stats", aError, sizeof(aError))) << aError;
+	bool End;
+	ASSERT_FALSE(pConnection->Step(&End, aError, sizeof(aError))) << aError;
+	ASSERT_FALSE(End);
+	EXPECT_EQ(pConnection->GetInt(1), NumRows);
+	EXPECT_EQ(pConnection->GetInt(2), NumRows * (NumRows - 1));
+	EXPECT_EQ(pConnection->GetInt(3), NumRows * (NumRows - 1) + 2 * NumRows * PVPSTAT_MATCHES);
+	pConnection->Disconnect();
+}
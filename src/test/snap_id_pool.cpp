@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/snap_id_pool.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+TEST(SnapIDPool, Timeout)
+{
+	std::unique_ptr<CSnapIDPool> pPool(new CSnapIDPool());
+
+	int ID = pPool->NewID();
+	EXPECT_EQ(pPool->Stats().m_Allocated, 1);
+	pPool->FreeID(ID);
+	pPool->Update();
+	EXPECT_EQ(pPool->Stats().m_Allocated, 0);
+	EXPECT_EQ(pPool->Stats().m_Timed, 1);
+
+	// freed ids are not handed out again before their timeout
+	for(int i = 0; i < 100; i++)
+		EXPECT_NE(pPool->NewID(), ID);
+
+	pPool->TimeoutIDs();
+	CSnapIDPool::CStats Stats = pPool->Stats();
+	EXPECT_EQ(Stats.m_Allocated, 100);
+	EXPECT_EQ(Stats.m_Timed, 0);
+	EXPECT_EQ(Stats.m_Free, CSnapIDPool::MAX_IDS - 100);
+	EXPECT_EQ(Stats.m_PeakAllocated, 100);
+	EXPECT_EQ(Stats.m_Failed, 0);
+	EXPECT_EQ(pPool->NewID(), ID);
+}
+
+static const int NUM_THREADS = 4;
+static const int NUM_ROUNDS = 200;
+static const int IDS_PER_ROUND = 16;
+
+struct CThreadData
+{
+	CSnapIDPool *m_pPool;
+	std::vector<int> m_vKept;
+};
+
+static void AllocateThread(void *pUser)
+{
+	CThreadData *pData = (CThreadData *)pUser;
+	for(int Round = 0; Round < NUM_ROUNDS; Round++)
+	{
+		int aIDs[IDS_PER_ROUND];
+		for(int &ID : aIDs)
+			ID = pData->m_pPool->NewID();
+		for(int i = 0; i < IDS_PER_ROUND; i++)
+		{
+			if(i % 4 == 0)
+				pData->m_vKept.push_back(aIDs[i]);
+			else
+				pData->m_pPool->FreeID(aIDs[i]);
+		}
+	}
+}
+
+TEST(SnapIDPool, Threads)
+{
+	std::unique_ptr<CSnapIDPool> pPool(new CSnapIDPool());
+
+	CThreadData aData[NUM_THREADS];
+	void *apThreads[NUM_THREADS];
+	for(int i = 0; i < NUM_THREADS; i++)
+	{
+		aData[i].m_pPool = pPool.get();
+		apThreads[i] = thread_init(AllocateThread, &aData[i], "snap id test");
+	}
+	for(int i = 0; i < 20; i++)
+	{
+		pPool->Update();
+		thread_yield();
+	}
+	for(auto *pThread : apThreads)
+		thread_wait(pThread);
+	pPool->Update();
+
+	// every kept id was handed out exactly once
+	std::vector<int> vKept;
+	for(auto &Data : aData)
+		vKept.insert(vKept.end(), Data.m_vKept.begin(), Data.m_vKept.end());
+	std::sort(vKept.begin(), vKept.end());
+	EXPECT_TRUE(std::adjacent_find(vKept.begin(), vKept.end()) == vKept.end());
+
+	const int NumKept = NUM_THREADS * NUM_ROUNDS * IDS_PER_ROUND / 4;
+	CSnapIDPool::CStats Stats = pPool->Stats();
+	EXPECT_EQ((int)vKept.size(), NumKept);
+	EXPECT_EQ(Stats.m_Allocated, NumKept);
+	EXPECT_EQ(Stats.m_Timed, NUM_THREADS * NUM_ROUNDS * IDS_PER_ROUND - NumKept);
+	EXPECT_EQ(Stats.m_Failed, 0);
+
+	pPool->TimeoutIDs();
+	EXPECT_EQ(pPool->Stats().m_Free, CSnapIDPool::MAX_IDS - NumKept);
+}
@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot.h>
+#include <engine/shared/uuid_manager.h>
+#include <game/generated/protocol.h>
+#include <game/prng.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static int BuildSnapshot(CSnapshot *pSnap, int Value, bool WithSecond)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(int i = 0; i < 3; i++)
+	{
+		int *pItem = (int *)Builder.NewItem(1, i, 3 * sizeof(int));
+		pItem[0] = Value;
+		pItem[1] = i * 1000;
+		pItem[2] = -i;
+	}
+	if(WithSecond)
+	{
+		int *pItem = (int *)Builder.NewItem(2, 0, 2 * sizeof(int));
+		pItem[0] = 12345678;
+		pItem[1] = 7;
+	}
+	return Builder.Finish(pSnap);
+}
+
+static int CompressedSize(const void *pDelta, int DeltaSize)
+{
+	char aCompressed[CSnapshot::MAX_SIZE * 2];
+	return CVariableInt::Compress(pDelta, DeltaSize, aCompressed, sizeof(aCompressed));
+}
+
+TEST(Snapshot, DataRateAccounting)
+{
+	std::unique_ptr<CSnapshotDelta> pDelta(new CSnapshotDelta());
+	alignas(int) static char s_aFrom[CSnapshot::MAX_SIZE];
+	alignas(int) static char s_aTo[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)s_aFrom;
+	CSnapshot *pTo = (CSnapshot *)s_aTo;
+	BuildSnapshot(pFrom, 1, true);
+	BuildSnapshot(pTo, 2, false);
+
+	char aPlain[CSnapshot::MAX_SIZE];
+	char aAccounted[CSnapshot::MAX_SIZE];
+	int PlainSize = pDelta->CreateDelta(pFrom, pTo, aPlain);
+	for(int Type = 0; Type < 4; Type++)
+		EXPECT_EQ(pDelta->GetDataRate(Type), 0);
+
+	pDelta->SetDataRateAccounting(true);
+	int AccountedSize = pDelta->CreateDelta(pFrom, pTo, aAccounted);
+	pDelta->SetDataRateAccounting(false);
+
+	// accounting must not change the delta
+	ASSERT_EQ(PlainSize, AccountedSize);
+	EXPECT_EQ(mem_comp(aPlain, aAccounted, PlainSize), 0);
+
+	// all three items of type 1 changed, the type 2 item got deleted
+	EXPECT_EQ(pDelta->GetDataUpdates(1), 3);
+	EXPECT_EQ(pDelta->GetDataUpdates(2), 0);
+	EXPECT_GT(pDelta->GetDataRate(2), 0);
+
+	// the items make up everything but the three header ints
+	int aHeader[3] = {1, 1, 0};
+	EXPECT_EQ((pDelta->GetDataRate(1) + pDelta->GetDataRate(2)) / 8 + CompressedSize(aHeader, sizeof(aHeader)), CompressedSize(aAccounted, AccountedSize));
+
+	// sixup types are kept apart
+	int Rate = pDelta->GetDataRate(1);
+	pDelta->SetDataRateAccounting(true, true);
+	pDelta->CreateDelta(pFrom, pTo, aAccounted);
+	pDelta->SetDataRateAccounting(false);
+	EXPECT_EQ(pDelta->GetDataRate(1), Rate);
+	EXPECT_EQ(pDelta->GetDataRate(CSnapshotDelta::DATARATE_SIXUP_OFFSET + 1), Rate);
+	EXPECT_EQ(pDelta->GetDataUpdates(CSnapshotDelta::DATARATE_SIXUP_OFFSET + 1), 3);
+
+	pDelta->ResetDataRate();
+	EXPECT_EQ(pDelta->GetDataRate(1), 0);
+	EXPECT_EQ(pDelta->GetDataUpdates(CSnapshotDelta::DATARATE_SIXUP_OFFSET + 1), 0);
+}
+
+TEST(Snapshot, DataRateUnchanged)
+{
+	std::unique_ptr<CSnapshotDelta> pDelta(new CSnapshotDelta());
+	alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+	BuildSnapshot(pSnap, 1, true);
+
+	char aDelta[CSnapshot::MAX_SIZE];
+	pDelta->SetDataRateAccounting(true);
+	EXPECT_EQ(pDelta->CreateDelta(pSnap, pSnap, aDelta), 0);
+	EXPECT_EQ(pDelta->GetDataRate(1), 0);
+	EXPECT_EQ(pDelta->GetDataUpdates(1), 0);
+}
+
+TEST(Snapshot, CopyItems)
+{
+	std::unique_ptr<CSnapshotBuilder> pFirst(new CSnapshotBuilder());
+	std::unique_ptr<CSnapshotBuilder> pSecond(new CSnapshotBuilder());
+	pFirst->Init(true);
+	pSecond->Init(true);
+
+	// per client items before the shared ones
+	*(int *)pFirst->NewItem(NETOBJTYPE_PLAYERINPUT, 0, sizeof(int)) = 1;
+	int FromItem = pFirst->NumItems();
+	for(int i = 0; i < 4; i++)
+	{
+		CNetObj_Laser *pLaser = (CNetObj_Laser *)pFirst->NewItem(NETOBJTYPE_LASER, 100 + i, sizeof(CNetObj_Laser));
+		pLaser->m_X = i * 32;
+		pLaser->m_Y = -i;
+		pLaser->m_FromX = pLaser->m_X;
+		pLaser->m_FromY = pLaser->m_Y;
+		pLaser->m_StartTick = 50;
+	}
+
+	CSnapshotItemCache Cache;
+	pFirst->CopyItems(FromItem, &Cache);
+	EXPECT_EQ(Cache.m_vOffsets.size(), 4u);
+	EXPECT_TRUE(pSecond->AddItems(Cache));
+	ASSERT_EQ(pSecond->NumItems(), 4);
+
+	for(int i = 0; i < 4; i++)
+	{
+		CSnapshotItem *pCopy = pSecond->GetItem(i);
+		CSnapshotItem *pOriginal = pFirst->GetItem(FromItem + i);
+		EXPECT_EQ(pCopy->Key(), pOriginal->Key());
+		EXPECT_EQ(mem_comp(pCopy->Data(), pOriginal->Data(), sizeof(CNetObj_Laser)), 0);
+	}
+}
+
+TEST(Snapshot, Budget)
+{
+	std::unique_ptr<CSnapshotBuilder> pBuilder(new CSnapshotBuilder());
+	pBuilder->Init();
+	// room for the header and four lasers
+	const int LaserSize = sizeof(CSnapshotItem) + sizeof(CNetObj_Laser);
+	pBuilder->SetBudget(sizeof(CSnapshot) + 4 * (sizeof(int) + LaserSize), 1024);
+
+	const int aPriorities[] = {5, 1, 3, 1, 4, 0, 2};
+	for(int i = 0; i < 7; i++)
+	{
+		pBuilder->SetPriority(aPriorities[i]);
+		CNetObj_Laser *pLaser = (CNetObj_Laser *)pBuilder->NewItem(NETOBJTYPE_LASER, i, sizeof(CNetObj_Laser));
+		if(aPriorities[i] == 0)
+		{
+			// nothing less important left to make room
+			EXPECT_FALSE(pLaser);
+			continue;
+		}
+		ASSERT_TRUE(pLaser);
+		pLaser->m_X = i;
+	}
+	EXPECT_EQ(pBuilder->NumDropped(), 3);
+
+	alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+	int Size = pBuilder->Finish(pSnap);
+	EXPECT_EQ(Size, (int)(sizeof(CSnapshot) + 4 * (sizeof(int) + LaserSize)));
+	ASSERT_EQ(pSnap->NumItems(), 4);
+	const int aKept[] = {0, 2, 4, 6};
+	for(int i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(pSnap->GetItem(i)->ID(), aKept[i]);
+		EXPECT_EQ(((CNetObj_Laser *)pSnap->GetItem(i)->Data())->m_X, aKept[i]);
+	}
+
+	// essential items are never dropped for the budget
+	pBuilder->SetPriority(CSnapshotBuilder::PRIORITY_ESSENTIAL);
+	EXPECT_TRUE(pBuilder->NewItem(NETOBJTYPE_LASER, 7, sizeof(CNetObj_Laser)));
+	CSnapshotItemCache Cache;
+	pBuilder->CopyItems(0, &Cache);
+	EXPECT_EQ(Cache.m_vOffsets.size(), 4u);
+}
+
+TEST(Snapshot, BudgetItems)
+{
+	std::unique_ptr<CSnapshotBuilder> pBuilder(new CSnapshotBuilder());
+	pBuilder->Init();
+	pBuilder->SetBudget(CSnapshot::MAX_SIZE, 2);
+	for(int i = 0; i < 3; i++)
+	{
+		pBuilder->SetPriority(i);
+		EXPECT_TRUE(pBuilder->NewItem(NETOBJTYPE_PICKUP, i, sizeof(CNetObj_Pickup)));
+	}
+	EXPECT_EQ(pBuilder->NumDropped(), 1);
+
+	alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+	pBuilder->Finish(pSnap);
+	ASSERT_EQ(pSnap->NumItems(), 2);
+	EXPECT_EQ(pSnap->GetItem(0)->ID(), 1);
+	EXPECT_EQ(pSnap->GetItem(1)->ID(), 2);
+}
+
+TEST(Snapshot, BudgetExtendedType)
+{
+	std::unique_ptr<CSnapshotBuilder> pBuilder(new CSnapshotBuilder());
+	pBuilder->Init();
+	const int PickupSize = sizeof(CSnapshotItem) + sizeof(CNetObj_Pickup);
+	const int CharacterSize = sizeof(CSnapshotItem) + sizeof(CNetObj_DDNetCharacter);
+	const int RegistrationSize = sizeof(CSnapshotItem) + sizeof(CUuid);
+	pBuilder->SetBudget(sizeof(CSnapshot) + 3 * sizeof(int) + RegistrationSize + CharacterSize + PickupSize, 1024);
+
+	// the type is registered in the middle of the snapshot by a low priority item
+	pBuilder->SetPriority(1);
+	ASSERT_TRUE(pBuilder->NewItem(NETOBJTYPE_DDNETCHARACTER, 0, sizeof(CNetObj_DDNetCharacter)));
+	pBuilder->SetPriority(2);
+	for(int i = 0; i < 3; i++)
+		EXPECT_EQ(pBuilder->NewItem(NETOBJTYPE_PICKUP, i, sizeof(CNetObj_Pickup)) != nullptr, i < 2);
+	EXPECT_EQ(pBuilder->NumDropped(), 2);
+
+	// the item went away for the budget, the registration stays
+	alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+	pBuilder->Finish(pSnap);
+	ASSERT_EQ(pSnap->NumItems(), 3);
+	EXPECT_EQ(pSnap->GetItem(0)->Type(), 0); // NETOBJTYPE_EX
+	EXPECT_EQ(pSnap->GetItem(1)->ID(), 0);
+	EXPECT_EQ(pSnap->GetItem(2)->ID(), 1);
+
+	// later snapshots get the registration from the start
+	pBuilder->Init();
+	EXPECT_EQ(pBuilder->NumItems(), 1);
+}
+
+TEST(Snapshot, BudgetDropOrder)
+{
+	// many drops remove the same items as always dropping the least
+	// important, latest one
+	std::unique_ptr<CSnapshotBuilder> pBuilder(new CSnapshotBuilder());
+	pBuilder->Init();
+	const int MaxItems = 100;
+	pBuilder->SetBudget(CSnapshot::MAX_SIZE, MaxItems);
+
+	std::vector<int> vPriorities;
+	std::vector<bool> vKept;
+	CPrng Prng;
+	uint64 aSeed[2] = {1, 1};
+	Prng.Seed(aSeed);
+	for(int i = 0; i < 1000; i++)
+	{
+		int Priority = Prng.RandomBits() % 20;
+		if(i % 50 == 0)
+			Priority = CSnapshotBuilder::PRIORITY_ESSENTIAL;
+		pBuilder->SetPriority(Priority);
+		bool Added = pBuilder->NewItem(NETOBJTYPE_PICKUP, i, sizeof(CNetObj_Pickup)) != nullptr;
+
+		// the same with a linear search
+		bool Expected = true;
+		if(std::count(vKept.begin(), vKept.end(), true) == MaxItems)
+		{
+			int Drop = -1;
+			for(int j = 0; j < i; j++)
+				if(vKept[j] && vPriorities[j] < Priority && (Drop < 0 || vPriorities[j] <= vPriorities[Drop]))
+					Drop = j;
+			if(Drop >= 0)
+				vKept[Drop] = false;
+			else
+				Expected = false;
+		}
+		vPriorities.push_back(Priority);
+		vKept.push_back(Expected);
+		EXPECT_EQ(Added, Expected) << "item " << i;
+	}
+
+	alignas(int) static char s_aSnap[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnap = (CSnapshot *)s_aSnap;
+	pBuilder->Finish(pSnap);
+	ASSERT_EQ(pSnap->NumItems(), MaxItems);
+	for(int i = 0, Item = 0; i < (int)vKept.size(); i++)
+	{
+		if(vKept[i])
+		{
+			EXPECT_EQ(pSnap->GetItem(Item++)->ID(), i);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+
+#include <memory>
+
+static int QueryInt(IDbConnection *pConnection, const char *pQuery, int Value)
+{
+	char aError[256] = "";
+	EXPECT_FALSE(pConnection->PrepareStatement(pQuery, aError, sizeof(aError))) << aError;
+	pConnection->BindInt(1, Value);
+	bool End;
+	EXPECT_FALSE(pConnection->Step(&End, aError, sizeof(aError))) << aError;
+	EXPECT_FALSE(End);
+	return pConnection->GetInt(1);
+}
+
+TEST(Sqlite, StatementCache)
+{
+	std::unique_ptr<IDbConnection> pConnection(CreateSqliteConnection(":memory:", false));
+	char aError[256] = "";
+	ASSERT_FALSE(pConnection->Connect(aError, sizeof(aError))) << aError;
+
+	int NumUpdated;
+	ASSERT_FALSE(pConnection->PrepareStatement("CREATE TABLE test (Value INTEGER)", aError, sizeof(aError))) << aError;
+	ASSERT_FALSE(pConnection->ExecuteUpdate(&NumUpdated, aError, sizeof(aError))) << aError;
+	for(int i = 0; i < 10; i++)
+	{
+		ASSERT_FALSE(pConnection->PrepareStatement("INSERT INTO test (Value) VALUES (?)", aError, sizeof(aError))) << aError;
+		pConnection->BindInt(1, i);
+		ASSERT_FALSE(pConnection->ExecuteUpdate(&NumUpdated, aError, sizeof(aError))) << aError;
+		EXPECT_EQ(NumUpdated, 1);
+	}
+
+	// a reused statement starts over, even if it wasn't stepped to the end
+	EXPECT_EQ(QueryInt(pConnection.get(), "SELECT Value FROM test WHERE Value >= ? ORDER BY Value", 3), 3);
+	EXPECT_EQ(QueryInt(pConnection.get(), "SELECT Value FROM test WHERE Value >= ? ORDER BY Value", 5), 5);
+	pConnection->Disconnect();
+
+	// more distinct statements than the cache holds, the evicted ones get
+	// prepared again
+	ASSERT_FALSE(pConnection->Connect(aError, sizeof(aError))) << aError;
+	for(int Round = 0; Round < 2; Round++)
+	{
+		for(int i = 0; i < 100; i++)
+		{
+			char aQuery[128];
+			str_format(aQuery, sizeof(aQuery), "SELECT COUNT(*) + %d FROM test WHERE Value < ?", i);
+			EXPECT_EQ(QueryInt(pConnection.get(), aQuery, 4), i + 4);
+		}
+	}
+	pConnection->Disconnect();
+
+	// the data survives the cached statements
+	ASSERT_FALSE(pConnection->Connect(aError, sizeof(aError))) << aError;
+	EXPECT_EQ(QueryInt(pConnection.get(), "SELECT COUNT(*) FROM test WHERE Value < ?", 100), 10);
+	EXPECT_FALSE(pConnection->IsRetryable());
+	pConnection->Disconnect();
+}
+
+TEST(Sqlite, Errors)
+{
+	std::unique_ptr<IDbConnection> pConnection(CreateSqliteConnection(":memory:", false));
+	char aError[256] = "";
+	ASSERT_FALSE(pConnection->Connect(aError, sizeof(aError))) << aError;
+
+	// failed statements aren't cached and don't leave a statement behind
+	EXPECT_TRUE(pConnection->PrepareStatement("SELECT * FROM missing", aError, sizeof(aError)));
+	EXPECT_FALSE(pConnection->IsRetryable());
+	EXPECT_TRUE(pConnection->PrepareStatement("SELECT * FROM missing", aError, sizeof(aError)));
+	EXPECT_EQ(QueryInt(pConnection.get(), "SELECT ? + 1", 1), 2);
+	pConnection->Disconnect();
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <game/teamscore.h>
+
+#include <vector>
+
+static std::vector<int> ToVector(CClientMask Mask)
+{
+	std::vector<int> vResult;
+	for(int i : Mask)
+		vResult.push_back(i);
+	return vResult;
+}
+
+TEST(TeamsCore, ClientMask)
+{
+	EXPECT_EQ(CClientMask(0).Count(), 0);
+	EXPECT_TRUE(ToVector(CClientMask(0)).empty());
+	EXPECT_EQ(ToVector(CClientMask(0x8000000000000005ULL)), std::vector<int>({0, 2, 63}));
+	EXPECT_EQ(CClientMask(0x8000000000000005ULL).Count(), 3);
+}
+
+TEST(TeamsCore, Members)
+{
+	CTeamsCore Teams;
+	EXPECT_EQ(Teams.Members(TEAM_FLOCK).Count(), 0);
+	EXPECT_EQ(Teams.OccupiedRooms().Count(), 0);
+
+	Teams.Join(3, TEAM_FLOCK);
+	Teams.Join(5, 2);
+	Teams.Join(MAX_CLIENTS - 1, 2);
+	EXPECT_EQ(ToVector(Teams.Members(TEAM_FLOCK)), std::vector<int>({3}));
+	EXPECT_EQ(ToVector(Teams.Members(2)), std::vector<int>({5, MAX_CLIENTS - 1}));
+	EXPECT_EQ(Teams.Count(2), 2);
+	EXPECT_EQ(ToVector(Teams.OccupiedRooms()), std::vector<int>({TEAM_FLOCK, 2}));
+
+	Teams.Team(5, TEAM_SUPER);
+	EXPECT_EQ(Teams.Team(5), TEAM_SUPER);
+	EXPECT_EQ(ToVector(Teams.Members(TEAM_SUPER)), std::vector<int>({5}));
+	EXPECT_EQ(Teams.Count(TEAM_SUPER), 1);
+	EXPECT_EQ(Teams.Count(2), 1);
+
+	Teams.Leave(MAX_CLIENTS - 1);
+	EXPECT_EQ(Teams.Count(2), 0);
+	EXPECT_EQ(Teams.Team(MAX_CLIENTS - 1), TEAM_FLOCK);
+	EXPECT_EQ(ToVector(Teams.OccupiedRooms()), std::vector<int>({TEAM_FLOCK}));
+
+	Teams.Reset();
+	EXPECT_EQ(Teams.Members(TEAM_FLOCK).Count(), 0);
+	EXPECT_EQ(Teams.Members(TEAM_SUPER).Count(), 0);
+	EXPECT_EQ(Teams.OccupiedRooms().Count(), 0);
+}